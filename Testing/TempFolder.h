@@ -0,0 +1,28 @@
+#ifndef D3PP_TESTING_TEMPFOLDER_H
+#define D3PP_TESTING_TEMPFOLDER_H
+#include <filesystem>
+#include <string>
+
+namespace D3PP::testing {
+    // -- An empty folder under the system temp directory, removed again when the test ends.
+    class TempFolder {
+    public:
+        explicit TempFolder(const std::string& name) {
+            Path = (std::filesystem::temp_directory_path() / name).string() + "/";
+            std::filesystem::remove_all(Path);
+            std::filesystem::create_directories(Path);
+        }
+
+        ~TempFolder() {
+            std::error_code ec;
+            std::filesystem::remove_all(Path, ec);
+        }
+
+        TempFolder(const TempFolder&) = delete;
+        TempFolder& operator=(const TempFolder&) = delete;
+
+        std::string Path;
+    };
+}
+
+#endif
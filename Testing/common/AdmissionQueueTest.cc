@@ -0,0 +1,55 @@
+#include <gtest/gtest.h>
+#include <vector>
+#include "common/AdmissionQueue.h"
+
+using namespace D3PP::Common;
+
+TEST(AdmissionQueue, QueuesBeyondLimit) {
+    AdmissionQueue underTest(2);
+    std::vector<AdmissionQueue::Ticket> held;
+    std::vector<int> started;
+    auto job = [&](int id) {
+        return [&, id](AdmissionQueue::Ticket ticket) {
+            started.push_back(id);
+            held.push_back(ticket);
+        };
+    };
+
+    ASSERT_EQ(0u, underTest.Enqueue(job(1)));
+    ASSERT_EQ(0u, underTest.Enqueue(job(2)));
+    ASSERT_EQ(1u, underTest.Enqueue(job(3)));
+    ASSERT_EQ(2u, underTest.Enqueue(job(4)));
+    ASSERT_EQ((std::vector<int> { 1, 2 }), started);
+    ASSERT_EQ(2u, underTest.Waiting());
+
+    // -- Dropping a ticket frees its slot for the next job in line.
+    AdmissionQueue::Ticket first = held.front();
+    held.erase(held.begin());
+    first.reset();
+    ASSERT_EQ((std::vector<int> { 1, 2, 3 }), started);
+
+    underTest.SetLimit(3);
+    ASSERT_EQ((std::vector<int> { 1, 2, 3, 4 }), started);
+    ASSERT_EQ(3, underTest.Active());
+
+    std::vector<AdmissionQueue::Ticket> rest;
+    rest.swap(held);
+    rest.clear();
+    ASSERT_EQ(0, underTest.Active());
+}
+
+TEST(AdmissionQueue, JobsDroppingTicketsDoNotBlock) {
+    AdmissionQueue underTest(1);
+    AdmissionQueue::Ticket first;
+    int started = 0;
+
+    underTest.Enqueue([&](AdmissionQueue::Ticket ticket) { first = ticket; });
+    for (int i = 0; i < 100; i++)
+        underTest.Enqueue([&](AdmissionQueue::Ticket) { started++; });
+
+    ASSERT_EQ(0, started);
+    first.reset();
+    ASSERT_EQ(100, started);
+    ASSERT_EQ(0, underTest.Active());
+    ASSERT_EQ(0u, underTest.Waiting());
+}
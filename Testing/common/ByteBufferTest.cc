@@ -1,4 +1,7 @@
 #include <string>
+#include <cstring>
+#include <span>
+#include <stdexcept>
 #include <gtest/gtest.h>
 #include "common/ByteBuffer.h"
 
@@ -132,4 +135,130 @@ TEST(ByteBuffer, Purge) {
     ASSERT_EQ(3, testBuffer.Size());
     ASSERT_EQ(1, testBuffer.PeekByte());
     ASSERT_TRUE(wasCalled);
-}
\ No newline at end of file
+}
+
+TEST(ByteBuffer, WriteStringOverwrites) {
+    ByteBuffer testBuffer(nullptr);
+    testBuffer.Write(std::string("first"));
+    testBuffer.Write(std::string(80, 'x'));
+
+    ASSERT_EQ(128, testBuffer.Size());
+    ASSERT_EQ("first", testBuffer.ReadString());
+    ASSERT_EQ(std::string(64, 'x'), testBuffer.ReadString());
+}
+
+TEST(ByteBuffer, ReadPastEndThrows) {
+    ByteBuffer testBuffer(nullptr);
+    testBuffer.Write(static_cast<short>(7));
+
+    ASSERT_EQ(7, testBuffer.ReadShort());
+    ASSERT_THROW(testBuffer.ReadByte(), std::out_of_range);
+}
+
+TEST(ByteBuffer, ShiftAfterRead) {
+    ByteBuffer testBuffer(nullptr);
+    testBuffer.Write(static_cast<unsigned char>(5));
+    testBuffer.Write(1234);
+    testBuffer.Write(static_cast<unsigned char>(9));
+
+    ASSERT_EQ(5, testBuffer.ReadByte());
+    ASSERT_EQ(1234, testBuffer.ReadInt());
+    testBuffer.Shift(5);
+
+    ASSERT_EQ(1, testBuffer.Size());
+    ASSERT_EQ(1, testBuffer.ReadSize());
+    ASSERT_EQ(9, testBuffer.PeekByte());
+}
+
+TEST(ByteBuffer, WrapAround) {
+    ByteBuffer testBuffer(nullptr);
+    int capacity = testBuffer.Capacity();
+    std::vector<unsigned char> filler(capacity - 2, 0xAA);
+
+    testBuffer.Write(filler, static_cast<int>(filler.size()));
+    testBuffer.Shift(static_cast<int>(filler.size()));
+    // -- Crosses the end of the storage.
+    testBuffer.Write(0x01020304);
+    testBuffer.Write(static_cast<short>(0x0506));
+
+    ASSERT_EQ(capacity, testBuffer.Capacity());
+    ASSERT_EQ(6, testBuffer.Size());
+    ASSERT_EQ(0x04030201, testBuffer.PeekIntLE());
+    ASSERT_EQ(0x01020304, testBuffer.ReadInt());
+    ASSERT_EQ(0x0506, testBuffer.ReadShort());
+}
+
+TEST(ByteBuffer, GrowWhileWrapped) {
+    ByteBuffer testBuffer(nullptr);
+    int capacity = testBuffer.Capacity();
+    std::vector<unsigned char> filler(capacity - 10, 0);
+
+    testBuffer.Write(filler, static_cast<int>(filler.size()));
+    testBuffer.Shift(static_cast<int>(filler.size()));
+
+    std::vector<unsigned char> data(capacity * 2);
+    for (size_t i = 0; i < data.size(); i++)
+        data[i] = static_cast<unsigned char>(i * 7);
+
+    testBuffer.Write(std::vector<unsigned char>(data.begin(), data.begin() + 20), 20);
+    testBuffer.ReadByte(3);
+    testBuffer.Write(std::vector<unsigned char>(data.begin() + 20, data.end()), static_cast<int>(data.size() - 20));
+
+    ASSERT_GT(testBuffer.Capacity(), capacity);
+    ASSERT_EQ(static_cast<int>(data.size()), testBuffer.Size());
+    ASSERT_EQ(static_cast<int>(data.size()) - 3, testBuffer.ReadSize());
+    ASSERT_EQ(std::vector<unsigned char>(data.begin() + 3, data.end()), testBuffer.ReadByte(static_cast<int>(data.size()) - 3));
+}
+
+TEST(ByteBuffer, BulkSpans) {
+    ByteBuffer testBuffer(nullptr);
+    int capacity = testBuffer.Capacity();
+    std::vector<unsigned char> filler(capacity - 4, 0);
+    testBuffer.Write(filler, static_cast<int>(filler.size()));
+    testBuffer.Shift(static_cast<int>(filler.size()));
+
+    unsigned char data[10] = { 0, 1, 2, 3, 4, 5, 6, 7, 8, 9 };
+    testBuffer.Write(std::span<const unsigned char>(data));
+
+    // -- Only the run up to the wrap point is contiguous.
+    ASSERT_EQ(4u, testBuffer.ReadableSpan().size());
+
+    unsigned char out[16] = {};
+    ASSERT_EQ(10, testBuffer.Peek(std::span<unsigned char>(out)));
+    ASSERT_EQ(0, std::memcmp(data, out, 10));
+    ASSERT_EQ(6, testBuffer.Read(std::span<unsigned char>(out, 6)));
+    ASSERT_EQ(6, testBuffer.PeekByte());
+}
+
+TEST(ByteBuffer, WritableSpanCommit) {
+    ByteBuffer testBuffer(nullptr);
+    int capacity = testBuffer.Capacity();
+    std::vector<unsigned char> filler(capacity - 8, 0);
+    testBuffer.Write(filler, static_cast<int>(filler.size()));
+    testBuffer.Shift(capacity - 16);
+
+    // -- 8 bytes remain before the wrap point, so asking for 32 has to relinearize.
+    auto target = testBuffer.WritableSpan(32);
+    ASSERT_GE(target.size(), 32u);
+    target[0] = 42;
+    target[1] = 43;
+    testBuffer.CommitWrite(2);
+
+    ASSERT_EQ(10, testBuffer.Size());
+    testBuffer.Shift(8);
+    ASSERT_EQ(42, testBuffer.ReadByte());
+    ASSERT_EQ(43, testBuffer.ReadByte());
+}
+
+TEST(ByteBuffer, GetAllBytesDrains) {
+    ByteBuffer testBuffer(nullptr);
+    std::vector<unsigned char> large(512 * 1024, 3);
+    testBuffer.Write(large, static_cast<int>(large.size()));
+
+    ASSERT_EQ(large, testBuffer.GetAllBytes());
+    ASSERT_EQ(0, testBuffer.Size());
+    ASSERT_LT(testBuffer.Capacity(), 512 * 1024);
+
+    testBuffer.Write(static_cast<unsigned char>(1));
+    ASSERT_EQ(1, testBuffer.PeekByte());
+}
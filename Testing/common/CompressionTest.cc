@@ -0,0 +1,58 @@
+#include <gtest/gtest.h>
+#include <filesystem>
+#include <vector>
+#include "compression.h"
+
+static std::vector<unsigned char> MakeCompressionInput(int length) {
+    std::vector<unsigned char> data(length);
+    unsigned int state = 12345;
+    for (int i = 0; i < length; i++) {
+        state = state * 1103515245 + 12345;
+        // -- Mostly repetitive with some noise, like real block data.
+        data[i] = (i % 7 == 0) ? static_cast<unsigned char>(state >> 24) : static_cast<unsigned char>(i / 4096);
+    }
+    return data;
+}
+
+TEST(Compression, ParallelRoundTrip) {
+    std::vector<unsigned char> input = MakeCompressionInput(1000003);
+    std::vector<unsigned char> compressed;
+
+    int64_t compressedSize = GZIP::GZip_CompressParallel(compressed, input.data(), static_cast<int64_t>(input.size()));
+    ASSERT_GT(compressedSize, 0);
+    ASSERT_EQ(compressedSize, compressed.size());
+    ASSERT_LT(compressed.size(), input.size());
+
+    std::vector<unsigned char> output(input.size());
+    int outputSize = GZIP::GZip_Decompress(output.data(), static_cast<int>(output.size()), compressed.data(), static_cast<int>(compressed.size()));
+    ASSERT_EQ(input.size(), outputSize);
+    ASSERT_EQ(input, output);
+}
+
+TEST(Compression, ParallelEmptyInput) {
+    std::vector<unsigned char> compressed;
+    ASSERT_GT(GZIP::GZip_CompressParallel(compressed, nullptr, 0), 0);
+
+    unsigned char output[4];
+    ASSERT_EQ(0, GZIP::GZip_Decompress(output, 4, compressed.data(), static_cast<int>(compressed.size())));
+}
+
+TEST(Compression, ParallelFileRoundTrip) {
+    std::string fileName = (std::filesystem::temp_directory_path() / "d3pp_parallel.gz").string();
+    std::vector<unsigned char> input = MakeCompressionInput(3000000);
+    size_t position = 0;
+
+    auto source = [&](unsigned char* buffer, int maxLen) {
+        int count = static_cast<int>(std::min(static_cast<size_t>(maxLen), input.size() - position));
+        std::copy(input.begin() + position, input.begin() + position + count, buffer);
+        position += count;
+        return count;
+    };
+    ASSERT_TRUE(GZIP::GZip_CompressToFileParallel(static_cast<int64_t>(input.size()), source, fileName));
+
+    std::vector<unsigned char> output;
+    auto sink = [&](const unsigned char* data, int len) { output.insert(output.end(), data, data + len); };
+    ASSERT_EQ(input.size(), GZIP::GZip_DecompressFromFileStreamed(sink, fileName));
+    ASSERT_EQ(input, output);
+    std::filesystem::remove(fileName);
+}
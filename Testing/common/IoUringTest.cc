@@ -0,0 +1,147 @@
+#ifdef __linux__
+#include <gtest/gtest.h>
+#include <cerrno>
+#include <cstdio>
+#include <fcntl.h>
+#include <string>
+#include <unistd.h>
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <sys/uio.h>
+#include "common/IoUring.h"
+
+using namespace D3PP::Common;
+
+namespace {
+    // -- Loopback harness: a listening socket and a set of connected bot/server socket pairs.
+    struct LoopbackPairs {
+        int listenFd = -1;
+        std::vector<int> bots;
+        std::vector<int> accepted;
+
+        explicit LoopbackPairs(int count) {
+            listenFd = socket(AF_INET, SOCK_STREAM, 0);
+            sockaddr_in address{};
+            address.sin_family = AF_INET;
+            address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+            bind(listenFd, reinterpret_cast<sockaddr*>(&address), sizeof(address));
+            listen(listenFd, count);
+            socklen_t length = sizeof(address);
+            getsockname(listenFd, reinterpret_cast<sockaddr*>(&address), &length);
+
+            for (int i = 0; i < count; i++) {
+                int bot = socket(AF_INET, SOCK_STREAM, 0);
+                connect(bot, reinterpret_cast<sockaddr*>(&address), sizeof(address));
+                bots.push_back(bot);
+                int client = accept(listenFd, nullptr, nullptr);
+                fcntl(client, F_SETFL, fcntl(client, F_GETFL) | O_NONBLOCK);
+                accepted.push_back(client);
+            }
+        }
+
+        ~LoopbackPairs() {
+            for (int fd : bots)
+                close(fd);
+            for (int fd : accepted)
+                close(fd);
+            close(listenFd);
+        }
+    };
+}
+
+TEST(IoUring, BatchedSendAndRecvOverLoopback) {
+    if (!IoUring::Supported())
+        GTEST_SKIP() << "io_uring not available";
+
+    LoopbackPairs pairs(8);
+    IoUring ring(4); // -- Smaller than the batch, so it has to be split over several submissions.
+    std::vector<std::string> messages;
+    std::vector<IoRequest> sends;
+
+    for (int i = 0; i < 8; i++)
+        messages.push_back("bot message " + std::to_string(i));
+    for (int i = 0; i < 8; i++)
+        sends.push_back(IoRequest{pairs.accepted[i], IoOperation::Send, messages[i].data(), static_cast<unsigned int>(messages[i].size()), 0, 0});
+
+    ASSERT_TRUE(ring.SubmitAndWait(sends));
+    for (int i = 0; i < 8; i++)
+        ASSERT_EQ(static_cast<int>(messages[i].size()), sends[i].Result);
+
+    std::vector<std::string> received(8, std::string(64, '\0'));
+    std::vector<IoRequest> receives;
+    for (int i = 0; i < 8; i++)
+        receives.push_back(IoRequest{pairs.bots[i], IoOperation::Recv, received[i].data(), 64, 0, 0});
+
+    ASSERT_TRUE(ring.SubmitAndWait(receives));
+    for (int i = 0; i < 8; i++) {
+        ASSERT_EQ(static_cast<int>(messages[i].size()), receives[i].Result);
+        ASSERT_EQ(messages[i], received[i].substr(0, receives[i].Result));
+    }
+}
+
+TEST(IoUring, RecvOnIdleSocketDoesNotBlock) {
+    if (!IoUring::Supported())
+        GTEST_SKIP() << "io_uring not available";
+
+    LoopbackPairs pairs(1);
+    IoUring ring;
+    char buffer[16];
+    std::vector<IoRequest> receives { IoRequest{pairs.accepted[0], IoOperation::Recv, buffer, sizeof(buffer), 0, 0} };
+
+    ASSERT_TRUE(ring.SubmitAndWait(receives));
+    ASSERT_EQ(-EAGAIN, receives[0].Result);
+}
+
+TEST(IoUring, FileReadWriteAtOffsets) {
+    if (!IoUring::Supported())
+        GTEST_SKIP() << "io_uring not available";
+
+    std::string fileName = "iouring_test.bin";
+    int fd = open(fileName.c_str(), O_RDWR | O_CREAT | O_TRUNC, 0644);
+    ASSERT_NE(-1, fd);
+
+    IoUring ring;
+    std::string first = "first block";
+    std::string second = "second block";
+    std::vector<IoRequest> writes {
+        IoRequest{fd, IoOperation::Write, first.data(), static_cast<unsigned int>(first.size()), 0, 0},
+        IoRequest{fd, IoOperation::Write, second.data(), static_cast<unsigned int>(second.size()), 4096, 0}
+    };
+    ASSERT_TRUE(ring.SubmitAndWait(writes));
+
+    std::string readFirst(first.size(), '\0');
+    std::string readSecond(second.size(), '\0');
+    std::vector<IoRequest> reads {
+        IoRequest{fd, IoOperation::Read, readSecond.data(), static_cast<unsigned int>(readSecond.size()), 4096, 0},
+        IoRequest{fd, IoOperation::Read, readFirst.data(), static_cast<unsigned int>(readFirst.size()), 0, 0}
+    };
+    ASSERT_TRUE(ring.SubmitAndWait(reads));
+    close(fd);
+    std::remove(fileName.c_str());
+
+    ASSERT_EQ(first, readFirst);
+    ASSERT_EQ(second, readSecond);
+}
+TEST(IoUring, VectoredSendMsgGathersSlices) {
+    if (!IoUring::Supported())
+        GTEST_SKIP() << "io_uring not available";
+
+    LoopbackPairs pairs(1);
+    IoUring ring(4);
+    std::string first = "first ";
+    std::string second = "second";
+    iovec slices[2] = { { first.data(), first.size() }, { second.data(), second.size() } };
+    msghdr message {};
+    message.msg_iov = slices;
+    message.msg_iovlen = 2;
+
+    std::vector<IoRequest> sends { IoRequest{pairs.accepted[0], IoOperation::SendMsg, &message, 0, 0, 0} };
+    ASSERT_TRUE(ring.SubmitAndWait(sends));
+    ASSERT_EQ(12, sends[0].Result);
+
+    std::string received(12, '\0');
+    ASSERT_EQ(12, recv(pairs.bots[0], received.data(), received.size(), MSG_WAITALL));
+    ASSERT_EQ("first second", received);
+}
+#endif
@@ -0,0 +1,89 @@
+#include <gtest/gtest.h>
+#include <atomic>
+#include <chrono>
+#include <future>
+#include <thread>
+#include "common/WorkerPool.h"
+
+using namespace D3PP::Common;
+
+TEST(WorkerPool, RunsSubmittedTasks) {
+    WorkerPool underTest(2);
+    std::atomic<int> completed{0};
+    std::promise<void> allDone;
+
+    for (int i = 0; i < 10; i++) {
+        underTest.Submit([&]() {
+            if (++completed == 10)
+                allDone.set_value();
+        });
+    }
+
+    ASSERT_EQ(std::future_status::ready, allDone.get_future().wait_for(std::chrono::seconds(5)));
+}
+
+TEST(WorkerPool, ThreadCountLimitsConcurrency) {
+    WorkerPool underTest(2);
+    std::atomic<int> running{0};
+    std::atomic<int> maxRunning{0};
+    std::atomic<int> completed{0};
+    std::promise<void> allDone;
+
+    for (int i = 0; i < 8; i++) {
+        underTest.Submit([&]() {
+            int now = ++running;
+            int seen = maxRunning;
+            while (now > seen && !maxRunning.compare_exchange_weak(seen, now)) {}
+            std::this_thread::sleep_for(std::chrono::milliseconds(10));
+            --running;
+            if (++completed == 8)
+                allDone.set_value();
+        });
+    }
+
+    ASSERT_EQ(std::future_status::ready, allDone.get_future().wait_for(std::chrono::seconds(5)));
+    ASSERT_LE(maxRunning, 2);
+}
+
+TEST(WorkerPool, KeepsQueuedTasksWhenResized) {
+    WorkerPool underTest(1);
+    std::promise<void> release;
+    std::shared_future<void> released = release.get_future().share();
+    std::promise<void> secondRan;
+
+    underTest.Submit([released]() { released.wait(); });
+    underTest.Submit([&]() { secondRan.set_value(); });
+    release.set_value();
+    underTest.SetThreadCount(3);
+
+    ASSERT_EQ(3, underTest.ThreadCount());
+    ASSERT_EQ(std::future_status::ready, secondRan.get_future().wait_for(std::chrono::seconds(5)));
+}
+
+TEST(WorkerPool, ResizesFromItsOwnTask) {
+    WorkerPool underTest(3);
+    std::promise<void> resized;
+
+    underTest.Submit([&]() {
+        underTest.SetThreadCount(1);
+        resized.set_value();
+    });
+
+    ASSERT_EQ(std::future_status::ready, resized.get_future().wait_for(std::chrono::seconds(5)));
+    ASSERT_EQ(1, underTest.ThreadCount());
+}
+
+TEST(WorkerPool, RunsQueuedTasksBeforeDestruction) {
+    std::atomic<int> completed{0};
+    {
+        WorkerPool underTest(1);
+        for (int i = 0; i < 10; i++) {
+            underTest.Submit([&]() {
+                std::this_thread::sleep_for(std::chrono::milliseconds(1));
+                completed++;
+            });
+        }
+    }
+
+    ASSERT_EQ(10, completed);
+}
@@ -0,0 +1,61 @@
+#include <gtest/gtest.h>
+#include <filesystem>
+#include <fstream>
+#include <vector>
+#include "files/BlockJournal.h"
+#include "../TempFolder.h"
+
+using namespace D3PP::files;
+
+TEST(BlockJournal, ReplayReturnsAppendedEntries) {
+    D3PP::testing::TempFolder temp("d3pp_journal_replay");
+    const std::string& folder = temp.Path;
+    {
+        BlockJournal journal(folder);
+        ASSERT_TRUE(journal.Append(D3PP::Common::Vector3S(static_cast<short>(1), 2, 3), 4, 5));
+        ASSERT_TRUE(journal.Append(D3PP::Common::Vector3S(static_cast<short>(300), 2, 1), 7, -1));
+        ASSERT_TRUE(journal.Sync());
+    }
+    // -- Simulate a torn write at the end of the file.
+    std::ofstream(folder + D3_MAP_JOURNAL_NAME, std::ios::app | std::ios::binary) << "xyz";
+
+    BlockJournal journal(folder);
+    std::vector<BlockJournalEntry> entries;
+    ASSERT_EQ(2, journal.Replay([&entries](const BlockJournalEntry& e) { entries.push_back(e); }));
+    ASSERT_EQ(300, entries[1].Location.X);
+    ASSERT_EQ(7, entries[1].Type);
+    ASSERT_EQ(-1, entries[1].Player);
+    ASSERT_EQ(32, journal.Size());
+}
+
+TEST(BlockJournal, TruncateKeepsRecordsAfterMark) {
+    D3PP::testing::TempFolder temp("d3pp_journal_truncate");
+    const std::string& folder = temp.Path;
+    BlockJournal journal(folder);
+    journal.Append(D3PP::Common::Vector3S(static_cast<short>(1), 1, 1), 1, 0);
+    int64_t mark = journal.Size();
+    journal.Append(D3PP::Common::Vector3S(static_cast<short>(2), 2, 2), 2, 0);
+    ASSERT_TRUE(journal.Truncate(mark));
+    ASSERT_FALSE(std::filesystem::exists(folder + D3_MAP_JOURNAL_NAME ".tmp"));
+
+    std::vector<BlockJournalEntry> entries;
+    ASSERT_EQ(1, journal.Replay([&entries](const BlockJournalEntry& e) { entries.push_back(e); }));
+    ASSERT_EQ(2, entries[0].Type);
+}
+
+TEST(BlockJournal, ReplayStopsAtBarrier) {
+    D3PP::testing::TempFolder temp("d3pp_journal_barrier");
+    const std::string& folder = temp.Path;
+    BlockJournal journal(folder);
+    journal.Append(D3PP::Common::Vector3S(static_cast<short>(1), 1, 1), 1, 0);
+    ASSERT_TRUE(journal.AppendBarrier());
+    journal.Append(D3PP::Common::Vector3S(static_cast<short>(2), 2, 2), 2, 0);
+
+    std::vector<BlockJournalEntry> entries;
+    ASSERT_EQ(1, journal.Replay([&entries](const BlockJournalEntry& e) { entries.push_back(e); }));
+    ASSERT_EQ(1, entries[0].Type);
+    // -- The barrier and everything behind it are gone, new records replay again.
+    ASSERT_EQ(16, journal.Size());
+    journal.Append(D3PP::Common::Vector3S(static_cast<short>(3), 3, 3), 3, 0);
+    ASSERT_EQ(2, journal.Replay([](const BlockJournalEntry&) {}));
+}
@@ -0,0 +1,86 @@
+#include <gtest/gtest.h>
+#include <filesystem>
+#include <fstream>
+#include <vector>
+#include "files/D3Map.h"
+#include "files/ChunkedBlockFile.h"
+#include "../TempFolder.h"
+
+using namespace D3PP::files;
+
+TEST(ChunkedBlockFile, ConvertedMapLoadsFromChunks) {
+	D3PP::testing::TempFolder temp("d3pp_chunked");
+	const std::string& folder = temp.Path;
+	D3PP::Common::Vector3S location(static_cast<short>(50), 20, 30);
+	{
+		D3Map mapTest(folder, "Chunked", D3PP::Common::Vector3S(static_cast<short>(64), 64, 64));
+		mapTest.SetBlock(location, 12);
+		mapTest.SetBlockLastPlayer(location, 77);
+		ASSERT_TRUE(mapTest.Save());
+		ASSERT_TRUE(std::filesystem::exists(folder + D3_MAP_BLOCKS_NAME));
+
+		mapTest.ConvertBlockLayer(true);
+		ASSERT_TRUE(mapTest.Save());
+	}
+	ASSERT_FALSE(std::filesystem::exists(folder + D3_MAP_BLOCKS_NAME));
+	ASSERT_TRUE(std::filesystem::exists(folder + D3_MAP_CHUNKED_BLOCKS_NAME));
+
+	D3Map loaded(folder);
+	ASSERT_TRUE(loaded.Load());
+	ASSERT_TRUE(loaded.ChunkedFormat);
+	ASSERT_EQ(12, loaded.GetBlock(location));
+	ASSERT_EQ(77, loaded.GetBlockLastPlayer(location));
+}
+
+TEST(ChunkedBlockFile, IncrementalSaveOnlyAppendsChangedChunks) {
+	D3PP::testing::TempFolder temp("d3pp_chunked_incremental");
+	const std::string& folder = temp.Path;
+	D3PP::Common::Vector3S size(static_cast<short>(64), 64, 64);
+	D3Map mapTest(folder, "Incremental", size);
+	mapTest.ConvertBlockLayer(true);
+	ASSERT_TRUE(mapTest.Save());
+
+	ChunkedBlockFile before(folder + D3_MAP_CHUNKED_BLOCKS_NAME);
+	ASSERT_TRUE(before.Open());
+	int64_t sizeBefore = before.FileSize();
+	int chunkCount = before.ChunkCount();
+	before.Close();
+
+	D3PP::Common::Vector3S location(static_cast<short>(1), 2, 3);
+	mapTest.SetBlock(location, 5);
+	ASSERT_TRUE(mapTest.Save());
+
+	ChunkedBlockFile after(folder + D3_MAP_CHUNKED_BLOCKS_NAME);
+	ASSERT_TRUE(after.Open());
+	ASSERT_TRUE(after.Verify());
+	// -- One chunk plus a new index, not the whole map again.
+	int64_t indexSize = chunkCount * static_cast<int64_t>(sizeof(ChunkIndexEntry));
+	ASSERT_LT(after.FileSize() - sizeBefore, indexSize + 4096);
+	ASSERT_GT(after.DeadBytes(), 0);
+	after.Close();
+
+	D3Map loaded(folder);
+	ASSERT_TRUE(loaded.Load());
+	ASSERT_EQ(5, loaded.GetBlock(location));
+}
+
+TEST(ChunkedBlockFile, CorruptChunkIsDetected) {
+	std::string fileName = (std::filesystem::temp_directory_path() / "d3pp_chunked_corrupt.d3c").string();
+	std::vector<unsigned char> data(16 * 16 * 16 * 4, 3);
+	{
+		ChunkedBlockFile chunkFile(fileName);
+		ASSERT_TRUE(chunkFile.Create(D3PP::Common::Vector3S(static_cast<short>(16), 16, 16), 4096));
+		ASSERT_TRUE(chunkFile.WriteChunk(0, data.data(), static_cast<int>(data.size())));
+		ASSERT_TRUE(chunkFile.Commit());
+	}
+	{
+		std::fstream file(fileName, std::ios::in | std::ios::out | std::ios::binary);
+		file.seekp(sizeof(ChunkedFileHeader) + 4);
+		file.put(static_cast<char>(0x55));
+	}
+	ChunkedBlockFile chunkFile(fileName);
+	ASSERT_TRUE(chunkFile.Open());
+	ASSERT_FALSE(chunkFile.Verify());
+	chunkFile.Close();
+	std::filesystem::remove(fileName);
+}
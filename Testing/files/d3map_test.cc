@@ -1,6 +1,10 @@
 #include <string>
+#include <filesystem>
+#include <thread>
+#include <atomic>
 #include <gtest/gtest.h>
 #include "files/D3Map.h"
+#include "../TempFolder.h"
 using namespace D3PP::files;
 
 TEST(D3MapTest, LoadExistingMap) {
@@ -25,4 +29,90 @@ TEST(D3MapTest, LoadMapBadBlockData) {
 	D3Map mapTest("TestFolder/badBlocks");
 	bool result = mapTest.Load();
 	ASSERT_FALSE(result);
-}
\ No newline at end of file
+}
+TEST(D3MapTest, SaveLoadRoundTripKeepsPlanes) {
+	D3PP::testing::TempFolder temp("d3pp_roundtrip");
+	const std::string& folder = temp.Path;
+	D3PP::Common::Vector3S location(static_cast<short>(3), 5, 7);
+	{
+		D3Map mapTest(folder, "RoundTrip", D3PP::Common::Vector3S(static_cast<short>(16), 16, 16));
+		mapTest.SetBlock(location, 7);
+		mapTest.SetBlockMetadata(location, 9);
+		mapTest.SetBlockLastPlayer(location, 300);
+		ASSERT_TRUE(mapTest.Save());
+	}
+	D3Map loaded(folder);
+	ASSERT_TRUE(loaded.Load());
+	ASSERT_EQ(16 * 16 * 16, loaded.BlockTypes.size());
+	ASSERT_EQ(7, loaded.GetBlock(location));
+	ASSERT_EQ(9, loaded.GetBlockMetadata(location));
+	ASSERT_EQ(300, loaded.GetBlockLastPlayer(location));
+}
+
+TEST(D3MapTest, DisabledPlanesAreNotStored) {
+	D3PP::testing::TempFolder temp("d3pp_typesonly");
+	const std::string& folder = temp.Path;
+	D3PP::Common::Vector3S location(static_cast<short>(1), 1, 1);
+	{
+		D3Map mapTest(folder, "TypesOnly", D3PP::Common::Vector3S(static_cast<short>(8), 8, 8));
+		mapTest.StoreLastPlayer = false;
+		mapTest.SetBlock(location, 4);
+		ASSERT_TRUE(mapTest.Save());
+	}
+	D3Map loaded(folder);
+	ASSERT_TRUE(loaded.Load());
+	ASSERT_TRUE(loaded.BlockLastPlayer.empty());
+	ASSERT_EQ(-1, loaded.GetBlockLastPlayer(location));
+	ASSERT_EQ(4, loaded.GetBlock(location));
+}
+
+TEST(D3MapTest, ChangesDuringSaveAreKeptForNextSave) {
+	D3PP::testing::TempFolder temp("d3pp_snapshot");
+	const std::string& folder = temp.Path;
+	D3PP::Common::Vector3S size(static_cast<short>(64), 64, 64);
+	{
+		D3Map mapTest(folder, "Snapshot", size);
+		std::atomic<bool> saving{true};
+		std::thread writer([&]() {
+			unsigned char type = 1;
+			while (saving) {
+				for (short x = 0; x < 64; x++)
+					mapTest.SetBlock(D3PP::Common::Vector3S(x, static_cast<short>(10), static_cast<short>(10)), type);
+				type = (type % 40) + 1;
+			}
+			for (short x = 0; x < 64; x++)
+				mapTest.SetBlock(D3PP::Common::Vector3S(x, static_cast<short>(10), static_cast<short>(10)), 42);
+		});
+		ASSERT_TRUE(mapTest.Save());
+		saving = false;
+		writer.join();
+		ASSERT_TRUE(mapTest.Save());
+	}
+	D3Map loaded(folder);
+	ASSERT_TRUE(loaded.Load());
+	for (short x = 0; x < 64; x++)
+		ASSERT_EQ(42, loaded.GetBlock(D3PP::Common::Vector3S(x, static_cast<short>(10), static_cast<short>(10))));
+}
+
+TEST(D3MapTest, CompactedBlocksExpandUnchanged) {
+	D3PP::testing::TempFolder temp("d3pp_warm");
+	const std::string& folder = temp.Path;
+	D3PP::Common::Vector3S location(static_cast<short>(9), 30, 2);
+	D3Map mapTest(folder, "Warm", D3PP::Common::Vector3S(static_cast<short>(32), 32, 32));
+	mapTest.SetBlock(location, 20);
+	mapTest.SetBlockMetadata(location, 4);
+	mapTest.SetBlockLastPlayer(location, 1234);
+
+	int64_t compactedSize = mapTest.CompactBlocks();
+	ASSERT_GT(compactedSize, 0);
+	ASSERT_LT(compactedSize, 32 * 32 * 32);
+	ASSERT_TRUE(mapTest.IsCompacted());
+	ASSERT_TRUE(mapTest.BlockTypes.empty());
+
+	ASSERT_TRUE(mapTest.ExpandBlocks());
+	ASSERT_FALSE(mapTest.IsCompacted());
+	ASSERT_EQ(32 * 32 * 32, mapTest.BlockTypes.size());
+	ASSERT_EQ(20, mapTest.GetBlock(location));
+	ASSERT_EQ(4, mapTest.GetBlockMetadata(location));
+	ASSERT_EQ(1234, mapTest.GetBlockLastPlayer(location));
+}
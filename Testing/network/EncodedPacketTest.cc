@@ -0,0 +1,61 @@
+#include <gtest/gtest.h>
+#include <vector>
+#include "network/EncodedPacket.h"
+#include "network/Packets.h"
+#include "network/packets/ChatPacket.h"
+
+using namespace D3PP::network;
+
+TEST(EncodedPacket, EncodesPacketOnce) {
+    ChatPacket chat(-1, "hello");
+    SharedPacket encoded = EncodedPacket::Encode(chat);
+
+    ASSERT_EQ(66u, encoded->Size());
+    ASSERT_EQ(13, encoded->Data()[0]);
+    ASSERT_EQ(0xFF, encoded->Data()[1]);
+    ASSERT_EQ('h', encoded->Data()[2]);
+    ASSERT_EQ(' ', encoded->Data()[65]);
+}
+
+TEST(EncodedPacket, BlockChangeMatchesWireLayout) {
+    SharedPacket encoded = Packets::EncodeBlockChange(1, 2, 3, 7);
+    std::vector<unsigned char> expected { 6, 0, 1, 0, 3, 0, 2, 7 };
+
+    ASSERT_EQ(expected, std::vector<unsigned char>(encoded->Data(), encoded->Data() + encoded->Size()));
+}
+
+TEST(EncodedPacket, SharedBetweenHolders) {
+    SharedPacket encoded = EncodedPacket::FromBytes({ 1 });
+    SharedPacket queued = encoded;
+
+    ASSERT_EQ(encoded.get(), queued.get());
+    ASSERT_EQ(2, encoded.use_count());
+}
+
+TEST(EncodedPacket, LevelDataSplitsIntoChunks) {
+    std::vector<unsigned char> compressed(2048, 9);
+    SharedPacket encoded = Packets::EncodeLevelData(compressed.data(), static_cast<int>(compressed.size()));
+
+    ASSERT_EQ(2u * 1028, encoded->Size());
+    ASSERT_EQ(3, encoded->Data()[0]);
+    ASSERT_EQ(4, encoded->Data()[1]);
+    ASSERT_EQ(0, encoded->Data()[2]);
+    ASSERT_EQ(9, encoded->Data()[3]);
+    ASSERT_EQ(0, encoded->Data()[1027]);
+    ASSERT_EQ(3, encoded->Data()[1028]);
+    ASSERT_EQ(50, encoded->Data()[2055]);
+}
+
+TEST(EncodedPacket, BulkBlockUpdateMatchesWireLayout) {
+    int indices[2] { 0x01020304, 5 };
+    unsigned char types[2] { 7, 8 };
+    SharedPacket encoded = Packets::EncodeBulkBlockUpdate(indices, types, 2);
+
+    ASSERT_EQ(1282u, encoded->Size());
+    ASSERT_EQ(0x26, encoded->Data()[0]);
+    ASSERT_EQ(1, encoded->Data()[1]);
+    ASSERT_EQ((std::vector<unsigned char> { 1, 2, 3, 4, 0, 0, 0, 5, 0, 0, 0, 0 }), std::vector<unsigned char>(encoded->Data() + 2, encoded->Data() + 14));
+    ASSERT_EQ(7, encoded->Data()[1026]);
+    ASSERT_EQ(8, encoded->Data()[1027]);
+    ASSERT_EQ(0, encoded->Data()[1028]);
+}
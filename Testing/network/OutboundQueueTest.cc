@@ -0,0 +1,127 @@
+#include <gtest/gtest.h>
+#include <span>
+#include <vector>
+#include "network/OutboundQueue.h"
+
+using namespace D3PP::network;
+
+static SharedPacket MakePacket(unsigned char id, size_t size = 4) {
+    return EncodedPacket::FromBytes(std::vector<unsigned char>(size, id));
+}
+
+static std::vector<unsigned char> GatherIds(OutboundQueue& queue) {
+    std::span<const unsigned char> slices[16];
+    size_t total = 0;
+    int count = queue.Gather(slices, 16, total);
+    std::vector<unsigned char> result;
+    for (int i = 0; i < count; i++)
+        result.push_back(slices[i][0]);
+
+    return result;
+}
+
+TEST(OutboundQueue, HigherLanesGoFirst) {
+    OutboundQueue underTest;
+    underTest.Push(MakePacket(1), SendLane::Bulk);
+    underTest.Push(MakePacket(2), SendLane::Movement);
+    underTest.Push(MakePacket(3), SendLane::Block);
+    underTest.Push(MakePacket(4), SendLane::Control);
+
+    ASSERT_EQ(16u, underTest.QueuedBytes());
+    ASSERT_EQ(12u, underTest.InteractiveBytes());
+    // -- Block waits for the older bulk packet.
+    ASSERT_EQ((std::vector<unsigned char> { 4, 2, 1, 3 }), GatherIds(underTest));
+}
+
+TEST(OutboundQueue, FencesAreBarriers) {
+    OutboundQueue underTest;
+    underTest.Push(MakePacket(1), SendLane::Movement);
+    underTest.Push(MakePacket(2), SendLane::Bulk, -1, true);
+    underTest.Push(MakePacket(3), SendLane::Control);
+    underTest.Push(MakePacket(4), SendLane::Bulk);
+    underTest.Push(MakePacket(5), SendLane::Bulk, -1, true);
+    underTest.Push(MakePacket(6), SendLane::Control);
+
+    ASSERT_EQ((std::vector<unsigned char> { 1, 2, 3, 4, 5, 6 }), GatherIds(underTest));
+}
+
+TEST(OutboundQueue, MovementCoalescesPerKey) {
+    OutboundQueue underTest;
+    underTest.Push(MakePacket(1), SendLane::Movement, 7);
+    underTest.Push(MakePacket(2), SendLane::Movement, 8);
+    underTest.Push(MakePacket(3, 6), SendLane::Movement, 7);
+
+    ASSERT_EQ(10u, underTest.QueuedBytes());
+    ASSERT_EQ((std::vector<unsigned char> { 3, 2 }), GatherIds(underTest));
+
+    // -- Gathered packets are in flight and must not be replaced.
+    underTest.Push(MakePacket(4), SendLane::Movement, 7);
+    ASSERT_EQ(14u, underTest.QueuedBytes());
+    underTest.Advance(10);
+    ASSERT_EQ((std::vector<unsigned char> { 4 }), GatherIds(underTest));
+}
+
+TEST(OutboundQueue, MovementDoesNotCoalesceAcrossFence) {
+    OutboundQueue underTest;
+    underTest.Push(MakePacket(1), SendLane::Movement, 7);
+    underTest.Push(MakePacket(2), SendLane::Bulk, -1, true);
+    underTest.Push(MakePacket(3), SendLane::Movement, 7);
+
+    ASSERT_EQ((std::vector<unsigned char> { 1, 2, 3 }), GatherIds(underTest));
+}
+
+TEST(OutboundQueue, PartialSendResumesFirst) {
+    OutboundQueue underTest;
+    underTest.Push(MakePacket(1, 10), SendLane::Bulk);
+    GatherIds(underTest);
+    underTest.Advance(3);
+    underTest.Push(MakePacket(2), SendLane::Control);
+
+    std::span<const unsigned char> slices[4];
+    size_t total = 0;
+    ASSERT_EQ(2, underTest.Gather(slices, 4, total));
+    ASSERT_EQ(7u, slices[0].size());
+    ASSERT_EQ(1, slices[0][0]);
+    ASSERT_EQ(2, slices[1][0]);
+    ASSERT_EQ(11u, total);
+
+    underTest.Advance(total);
+    ASSERT_TRUE(underTest.Empty());
+    ASSERT_EQ(0u, underTest.InteractiveBytes());
+}
+
+TEST(OutboundQueue, StreamHoldsLaterPackets) {
+    OutboundQueue underTest;
+    underTest.Push(MakePacket(1), SendLane::Bulk, -1, true);
+    underTest.OpenStream();
+    underTest.Push(MakePacket(2), SendLane::Control);
+    underTest.Push(MakePacket(3), SendLane::Block);
+
+    ASSERT_EQ((std::vector<unsigned char> { 1 }), GatherIds(underTest));
+    underTest.Advance(4);
+    underTest.PushStream(MakePacket(4));
+    ASSERT_EQ((std::vector<unsigned char> { 4 }), GatherIds(underTest));
+    underTest.Advance(4);
+
+    // -- The stream ran dry but isn't closed, so nothing queued after it may go yet.
+    ASSERT_TRUE(GatherIds(underTest).empty());
+    ASSERT_FALSE(underTest.Empty());
+    ASSERT_EQ(0u, underTest.LaneBytes(SendLane::Bulk));
+
+    underTest.PushStream(MakePacket(5));
+    underTest.CloseStream(MakePacket(6));
+    ASSERT_FALSE(underTest.StreamOpen());
+    ASSERT_EQ((std::vector<unsigned char> { 5, 6, 2, 3 }), GatherIds(underTest));
+}
+
+TEST(OutboundQueue, AbandonedStreamReleasesQueue) {
+    OutboundQueue underTest;
+    underTest.OpenStream();
+    underTest.Push(MakePacket(1), SendLane::Control);
+    ASSERT_TRUE(GatherIds(underTest).empty());
+
+    underTest.CloseStream(nullptr);
+    ASSERT_EQ((std::vector<unsigned char> { 1 }), GatherIds(underTest));
+    underTest.Advance(4);
+    ASSERT_TRUE(underTest.Empty());
+}
@@ -0,0 +1,42 @@
+#include <gtest/gtest.h>
+#include <string>
+#include <vector>
+#include "network/PacketReader.h"
+
+using namespace D3PP::network;
+
+TEST(PacketReader, DecodesBigEndianFields) {
+    std::vector<unsigned char> packet { 5, 0x01, 0x02, 0xFF, 0xFE, 0x00, 0x10, 1, 42 };
+    PacketReader underTest(packet);
+
+    ASSERT_EQ(5, underTest.ReadByte());
+    ASSERT_EQ(0x0102, underTest.ReadShort());
+    ASSERT_EQ(-2, underTest.ReadShort());
+    ASSERT_EQ(0x10, underTest.ReadShort());
+    ASSERT_EQ(1, underTest.ReadByte());
+    ASSERT_EQ(42, underTest.ReadByte());
+    ASSERT_EQ(0u, underTest.Remaining());
+}
+
+TEST(PacketReader, ReadsIntAndPaddedString) {
+    std::string name = "ClassiCube";
+    std::vector<unsigned char> packet(name.begin(), name.end());
+    packet.resize(64, ' ');
+    packet.insert(packet.end(), { 0x00, 0x00, 0x01, 0x02 });
+    PacketReader underTest(packet);
+
+    ASSERT_EQ(name, underTest.ReadString());
+    ASSERT_EQ(0x0102, underTest.ReadInt());
+}
+
+TEST(PacketReader, InboundLengthTable) {
+    ASSERT_EQ(NETWORK_MAX_INBOUND_PACKET, InboundPacketLength(0));
+    ASSERT_EQ(1, InboundPacketLength(1));
+    ASSERT_EQ(9, InboundPacketLength(5));
+    ASSERT_EQ(10, InboundPacketLength(8));
+    ASSERT_EQ(66, InboundPacketLength(13));
+    ASSERT_EQ(4, InboundPacketLength(43));
+    // -- Server to client only.
+    ASSERT_EQ(-1, InboundPacketLength(2));
+    ASSERT_EQ(-1, InboundPacketLength(255));
+}
@@ -0,0 +1,53 @@
+#include <gtest/gtest.h>
+#include <chrono>
+#include "network/RateLimit.h"
+
+using namespace D3PP::network;
+using namespace std::chrono_literals;
+
+TEST(TokenBucket, AllowsBurstThenRefills) {
+    auto start = std::chrono::steady_clock::now();
+    TokenBucket underTest(10, 3, start);
+
+    ASSERT_TRUE(underTest.Take(start));
+    ASSERT_TRUE(underTest.Take(start));
+    ASSERT_TRUE(underTest.Take(start));
+    ASSERT_FALSE(underTest.Take(start));
+
+    // -- 10 per second: one token every 100ms.
+    ASSERT_FALSE(underTest.Take(start + 50ms));
+    ASSERT_TRUE(underTest.Take(start + 100ms));
+    ASSERT_FALSE(underTest.Take(start + 100ms));
+
+    // -- Never refills past the burst.
+    ASSERT_FALSE(underTest.Idle(start + 200ms));
+    ASSERT_TRUE(underTest.Idle(start + 10s));
+    for (int i = 0; i < 3; i++)
+        ASSERT_TRUE(underTest.Take(start + 10s));
+    ASSERT_FALSE(underTest.Take(start + 10s));
+}
+
+TEST(TokenBucket, ZeroRateNeverLimits) {
+    auto start = std::chrono::steady_clock::now();
+    TokenBucket underTest(0, 1, start);
+
+    for (int i = 0; i < 100; i++)
+        ASSERT_TRUE(underTest.Take(start));
+}
+
+TEST(ConnectionLimiter, LimitsPerAddress) {
+    auto start = std::chrono::steady_clock::now();
+    ConnectionLimiter underTest;
+
+    ASSERT_TRUE(underTest.Allow("10.0.0.1", 1, 2, start));
+    ASSERT_TRUE(underTest.Allow("10.0.0.1", 1, 2, start));
+    ASSERT_FALSE(underTest.Allow("10.0.0.1", 1, 2, start));
+    ASSERT_TRUE(underTest.Allow("10.0.0.2", 1, 2, start));
+    ASSERT_EQ(2u, underTest.Tracked());
+
+    underTest.Prune(start + 1s);
+    ASSERT_EQ(1u, underTest.Tracked());
+    underTest.Prune(start + 2s);
+    ASSERT_EQ(0u, underTest.Tracked());
+    ASSERT_TRUE(underTest.Allow("10.0.0.1", 1, 2, start + 2s));
+}
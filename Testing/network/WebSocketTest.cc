@@ -0,0 +1,109 @@
+#include <gtest/gtest.h>
+#include <span>
+#include <string>
+#include <vector>
+#include "common/ByteBuffer.h"
+#include "network/WebSocket.h"
+
+using namespace D3PP::network;
+
+static void WriteString(ByteBuffer& buffer, const std::string& text) {
+    buffer.Write(std::span<const unsigned char>(reinterpret_cast<const unsigned char *>(text.data()), text.size()));
+}
+
+static std::string Drain(ByteBuffer& buffer) {
+    auto bytes = buffer.GetAllBytes();
+    return {bytes.begin(), bytes.end()};
+}
+
+TEST(WebSocket, AcceptKeyMatchesRfc) {
+    ASSERT_EQ("s3pPLMBiTxaQ9kYGzzhZRbK+xOo=", WebSocketCodec::AcceptKey("dGhlIHNhbXBsZSBub25jZQ=="));
+}
+
+TEST(WebSocket, HandshakeThenMaskedFrame) {
+    WebSocketCodec underTest;
+    ByteBuffer raw(nullptr);
+    ByteBuffer payload(nullptr);
+
+    WriteString(raw, "GET / HTTP/1.1\r\nHost: localhost\r\nUpgrade: websocket\r\n");
+    ASSERT_EQ(WebSocketStatus::Ok, underTest.Decode(raw, payload));
+    ASSERT_FALSE(underTest.Pending());
+
+    WriteString(raw, "Sec-WebSocket-Key: dGhlIHNhbXBsZSBub25jZQ==\r\nSec-WebSocket-Protocol: ClassiCube\r\n\r\n");
+    // -- RFC 6455 5.7: masked "Hello", split so the frame arrives in two reads.
+    raw.Write(std::span<const unsigned char>(std::vector<unsigned char> { 0x81, 0x85, 0x37, 0xfa, 0x21, 0x3d, 0x7f, 0x9f }));
+    ASSERT_EQ(WebSocketStatus::Ok, underTest.Decode(raw, payload));
+    ASSERT_TRUE(underTest.Pending());
+    ASSERT_EQ(0, payload.Size());
+
+    raw.Write(std::span<const unsigned char>(std::vector<unsigned char> { 0x4d, 0x51, 0x58 }));
+    ASSERT_EQ(WebSocketStatus::Ok, underTest.Decode(raw, payload));
+    ASSERT_EQ("Hello", Drain(payload));
+    ASSERT_EQ(0, raw.Size());
+
+    // -- The response goes out first and alone.
+    std::span<const unsigned char> slices[2];
+    size_t total = 0;
+    ASSERT_EQ(1, underTest.Frame(slices, 0, total));
+    std::string response(slices[0].begin(), slices[0].end());
+    ASSERT_NE(std::string::npos, response.find("Sec-WebSocket-Accept: s3pPLMBiTxaQ9kYGzzhZRbK+xOo=\r\n"));
+    ASSERT_NE(std::string::npos, response.find("Sec-WebSocket-Protocol: ClassiCube\r\n"));
+    ASSERT_EQ(0u, underTest.Consume(total));
+    ASSERT_FALSE(underTest.Pending());
+}
+
+TEST(WebSocket, RejectsUnmaskedAndClose) {
+    WebSocketCodec underTest;
+    ByteBuffer raw(nullptr);
+    ByteBuffer payload(nullptr);
+    WriteString(raw, "GET / HTTP/1.1\r\nSec-WebSocket-Key: x\r\n\r\n");
+    raw.Write(std::span<const unsigned char>(std::vector<unsigned char> { 0x82, 0x01, 0x00 }));
+    ASSERT_EQ(WebSocketStatus::Error, underTest.Decode(raw, payload));
+
+    WebSocketCodec closing;
+    ByteBuffer closeRaw(nullptr);
+    WriteString(closeRaw, "GET / HTTP/1.1\r\nSec-WebSocket-Key: x\r\n\r\n");
+    closeRaw.Write(std::span<const unsigned char>(std::vector<unsigned char> { 0x88, 0x80, 1, 2, 3, 4 }));
+    ASSERT_EQ(WebSocketStatus::Closed, closing.Decode(closeRaw, payload));
+}
+
+TEST(WebSocket, UnmaskAtAnyOffset) {
+    std::array<unsigned char, 4> mask { 1, 2, 3, 4 };
+    std::vector<unsigned char> data(21, 0);
+    WebSocketCodec::Unmask(data, mask, 3);
+
+    for (size_t i = 0; i < data.size(); i++)
+        ASSERT_EQ(mask[(i + 3) & 3], data[i]);
+}
+
+TEST(WebSocket, FramesGatheredSlicesAcrossPartialSends) {
+    WebSocketCodec underTest;
+    std::vector<unsigned char> first(100, 1);
+    std::vector<unsigned char> second(50, 2);
+    std::span<const unsigned char> slices[3] { first, second };
+    size_t total = 150;
+
+    ASSERT_EQ(3, underTest.Frame(slices, 2, total));
+    ASSERT_EQ(4u, slices[0].size());
+    ASSERT_EQ(0x82, slices[0][0]);
+    ASSERT_EQ(126, slices[0][1]);
+    ASSERT_EQ(150, (slices[0][2] << 8) | slices[0][3]);
+    ASSERT_EQ(154u, total);
+
+    // -- Header and 60 payload bytes went out; the frame still owes 90.
+    ASSERT_EQ(60u, underTest.Consume(64));
+    std::vector<unsigned char> rest(40, 1);
+    std::vector<unsigned char> later(200, 3);
+    std::span<const unsigned char> next[3] { rest, second, later };
+    total = 290;
+    ASSERT_EQ(2, underTest.Frame(next, 3, total));
+    ASSERT_EQ(90u, total);
+    ASSERT_EQ(50u, next[1].size());
+    ASSERT_EQ(90u, underTest.Consume(90));
+    ASSERT_FALSE(underTest.Pending());
+
+    unsigned char header[WEBSOCKET_MAX_HEADER];
+    ASSERT_EQ(2, WebSocketCodec::EncodeHeader(125, header));
+    ASSERT_EQ(10, WebSocketCodec::EncodeHeader(70000, header));
+    ASSERT_EQ(0x01, header[7]);
+}
@@ -0,0 +1,209 @@
+#include <gtest/gtest.h>
+#include <functional>
+#include <memory>
+#include <vector>
+#include <zlib.h>
+#include "compression.h"
+#include "network/EncodedPacket.h"
+#include "world/MapSendStream.h"
+
+using namespace D3PP::world;
+
+static std::vector<unsigned char> MakeStreamBlocks(int volume) {
+    std::vector<unsigned char> blocks(volume);
+    unsigned int state = 4321;
+    for (int i = 0; i < volume; i++) {
+        state = state * 1103515245 + 12345;
+        blocks[i] = (i % 3 == 0) ? static_cast<unsigned char>(state >> 24) : static_cast<unsigned char>(i / 8192);
+    }
+    return blocks;
+}
+
+// -- Joins the chunk payloads of level data packets back into the gzip stream.
+static void AppendLevelData(const D3PP::network::SharedPacket& packet, std::vector<unsigned char>& gzipped, std::vector<int>& percents) {
+    ASSERT_EQ(0u, packet->Size() % 1028);
+    for (size_t offset = 0; offset < packet->Size(); offset += 1028) {
+        const unsigned char* chunk = packet->Data() + offset;
+        ASSERT_EQ(3, chunk[0]);
+        int length = (chunk[1] << 8) | chunk[2];
+        ASSERT_LE(length, 1024);
+        gzipped.insert(gzipped.end(), chunk + 3, chunk + 3 + length);
+        percents.push_back(chunk[1027]);
+    }
+}
+
+TEST(MapSendStream, StreamsTranslatedLevel) {
+    D3PP::Common::Vector3S size(static_cast<short>(128), 128, 64);
+    int volume = 128 * 128 * 64;
+    std::vector<unsigned char> blocks = MakeStreamBlocks(volume);
+    std::array<unsigned char, 256> translation {};
+    for (int i = 0; i < 256; i++)
+        translation[i] = static_cast<unsigned char>(i < 50 ? i : 1);
+
+    int reads = 0;
+    auto reader = [&](int64_t offset, unsigned char* output, int count) {
+        reads++;
+        std::copy_n(blocks.begin() + offset, count, output);
+        return true;
+    };
+    bool finished = false;
+    MapSendStream underTest(reader, size, translation, [&](MapSendStream&, bool complete) { finished = complete; });
+
+    std::vector<unsigned char> gzipped;
+    std::vector<int> percents;
+    int packets = 0;
+    D3PP::network::SharedPacket packet;
+    while ((packet = underTest.Next()) != nullptr) {
+        // -- The first packet goes out long before the whole map was read.
+        if (packets++ == 0) {
+            ASSERT_LT(reads, volume / MAP_STREAM_READ_BLOCKS);
+        }
+        AppendLevelData(packet, gzipped, percents);
+    }
+
+    ASSERT_GT(packets, 1);
+    ASSERT_EQ(packets, underTest.Encoded().size());
+    ASSERT_EQ(100, percents.back());
+    ASSERT_TRUE(std::is_sorted(percents.begin(), percents.end()));
+
+    std::vector<unsigned char> level(volume + 4);
+    ASSERT_EQ(volume + 4, GZIP::GZip_Decompress(level.data(), static_cast<int>(level.size()), gzipped.data(), static_cast<int>(gzipped.size())));
+    ASSERT_EQ(volume, (level[0] << 24) | (level[1] << 16) | (level[2] << 8) | level[3]);
+    for (int i = 0; i < volume; i++)
+        ASSERT_EQ(translation[blocks[i]], level[i + 4]);
+
+    auto closing = underTest.Closing();
+    ASSERT_NE(nullptr, closing);
+    ASSERT_EQ(7u, closing->Size());
+    ASSERT_EQ(4, closing->Data()[0]);
+    underTest.Finished(true);
+    ASSERT_TRUE(finished);
+    ASSERT_FALSE(underTest.Replayed());
+
+    MapSendStream replay(underTest.Encoded(), size, nullptr);
+    for (auto const &encoded : underTest.Encoded())
+        ASSERT_EQ(encoded, replay.Next());
+    ASSERT_EQ(nullptr, replay.Next());
+    ASSERT_TRUE(replay.Replayed());
+}
+
+TEST(MapSendStream, FastMapIsRawDeflate) {
+    D3PP::Common::Vector3S size(static_cast<short>(64), 64, 32);
+    int volume = 64 * 64 * 32;
+    std::vector<unsigned char> blocks = MakeStreamBlocks(volume);
+    std::array<unsigned char, 256> translation {};
+    for (int i = 0; i < 256; i++)
+        translation[i] = static_cast<unsigned char>(i);
+
+    auto reader = [&](int64_t offset, unsigned char* output, int count) {
+        std::copy_n(blocks.begin() + offset, count, output);
+        return true;
+    };
+    MapSendStream underTest(reader, size, translation, nullptr, true);
+
+    std::vector<unsigned char> deflated;
+    std::vector<int> percents;
+    D3PP::network::SharedPacket packet;
+    while ((packet = underTest.Next()) != nullptr)
+        AppendLevelData(packet, deflated, percents);
+
+    // -- No gzip header and no length prefix, the client learned the volume from the level init.
+    std::vector<unsigned char> level(volume + 1);
+    z_stream inflater {};
+    ASSERT_EQ(Z_OK, inflateInit2(&inflater, -15));
+    inflater.next_in = deflated.data();
+    inflater.avail_in = static_cast<unsigned int>(deflated.size());
+    inflater.next_out = level.data();
+    inflater.avail_out = static_cast<unsigned int>(level.size());
+    ASSERT_EQ(Z_STREAM_END, inflate(&inflater, Z_FINISH));
+    ASSERT_EQ(static_cast<unsigned long>(volume), inflater.total_out);
+    inflateEnd(&inflater);
+
+    level.resize(volume);
+    ASSERT_EQ(blocks, level);
+}
+
+TEST(MapSendStream, WorkerEncodesOnceAdmitted) {
+    D3PP::Common::Vector3S size(static_cast<short>(128), 128, 64);
+    int volume = 128 * 128 * 64;
+    std::vector<unsigned char> blocks = MakeStreamBlocks(volume);
+    std::array<unsigned char, 256> translation {};
+    for (int i = 0; i < 256; i++)
+        translation[i] = static_cast<unsigned char>(i);
+
+    auto reader = [&](int64_t offset, unsigned char* output, int count) {
+        std::copy_n(blocks.begin() + offset, count, output);
+        return true;
+    };
+    std::vector<std::function<void()>> tasks;
+    int wakes = 0;
+    auto underTest = std::make_shared<MapSendStream>(reader, size, translation, nullptr);
+    underTest->RunOn([&](const std::function<void()>& task) { tasks.push_back(task); });
+    underTest->SetWake([&]() { wakes++; });
+
+    // -- Nothing is encoded while the send waits for its turn.
+    ASSERT_EQ(nullptr, underTest->Next());
+    ASSERT_FALSE(underTest->Ended());
+    ASSERT_TRUE(tasks.empty());
+
+    auto ticket = std::make_shared<int>(0);
+    std::weak_ptr<int> released = ticket;
+    underTest->Admit(ticket);
+    ticket.reset();
+    ASSERT_EQ(1u, tasks.size());
+
+    std::vector<unsigned char> gzipped;
+    std::vector<int> percents;
+    while (!underTest->Ended()) {
+        if (!tasks.empty()) {
+            auto task = tasks.front();
+            tasks.erase(tasks.begin());
+            task();
+        }
+
+        D3PP::network::SharedPacket packet;
+        while ((packet = underTest->Next()) != nullptr)
+            AppendLevelData(packet, gzipped, percents);
+    }
+
+    ASSERT_GT(wakes, 0);
+    // -- The slot is given back once encoding is done, not when the client is.
+    ASSERT_TRUE(released.expired());
+    ASSERT_NE(nullptr, underTest->Closing());
+
+    std::vector<unsigned char> level(volume + 4);
+    ASSERT_EQ(volume + 4, GZIP::GZip_Decompress(level.data(), static_cast<int>(level.size()), gzipped.data(), static_cast<int>(gzipped.size())));
+    for (int i = 0; i < volume; i++)
+        ASSERT_EQ(blocks[i], level[i + 4]);
+}
+
+TEST(MapSendStream, ReadFailureEndsStream) {
+    D3PP::Common::Vector3S size(static_cast<short>(16), 16, 16);
+    std::array<unsigned char, 256> translation {};
+    MapSendStream underTest([](int64_t, unsigned char*, int) { return false; }, size, translation, nullptr);
+
+    ASSERT_EQ(nullptr, underTest.Next());
+    ASSERT_EQ(nullptr, underTest.Closing());
+}
+
+TEST(MapSendStream, AbortEndsWaitingStream) {
+    D3PP::Common::Vector3S size(static_cast<short>(16), 16, 16);
+    std::array<unsigned char, 256> translation {};
+    int reads = 0;
+    std::vector<std::function<void()>> tasks;
+    int wakes = 0;
+    auto underTest = std::make_shared<MapSendStream>([&](int64_t, unsigned char*, int) { reads++; return true; }, size, translation, nullptr);
+    underTest->RunOn([&](const std::function<void()>& task) { tasks.push_back(task); });
+    underTest->SetWake([&]() { wakes++; });
+
+    // -- The client already asked and is waiting to be woken.
+    ASSERT_EQ(nullptr, underTest->Next());
+    underTest->Abort();
+
+    ASSERT_EQ(1, wakes);
+    ASSERT_TRUE(underTest->Ended());
+    ASSERT_EQ(nullptr, underTest->Next());
+    ASSERT_EQ(nullptr, underTest->Closing());
+    ASSERT_TRUE(tasks.empty());
+    ASSERT_EQ(0, reads);
+}
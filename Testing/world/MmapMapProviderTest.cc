@@ -0,0 +1,58 @@
+#ifdef __linux__
+#include <gtest/gtest.h>
+#include <filesystem>
+#include "files/D3Map.h"
+#include "world/MmapMapProvider.h"
+#include "../TempFolder.h"
+
+using namespace D3PP::world;
+
+TEST(MmapMapProvider, ConvertsGzipLayerOnFirstLoad) {
+    D3PP::testing::TempFolder temp("d3pp_mmap");
+    const std::string& folder = temp.Path;
+    D3PP::Common::Vector3S location(static_cast<short>(10), 11, 12);
+    {
+        D3PP::files::D3Map source(folder, "Mmap", D3PP::Common::Vector3S(static_cast<short>(32), 32, 32));
+        source.SetBlock(location, 20);
+        source.SetBlockLastPlayer(location, 513);
+        ASSERT_TRUE(source.Save());
+    }
+    {
+        MmapMapProvider underTest;
+        ASSERT_TRUE(underTest.Load(folder));
+        ASSERT_TRUE(std::filesystem::exists(folder + MMAP_MAP_BLOCKS_NAME));
+        ASSERT_EQ(20, underTest.GetBlock(location));
+        ASSERT_EQ(513, underTest.GetLastPlayer(location));
+        underTest.SetBlock(location, 21);
+        ASSERT_TRUE(underTest.Save(""));
+    }
+    MmapMapProvider reopened;
+    ASSERT_TRUE(reopened.Load(folder));
+    ASSERT_EQ(21, reopened.GetBlock(location));
+    {
+        // -- The gzip layer is kept current too, so a regular D3 map sees the change.
+        D3PP::files::D3Map plain(folder);
+        ASSERT_TRUE(plain.Load(folder));
+        ASSERT_EQ(21, plain.GetBlock(location));
+    }
+}
+
+TEST(MmapMapProvider, ResizesUnmappedLayerFromDisk) {
+    D3PP::testing::TempFolder temp("d3pp_mmap_resize");
+    const std::string& folder = temp.Path;
+    D3PP::Common::Vector3S location(static_cast<short>(3), 4, 5);
+    {
+        MmapMapProvider created;
+        created.CreateNew(D3PP::Common::Vector3S(static_cast<short>(16), 16, 16), folder, "Mmap");
+        created.SetBlock(location, 7);
+        ASSERT_TRUE(created.Save(""));
+    }
+
+    MmapMapProvider underTest;
+    ASSERT_TRUE(underTest.Load(folder));
+    ASSERT_TRUE(underTest.Unload());
+    underTest.SetSize(D3PP::Common::Vector3S(static_cast<short>(32), 32, 16));
+    ASSERT_EQ(32, underTest.GetSize().X);
+    ASSERT_EQ(7, underTest.GetBlock(location));
+}
+#endif
@@ -0,0 +1,56 @@
+#include <gtest/gtest.h>
+#include "world/PalettedMapProvider.h"
+#include "../TempFolder.h"
+
+using namespace D3PP::world;
+
+TEST(PalettedSection, UniformSectionHasNoIndices) {
+    PalettedSection underTest(0);
+    ASSERT_TRUE(underTest.IsUniform());
+    ASSERT_EQ(0, underTest.Get(1234));
+}
+
+TEST(PalettedSection, GrowsAndCollapses) {
+    PalettedSection underTest(0);
+    for (int i = 0; i < 20; i++)
+        underTest.Set(i, static_cast<unsigned char>(i + 1));
+
+    ASSERT_EQ(8, underTest.BitsPerIndex());
+    for (int i = 0; i < 20; i++)
+        ASSERT_EQ(i + 1, underTest.Get(i));
+    ASSERT_EQ(0, underTest.Get(20));
+
+    for (int i = 0; i < 20; i++)
+        underTest.Set(i, 0);
+
+    ASSERT_TRUE(underTest.IsUniform());
+    ASSERT_EQ(0, underTest.Get(5));
+}
+
+TEST(PalettedMapProvider, SaveLoadRoundTrip) {
+    D3PP::testing::TempFolder temp("d3pp_paletted");
+    const std::string& folder = temp.Path;
+    D3PP::Common::Vector3S size(static_cast<short>(40), 20, 24);
+    D3PP::Common::Vector3S location(static_cast<short>(33), 17, 19);
+    {
+        PalettedMapProvider underTest;
+        underTest.CreateNew(size, folder, "Paletted");
+        std::vector<unsigned char> blocks(40 * 20 * 24);
+        for (int i = 0; i < 40 * 20 * 12; i++)
+            blocks[i] = 3;
+        underTest.SetBlocks(blocks);
+        underTest.SetBlock(location, 41);
+        underTest.SetLastPlayer(location, 300);
+        ASSERT_TRUE(underTest.Save(""));
+    }
+    PalettedMapProvider loaded;
+    ASSERT_TRUE(loaded.Load(folder));
+    ASSERT_EQ(41, loaded.GetBlock(location));
+    ASSERT_EQ(300, loaded.GetLastPlayer(location));
+    ASSERT_EQ(3, loaded.GetBlock(D3PP::Common::Vector3S(static_cast<short>(39), 19, 11)));
+    ASSERT_EQ(0, loaded.GetBlock(D3PP::Common::Vector3S(static_cast<short>(39), 19, 12)));
+
+    std::vector<unsigned char> all = loaded.GetBlocks();
+    ASSERT_EQ(40 * 20 * 24, all.size());
+    ASSERT_EQ(41, all[33 + 17 * 40 + 19 * 40 * 20]);
+}
@@ -28,6 +28,8 @@
 #define ENTITY_PROPERTIES_EXT_NAME "EntityProperty"
 #define INVENTORY_ORDER_EXT_NAME "InventoryOrder"
 #define SET_HOTBAR_EXT_NAME "SetHotbar"
+#define FAST_MAP_EXT_NAME "FastMap"
+#define BULK_BLOCK_UPDATE_EXT_NAME "BulkBlockUpdate"
 
 
 #include <memory>
@@ -89,6 +89,7 @@ class CommandMain : TaskItem {
 
         // -- Map Modifiers
         void CommandSaveMap();
+        void CommandConvertMap();
         void CommandLoadMap();
         void CommandResizeMap();
         void CommandRenameMap();
@@ -43,8 +43,12 @@ public:
     void SendQueued() override { }
     void HandleData() override { }
     void SendPacket(D3PP::network::IPacket& p) override { }
+    void SendShared(const D3PP::network::SharedPacket& packet, D3PP::network::SendLane lane = D3PP::network::SendLane::Control, int key = -1, bool fence = false) override { }
+    void StreamBulk(const std::shared_ptr<D3PP::network::IBulkSource>& source) override { }
     bool GetLoggedIn() override { return true; }
     void NotifyDataAvailable() override {}
+    void NotifyWritable() override {}
+    bool HasPendingInput() override { return false; }
         void Undo(int steps) override {}
     void Redo(int steps) override {}
     void AddUndoItem(const D3PP::Common::UndoItem& item) override {}
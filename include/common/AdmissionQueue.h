@@ -0,0 +1,42 @@
+#ifndef D3PP_ADMISSIONQUEUE_H
+#define D3PP_ADMISSIONQUEUE_H
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+
+namespace D3PP::Common {
+    // -- Lets at most limit jobs be active at once and queues the rest in arrival order. A started job keeps its
+    // -- slot for as long as any copy of the ticket it was given is alive, so it may outlast the call that started it.
+    class AdmissionQueue {
+    public:
+        typedef std::shared_ptr<void> Ticket;
+
+        explicit AdmissionQueue(int limit);
+        AdmissionQueue(const AdmissionQueue&) = delete;
+        AdmissionQueue& operator=(const AdmissionQueue&) = delete;
+
+        // -- Starts job on this thread if a slot is free, otherwise on the thread that frees one.
+        // -- Returns the job's place in the queue, 0 if it was started right away.
+        size_t Enqueue(const std::function<void(Ticket)>& job);
+        void SetLimit(int limit);
+        [[nodiscard]] int Active();
+        [[nodiscard]] size_t Waiting();
+    private:
+        struct Slot {
+            AdmissionQueue* Queue;
+            ~Slot() { Queue->Release(); }
+        };
+
+        std::deque<std::function<void(Ticket)>> m_waiting;
+        std::mutex m_lock;
+        int m_limit;
+        int m_active;
+        // -- A thread is in StartWaiting, anyone else freeing or adding a slot leaves the work to it.
+        bool m_starting;
+
+        void Release();
+        void StartWaiting();
+    };
+}
+#endif //D3PP_ADMISSIONQUEUE_H
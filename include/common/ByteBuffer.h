@@ -4,20 +4,28 @@
 
 #ifndef D3PP_BYTEBUFFER_H
 #define D3PP_BYTEBUFFER_H
+#include <atomic>
+#include <cstddef>
 #include <functional>
-#include <mutex>
+#include <span>
 #include <string>
-#include <atomic>
+#include <vector>
 
-#include "TaskScheduler.h"
-
-class ByteBuffer : public TaskItem {
+// -- Growable ring buffer of bytes. Single producer / single consumer: one thread writes, one thread reads and
+// -- shifts, without locks. Growing reallocates, so a producer that may outgrow the buffer while another thread is
+// -- reading has to hold a lock shared with that consumer (NetworkClient's sendLock does this).
+// -- Reads move a cursor; Shift() releases bytes from the front, including ones already read.
+class ByteBuffer {
 public:
     ByteBuffer(const std::function<void()>& callback);
     ~ByteBuffer();
-    void MainFunc();
+    ByteBuffer(const ByteBuffer&) = delete;
+    ByteBuffer& operator=(const ByteBuffer&) = delete;
+    // -- Bytes held, read or not.
     int Size() const;
+    // -- Bytes held that have not been read yet.
     int ReadSize() const;
+    [[nodiscard]] int Capacity() const { return static_cast<int>(_buffer.size()); }
     // -- Read methods.
     unsigned char PeekByte();
     int PeekIntLE();
@@ -27,28 +35,40 @@ public:
     std::string ReadString();
     std::vector<unsigned char> ReadByteArray();
     std::vector<unsigned char> ReadByte(int length);
+    // -- Copies up to out.size() unread bytes, returns how many were copied.
+    int Read(std::span<unsigned char> out);
+    int Peek(std::span<unsigned char> out) const;
+    // -- Largest contiguous run of unread bytes, valid until the next Shift or write.
+    std::span<const unsigned char> ReadableSpan() const;
     // -- Write methods
     void Write(unsigned char value);
     void Write(short value);
     void Write(int value);
     void Write(std::string value);
     void Write(std::vector<unsigned char> memory, int length);
+    void Write(std::span<const unsigned char> data);
+    // -- Contiguous free space of at least minimum bytes to fill directly (e.g. from recv), published with CommitWrite.
+    std::span<unsigned char> WritableSpan(int minimum);
+    void CommitWrite(int length);
     // -- Control
     void Shift(int size);
     void Purge();
+    // -- Drains everything held. Shrinks oversized storage, so writers must be excluded while it runs.
     std::vector<unsigned char> GetAllBytes();
 protected:
-    static const int initial_size = 1024; // -- Initial allocation size
-    static const int block_size = 128; // -- Size it will be increased at each bump..
+    static const int initial_size = 1024; // -- Initial allocation size, always a power of two.
+    static const int shrink_size = 256 * 1024; // -- Drained buffers above this go back to initial_size.
     std::vector<unsigned char> _buffer;
-    unsigned int _size;
-    unsigned int _readPos;
-    unsigned int _writePos;
-    int _largestAlloc = 0;
-    std::mutex _bufLock;
+    size_t _mask;
+    std::atomic<size_t> _head; // -- Consumer owned: first byte still held.
+    std::atomic<size_t> _tail; // -- Producer owned: one past the last byte written.
+    size_t _readPos; // -- Consumer owned: next byte to read, between _head and _tail.
 private:
-
-    void Resize(int size);
+    void Reserve(size_t length);
+    void Relayout(size_t capacity);
+    void CopyIn(size_t position, const unsigned char* data, size_t length);
+    void CopyOut(size_t position, unsigned char* out, size_t length) const;
+    void CheckReadable(size_t length) const;
     std::function<void()> cbfunc;
 
 };
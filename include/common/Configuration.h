@@ -108,6 +108,20 @@ struct NetworkSettings {
     bool VerifyNames;
     bool Public;
     std::string Salt;
+    int ListenBacklog;
+    int SocketSendBuffer;
+    int SocketReceiveBuffer;
+    std::string IoBackend;
+    int ReactorThreads;
+    int PacketBudget;
+    bool ZeroCopySend;
+    int SendQueueLimit;
+    int ConnectRate;
+    int ConnectBurst;
+    int PacketRate;
+    int PacketBurst;
+    int HandshakeTimeout;
+    bool WebSocket;
 
     void LoadFromJson(json &j) {
         if (j.is_object() && !j["Network"].is_null()) {
@@ -117,6 +131,34 @@ struct NetworkSettings {
             Public = j["Network"]["Public"];
             if (!j["Network"]["Salt"].is_null())
                 Salt = j["Network"]["Salt"];
+            if (!j["Network"]["ListenBacklog"].is_null())
+                ListenBacklog = j["Network"]["ListenBacklog"];
+            if (!j["Network"]["SocketSendBuffer"].is_null())
+                SocketSendBuffer = j["Network"]["SocketSendBuffer"];
+            if (!j["Network"]["SocketReceiveBuffer"].is_null())
+                SocketReceiveBuffer = j["Network"]["SocketReceiveBuffer"];
+            if (!j["Network"]["IoBackend"].is_null())
+                IoBackend = j["Network"]["IoBackend"];
+            if (!j["Network"]["ReactorThreads"].is_null())
+                ReactorThreads = j["Network"]["ReactorThreads"];
+            if (!j["Network"]["PacketBudget"].is_null())
+                PacketBudget = j["Network"]["PacketBudget"];
+            if (!j["Network"]["ZeroCopySend"].is_null())
+                ZeroCopySend = j["Network"]["ZeroCopySend"];
+            if (!j["Network"]["SendQueueLimit"].is_null())
+                SendQueueLimit = j["Network"]["SendQueueLimit"];
+            if (!j["Network"]["ConnectRate"].is_null())
+                ConnectRate = j["Network"]["ConnectRate"];
+            if (!j["Network"]["ConnectBurst"].is_null())
+                ConnectBurst = j["Network"]["ConnectBurst"];
+            if (!j["Network"]["PacketRate"].is_null())
+                PacketRate = j["Network"]["PacketRate"];
+            if (!j["Network"]["PacketBurst"].is_null())
+                PacketBurst = j["Network"]["PacketBurst"];
+            if (!j["Network"]["HandshakeTimeout"].is_null())
+                HandshakeTimeout = j["Network"]["HandshakeTimeout"];
+            if (!j["Network"]["WebSocket"].is_null())
+                WebSocket = j["Network"]["WebSocket"];
         }
     }
 
@@ -127,6 +169,20 @@ struct NetworkSettings {
         j["Network"]["VerifyName"] = VerifyNames;
         j["Network"]["Public"] = Public;
         j["Network"]["Salt"] = Salt;
+        j["Network"]["ListenBacklog"] = ListenBacklog;
+        j["Network"]["SocketSendBuffer"] = SocketSendBuffer;
+        j["Network"]["SocketReceiveBuffer"] = SocketReceiveBuffer;
+        j["Network"]["IoBackend"] = IoBackend;
+        j["Network"]["ReactorThreads"] = ReactorThreads;
+        j["Network"]["PacketBudget"] = PacketBudget;
+        j["Network"]["ZeroCopySend"] = ZeroCopySend;
+        j["Network"]["SendQueueLimit"] = SendQueueLimit;
+        j["Network"]["ConnectRate"] = ConnectRate;
+        j["Network"]["ConnectBurst"] = ConnectBurst;
+        j["Network"]["PacketRate"] = PacketRate;
+        j["Network"]["PacketBurst"] = PacketBurst;
+        j["Network"]["HandshakeTimeout"] = HandshakeTimeout;
+        j["Network"]["WebSocket"] = WebSocket;
     }
 };
 
@@ -0,0 +1,71 @@
+#ifndef D3PP_IOURING_H
+#define D3PP_IOURING_H
+#ifdef __linux__
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include <linux/io_uring.h>
+
+#define IO_URING_DEFAULT_ENTRIES 256
+
+namespace D3PP::Common {
+    enum class IoOperation : unsigned char {
+        Read,
+        Write,
+        Recv,
+        Send,
+        // -- Buffer points to a msghdr that has to stay valid until the completion; Length is ignored.
+        SendMsg
+    };
+
+    struct IoRequest {
+        int Fd;
+        IoOperation Op;
+        void* Buffer;
+        unsigned int Length;
+        int64_t Offset;
+        // -- Bytes transferred, or -errno. Sockets are never waited on, a full/empty socket gives -EAGAIN.
+        int Result;
+    };
+
+    // -- Minimal io_uring submission ring, driven through the raw syscalls so no liburing is needed.
+    // -- Not thread-safe: each thread doing batched I/O owns its own ring.
+    class IoUring {
+    public:
+        explicit IoUring(unsigned int entries = IO_URING_DEFAULT_ENTRIES);
+        ~IoUring();
+        IoUring(const IoUring&) = delete;
+        IoUring& operator=(const IoUring&) = delete;
+
+        [[nodiscard]] bool Available() const { return m_ringFd != -1; }
+        // -- Submits all requests, one io_uring_enter per ring's worth, and waits for every completion.
+        // -- On failure nothing is left in flight: unsubmitted entries are taken back and submitted ones reaped,
+        // -- or the ring is torn down (Available() turns false) if even that fails.
+        bool SubmitAndWait(std::vector<IoRequest>& requests);
+        // -- Whether the running kernel lets us create a ring at all; probed once.
+        static bool Supported();
+    private:
+        int m_ringFd;
+        unsigned int m_entries;
+        void* m_sqRing;
+        size_t m_sqRingSize;
+        void* m_cqRing;
+        size_t m_cqRingSize;
+        io_uring_sqe* m_sqes;
+        size_t m_sqesSize;
+
+        unsigned* m_sqHead;
+        unsigned* m_sqTail;
+        unsigned* m_sqMask;
+        unsigned* m_sqArray;
+        unsigned* m_cqHead;
+        unsigned* m_cqTail;
+        unsigned* m_cqMask;
+        io_uring_cqe* m_cqes;
+
+        bool Enter(unsigned int toSubmit, unsigned int waitFor);
+        void Release();
+    };
+}
+#endif
+#endif //D3PP_IOURING_H
@@ -0,0 +1,39 @@
+#ifndef D3PP_WORKERPOOL_H
+#define D3PP_WORKERPOOL_H
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <queue>
+#include <thread>
+#include <vector>
+
+namespace D3PP::Common {
+    // -- Fixed set of threads working through a shared task queue. The thread count is the concurrency limit
+    // -- and can be changed at runtime, from any thread including the pool's own: new workers are added right away,
+    // -- surplus ones retire once their current task is done. Tasks still queued are run before the pool goes away.
+    class WorkerPool {
+    public:
+        explicit WorkerPool(int threads);
+        ~WorkerPool();
+        WorkerPool(const WorkerPool&) = delete;
+        WorkerPool& operator=(const WorkerPool&) = delete;
+
+        void Submit(const std::function<void()>& task);
+        void SetThreadCount(int threads);
+        [[nodiscard]] int ThreadCount();
+        [[nodiscard]] size_t Pending();
+    private:
+        std::vector<std::thread> m_workers;
+        // -- Workers that left after a shrink; they have nothing left to run and are joined on the next resize.
+        std::vector<std::thread> m_retired;
+        std::queue<std::function<void()>> m_tasks;
+        std::mutex m_lock;
+        std::condition_variable m_wake;
+        size_t m_target;
+        bool m_stopping;
+
+        void JoinRetired();
+        void Run();
+    };
+}
+#endif //D3PP_WORKERPOOL_H
@@ -5,6 +5,12 @@
 #ifndef D3PP_COMPRESSION_H
 #define D3PP_COMPRESSION_H
 #include <string>
+#include <functional>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+struct z_stream_s;
 
 class GZIP {
 public:
@@ -17,5 +23,34 @@ public:
     static bool GZip_CompressToFile(unsigned char *input, int inputLen, std::string filename);
 
     static int GZip_DecompressFromFile(unsigned char *output, int outputLen, std::string filename);
+
+    // -- Streaming variants: data is handed to / pulled from the callback in small chunks, so callers can
+    // -- convert between in-memory and on-disk layouts without holding a second full-size buffer.
+    static bool GZip_CompressToFileStreamed(int64_t inputLen, const std::function<int(unsigned char*, int)>& source, const std::string& filename);
+
+    static int64_t GZip_DecompressFromFileStreamed(const std::function<void(const unsigned char*, int)>& sink, const std::string& filename);
+
+    // -- Parallel variants: the input is cut into blocks that are deflated on all cores and joined into a single
+    // -- gzip member (sync-flushed blocks, combined CRC), so any gzip reader can decompress the result.
+    static int64_t GZip_CompressParallel(std::vector<unsigned char>& output, const unsigned char *input, int64_t inputLen);
+
+    static bool GZip_CompressToFileParallel(int64_t inputLen, const std::function<int(unsigned char*, int)>& source, const std::string& filename);
+};
+
+// -- Incremental gzip writer: input is deflated as it arrives and whatever zlib has produced so far is appended
+// -- to the caller's buffer, so the start of a stream can be sent while the rest is still being compressed.
+// -- raw leaves out the gzip header and trailer, giving a bare deflate stream.
+class GZipStream {
+public:
+    explicit GZipStream(bool raw = false);
+    ~GZipStream();
+    GZipStream(const GZipStream&) = delete;
+    GZipStream& operator=(const GZipStream&) = delete;
+
+    // -- finish flushes everything and writes the trailer, nothing may be written after it.
+    bool Write(const unsigned char *input, int inputLen, bool finish, std::vector<unsigned char>& output);
+private:
+    std::unique_ptr<z_stream_s> m_stream;
+    bool m_valid;
 };
 #endif //D3PP_COMPRESSION_H
@@ -9,6 +9,7 @@
 #define ENTITY_EVENT_DESPAWN "Entity_Delete"
 
 #include "EventSystem.h"
+#include "network/EncodedPacket.h"
 
 
 class EntityEventArgs : public Event {
@@ -20,6 +21,8 @@ public:
     [[nodiscard]] DescriptorType type() const override;
     
     int entityId;
+    // -- Position update as seen by other clients, encoded by the first subscriber and reused by the rest.
+    mutable D3PP::network::SharedPacket encodedPosition;
 
     int Push(lua_State *L);
 };
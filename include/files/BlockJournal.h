@@ -0,0 +1,45 @@
+#ifndef D3PP_BLOCKJOURNAL_H
+#define D3PP_BLOCKJOURNAL_H
+#include <cstdio>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <string>
+#include "common/Vectors.h"
+
+namespace D3PP::files {
+#define D3_MAP_JOURNAL_NAME "Block-Journal.bin"
+
+    struct BlockJournalEntry {
+        Common::Vector3S Location;
+        unsigned char Type;
+        short Player;
+        int64_t Time;
+    };
+
+    // -- Append-only log of block changes made since the last full block snapshot.
+    // -- Records are fixed size with a trailing check byte, so a torn final write is simply ignored on replay.
+    class BlockJournal {
+    public:
+        explicit BlockJournal(const std::string& folder);
+        ~BlockJournal();
+
+        bool Append(const Common::Vector3S& location, unsigned char type, short player);
+        // -- Marks the block layer as replaced wholesale. Replay stops here: later records belong to a layer
+        // -- that only a snapshot taken after the barrier holds, and such a snapshot truncates the barrier away.
+        bool AppendBarrier();
+        bool Sync();
+        // -- Drops the records before offset (as returned by Size()) that are now covered by a snapshot.
+        bool Truncate(int64_t offset);
+        int Replay(const std::function<void(const BlockJournalEntry&)>& apply);
+        [[nodiscard]] int64_t Size();
+    private:
+        std::string m_fileName;
+        std::FILE* m_file;
+        std::mutex m_lock;
+        int64_t m_size;
+
+        bool Open();
+    };
+}
+#endif //D3PP_BLOCKJOURNAL_H
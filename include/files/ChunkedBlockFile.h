@@ -0,0 +1,82 @@
+#ifndef D3PP_CHUNKEDBLOCKFILE_H
+#define D3PP_CHUNKEDBLOCKFILE_H
+#include <cstdio>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+#include "common/Vectors.h"
+
+namespace D3PP::Common {
+    class IoUring;
+}
+
+namespace D3PP::files {
+#define D3_MAP_CHUNKED_BLOCKS_NAME "Data-Layer.d3c"
+#define D3_MAP_CHUNKED_VERSION 2
+#define D3_MAP_CHUNKED_READ_BATCH 64
+
+    struct ChunkedFileHeader {
+        char Magic[4];
+        uint32_t Version;
+        int16_t SizeX, SizeY, SizeZ;
+        uint16_t Reserved;
+        uint32_t ChunkBlocks;
+        uint32_t ChunkCount;
+        uint64_t IndexOffset;
+        uint32_t IndexCrc;
+        uint32_t Padding;
+    };
+
+    struct ChunkIndexEntry {
+        uint64_t Offset;
+        uint32_t Length;
+        uint32_t Crc;
+    };
+
+    // -- Version 2 block layer: the interleaved D3 block data (4 bytes per block) split into fixed-size runs of blocks,
+    // -- each zlib-compressed on its own and located through an index, so single chunks can be read, verified or replaced.
+    // -- Rewritten chunks and their index are appended; the header's index pointer is flipped last,
+    // -- so an interrupted save always leaves the previous index and the chunks it references intact.
+    class ChunkedBlockFile {
+    public:
+        explicit ChunkedBlockFile(const std::string& fileName);
+        ~ChunkedBlockFile();
+        ChunkedBlockFile(const ChunkedBlockFile&) = delete;
+        ChunkedBlockFile& operator=(const ChunkedBlockFile&) = delete;
+
+        bool Create(const Common::Vector3S& size, int chunkBlocks);
+        bool Open();
+        void Close();
+
+        bool ReadChunk(int chunk, std::vector<unsigned char>& data);
+        // -- Reads and verifies chunks [first, first + count), fetching all of them in one batch where io_uring is available.
+        bool ReadChunks(int first, int count, std::vector<std::vector<unsigned char>>& chunks);
+        bool WriteChunk(int chunk, const unsigned char* data, int length);
+        bool Commit();
+        bool Verify();
+
+        [[nodiscard]] Common::Vector3S GetSize() const;
+        [[nodiscard]] int ChunkBlocks() const { return static_cast<int>(m_header.ChunkBlocks); }
+        [[nodiscard]] int ChunkCount() const { return static_cast<int>(m_header.ChunkCount); }
+        [[nodiscard]] int ChunkLength(int chunk) const;
+        [[nodiscard]] int64_t FileSize() const { return m_fileSize; }
+        // -- Bytes taken up by chunk versions and indices that are no longer referenced.
+        [[nodiscard]] int64_t DeadBytes() const;
+    private:
+        std::string m_fileName;
+        std::FILE* m_file;
+        ChunkedFileHeader m_header;
+        std::vector<ChunkIndexEntry> m_index;
+        int64_t m_fileSize;
+#ifdef __linux__
+        std::unique_ptr<Common::IoUring> m_ring;
+#endif
+
+        bool Seek(int64_t offset);
+        bool Inflate(int chunk, const std::vector<unsigned char>& compressed, std::vector<unsigned char>& data);
+        bool Sync();
+        [[nodiscard]] uint32_t IndexCrc() const;
+    };
+}
+#endif //D3PP_CHUNKEDBLOCKFILE_H
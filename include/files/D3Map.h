@@ -1,6 +1,9 @@
 #pragma once
 #include <string>
 #include <vector>
+#include <atomic>
+#include <mutex>
+#include <unordered_map>
 #include "common/Vectors.h"
 #include "common/MinecraftLocation.h"
 #include "common/PreferenceLoader.h"
@@ -13,6 +16,7 @@ namespace D3PP::files {
 #define D3_MAP_PORTALS_NAME "Teleporter.txt"
 #define D3_MAP_PARTICLES_NAME "Particles.txt"
 #define D3_MAP_FILE_VERSION 1050
+#define D3_MAP_CHUNK_BLOCKS 16384 // -- Blocks per copy-on-write snapshot chunk and per chunk of the v2 block layer
 
 		enum D3OverviewType {
 			None,
@@ -83,19 +87,39 @@ namespace D3PP::files {
 			int cloudHeight{}, maxFogDistance{}, cloudSpeed{}, weatherSpeed{}, weatherFade{}, expoFog{}, mapSideOffset{};
 
 			D3OverviewType OverviewType;
-			std::vector<unsigned char> MapData;
+			// -- Block storage is kept as separate planes so that hot paths (GetBlock, map send, physics)
+			// -- only touch the type bytes. Metadata and last-player planes are empty when disabled.
+			std::vector<unsigned char> BlockTypes;
+			std::vector<unsigned char> BlockMetadata;
+			std::vector<short> BlockLastPlayer;
+			bool StoreMetadata{true}, StoreLastPlayer{true};
+			// -- Set by providers that keep their own block storage; the block layer is then neither allocated, read nor written.
+			bool ExternalBlockLayer{false};
+			// -- Block layer is kept in the chunked v2 file (D3_MAP_CHUNKED_BLOCKS_NAME) instead of Data-Layer.gz.
+			// -- Set when such a file is loaded; use ConvertBlockLayer() to switch an existing map.
+			bool ChunkedFormat{false};
             std::map<std::string, MapTeleporterElement> Teleporter;
             std::vector<MapRankElement> RankBoxes;
             std::vector<D3PP::world::CustomParticle> Particles;
 			// -----------------------
 			D3Map(const std::string& folder);
-			D3Map(const std::string& folder, const std::string& name, const Common::Vector3S& mapSize);
+			// -- With externalBlockLayer only the config side is set up, the block planes are never allocated.
+			D3Map(const std::string& folder, const std::string& name, const Common::Vector3S& mapSize, bool externalBlockLayer = false);
 
 			bool Load();
 			bool Load(std::string path);
 			bool Save();
 			bool Save(std::string path);
+			bool SaveWithoutBlocks();
 			void Resize(Common::Vector3S newSize);
+			void SetBlocks(const std::vector<unsigned char>& types);
+			void ClearBlocks();
+			void ConvertBlockLayer(bool chunked);
+			// -- Warm unload: the planes are swapped for a fast in-memory compressed copy while config, portals and
+			// -- particles stay resident. Returns the bytes kept, or -1 if the block layer can't be compacted.
+			int64_t CompactBlocks();
+			bool ExpandBlocks();
+			[[nodiscard]] bool IsCompacted() const { return !m_compactedBlocks.empty(); }
 
 			unsigned char GetBlock(Common::Vector3S blockLocation);
 			unsigned char GetBlockMetadata(Common::Vector3S blockLocation);
@@ -111,17 +135,49 @@ namespace D3PP::files {
             std::vector<D3PP::world::CustomParticle> GetParticles();
             void SetParticles(std::vector<D3PP::world::CustomParticle> particles);
 		private:
-            bool configChanged, portalsChanged, rboxChanged, dataChanged, particleChanged;
+            bool configChanged, portalsChanged, rboxChanged, particleChanged;
+            std::atomic<bool> dataChanged;
+
+            // -- Copy-on-write snapshot used by SaveMapData. Chunks still carrying an older epoch are copied
+            // -- by the first writer that touches them; chunks the saver has already written are left alone.
+            struct SnapshotChunk {
+                std::vector<unsigned char> Types;
+                std::vector<unsigned char> Metadata;
+                std::vector<short> LastPlayer;
+            };
+            // -- Writers check and preserve under m_snapshotLock, so none can slip a change past BeginSnapshot.
+            bool m_snapshotActive{false};
+            std::mutex m_snapshotLock;
+            unsigned int m_snapshotEpoch{0};
+            std::vector<unsigned int> m_chunkEpochs;
+            std::unordered_map<int, SnapshotChunk> m_snapshotChunks;
+
+            void BeginSnapshot();
+            void EndSnapshot();
+            void PreserveChunk(int chunk);
+            void CopyChunk(int chunk, SnapshotChunk& target);
+            bool TakeSnapshotChunk(int chunk, SnapshotChunk& target);
+
+            // -- Chunks changed since the v2 file was last written; only these are rewritten while the file is current.
+            std::vector<unsigned char> m_compactedBlocks;
+            std::vector<unsigned char> m_chunkDirty;
+            std::string m_chunkFileName;
+            bool m_chunkFileCurrent{false};
+
+            void MarkChunkDirty(int index);
+            void ResetChunkTracking(bool dirty);
 
 			std::string GenerateUuid();
 			bool SaveConfig();
 			bool SavePortals();
 			bool SaveRankBoxes();
 			bool SaveMapData();
+			bool SaveChunkedData();
             bool SaveParticles();
 
 			bool ReadConfig();
 			bool ReadMapData();
+			bool ReadChunkedData();
 			void ReadPortals();
 			void ReadRankBoxes();
             void ReadParticles();
@@ -8,7 +8,7 @@
 class GenTools {
     public:
     static int GetIndex(int x, int y, int z, int mapX, int mapY) {
-        return (x + y * mapX + z * mapX * mapY) * 4;
+        return x + y * mapX + z * mapX * mapY;
     }
 
 static void FlatgrassGen(int mapId) {
@@ -21,7 +21,7 @@ static void FlatgrassGen(int mapId) {
 
     D3PP::Common::Vector3S mapSize = thisMap->GetSize();
      std::vector<unsigned char> newBlocks;
-     newBlocks.resize((mapSize.X * mapSize.Y * mapSize.Z) * 4);
+     newBlocks.resize(mapSize.X * mapSize.Y * mapSize.Z);
 
     for(int x = 0; x < mapSize.X; x++) {
         for (int y = 0; y < mapSize.Y; y++) {
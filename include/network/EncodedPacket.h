@@ -0,0 +1,25 @@
+#ifndef D3PP_ENCODEDPACKET_H
+#define D3PP_ENCODEDPACKET_H
+#include <memory>
+#include <vector>
+
+namespace D3PP::network {
+    class IPacket;
+    class EncodedPacket;
+    typedef std::shared_ptr<const EncodedPacket> SharedPacket;
+
+    // -- Wire bytes of one or more packets. Immutable once built, so a broadcast encodes it once
+    // -- and every recipient's send queue holds a reference to the same bytes.
+    class EncodedPacket {
+    public:
+        explicit EncodedPacket(std::vector<unsigned char> data) : m_data(std::move(data)) {}
+        static SharedPacket Encode(IPacket& packet);
+        static SharedPacket FromBytes(std::vector<unsigned char> data);
+
+        [[nodiscard]] const unsigned char* Data() const { return m_data.data(); }
+        [[nodiscard]] size_t Size() const { return m_data.size(); }
+    private:
+        const std::vector<unsigned char> m_data;
+    };
+}
+#endif //D3PP_ENCODEDPACKET_H
@@ -0,0 +1,27 @@
+#ifndef D3PP_IBULKSOURCE_H
+#define D3PP_IBULKSOURCE_H
+#include <functional>
+
+#include "network/EncodedPacket.h"
+
+namespace D3PP::network {
+    // -- Bulk output produced on demand. The client's shard thread pulls the next packet whenever its Bulk lane
+    // -- runs low, so a stream is generated at the pace the socket takes it instead of being queued up front.
+    class IBulkSource {
+    public:
+        IBulkSource()= default;
+        virtual ~IBulkSource()= default;
+        // -- Next packet of the stream, nullptr if none is ready yet or the stream ended.
+        virtual SharedPacket Next() = 0;
+        // -- True once Next won't return anything again.
+        virtual bool Ended() = 0;
+        // -- wake may be called from any thread once Next has something again after it returned nullptr.
+        virtual void SetWake(const std::function<void()>& wake) = 0;
+        // -- Fence that ends the stream, nullptr if the stream failed.
+        virtual SharedPacket Closing() = 0;
+        // -- Runs on the shard thread once the stream ended, complete is false if it failed.
+        // -- A stream replaced by another one is dropped without it.
+        virtual void Finished(bool complete) = 0;
+    };
+}
+#endif //D3PP_IBULKSOURCE_H
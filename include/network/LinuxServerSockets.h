@@ -9,42 +9,56 @@
 #include <memory>
 #include <unistd.h>
 #include <sys/socket.h>
-#include <sys/select.h>
+#include <sys/epoll.h>
 #include <netdb.h>
 #include <vector>
 #include <map>
 
-#define MAXIMUM_CONNECTIONS 255
+#define SOCKET_MAX_EVENTS 256
+#define SOCKET_DEFAULT_BACKLOG 128
 
 enum ServerSocketEvent {
     SOCKET_EVENT_NONE,
     SOCKET_EVENT_CONNECT,
     SOCKET_EVENT_DATA,
-    SOCKET_EVENT_DISCONNECT
+    SOCKET_EVENT_DISCONNECT,
+    SOCKET_EVENT_WRITABLE
 };
 
 class Sockets;
 
+// -- Edge-triggered epoll reactor: the listen socket and every accepted client are non-blocking,
+// -- so each readiness event has to be drained (Accept until nullptr, Read until it would block).
+// -- A default-constructed ServerSocket only polls, accepted clients are handed to it with Adopt().
 class ServerSocket {
 public:
     ServerSocket();
     ServerSocket(int port);
+    ~ServerSocket();
     void Init(int port);
     void Listen();
-    std::map<ServerSocketEvent, std::vector<int>> CheckEvents();
+    // -- Blocks for up to timeoutMs (or until Wake()) and returns the sockets that became ready.
+    std::map<ServerSocketEvent, std::vector<int>> CheckEvents(int timeoutMs);
+    // -- Returns nullptr once there are no pending connections left. The client still has to be Adopt()ed by a poller.
     std::unique_ptr<Sockets> Accept();
+    // -- Starts watching an accepted client; epoll_ctl is thread-safe, so any thread may hand clients over.
+    void Adopt(int fd) const;
     [[nodiscard]] int GetEventSocket() const;
+    // -- Interrupts a CheckEvents() in progress, callable from any thread.
+    void Wake() const;
     void Unaccept(int fd);
     void Stop();
 private:
     bool hasInit;
     int listenPort;
     int listenSocket;
-    int clientSockets[MAXIMUM_CONNECTIONS];
+    int epollSocket;
     int eventSocket;
     struct sockaddr_in server, address;
 
-    fd_set readfds;
+    bool CreatePoller();
+    void Watch(int fd, unsigned int events) const;
+    void ConfigureClient(int fd) const;
 };
 #endif //D3PP_LINUXSERVERSOCKETS_H
-#endif
\ No newline at end of file
+#endif
@@ -5,11 +5,17 @@
 #ifndef D3PP_LINUXSOCKETS_H
 #define D3PP_LINUXSOCKETS_H
 
+#include <span>
 #include <string>
 #include <unistd.h>
 #include <sys/socket.h>
 #include <netdb.h>
 
+// -- Returned by Read/Send on a non-blocking socket that has nothing to read or no room to write.
+#define SOCKET_WOULD_BLOCK (-2)
+// -- Most slices handed to one SendVectored call.
+#define SOCKET_MAX_SLICES 64
+
 class Sockets
 {
     public:
@@ -21,6 +27,12 @@ class Sockets
         void Disconnect();
         int Read(char* buffer, int size);
         int Send(char* data, int size);
+        // -- Sends the slices in order with a single sendmsg. With zeroCopy the kernel pins the pages instead of
+        // -- copying them, so the caller has to keep them alive until ReapZeroCopy reports that send finished.
+        int SendVectored(const std::span<const unsigned char>* slices, int count, bool zeroCopy);
+        bool EnableZeroCopy();
+        // -- Zero-copy sends are numbered from 0 per socket; reports one finished range [first, last] per call.
+        bool ReapZeroCopy(unsigned int& first, unsigned int& last);
 
         // -- Getters
         unsigned int GetCounter() { return m_Counter; }
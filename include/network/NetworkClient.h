@@ -6,12 +6,30 @@
 #define D3PP_NETWORKCLIENT_H
 #define MAX_SELECTION_BOXES 255
 #define CONSOLE_CLIENT_ID -200
+// -- Smaller flushes are copied; pinning pages only pays off for bulk output such as map data.
+#define NETWORK_ZEROCOPY_MIN_BYTES 32768
+// -- Seconds a client may leave queued output unread before it is dropped.
+#define NETWORK_SEND_STALL_TIMEOUT 30
+// -- A bulk stream is pulled whenever less than this much of it is queued.
+#define NETWORK_BULK_LOW_WATER 65536
 #include <string>
 #include <memory>
 #include <mutex>
 #include <map>
 #include <vector>
 #include <atomic>
+#include <deque>
+#include <span>
+#ifdef __linux__
+#include <sys/uio.h>
+#include "network/LinuxSockets.h"
+#endif
+
+#include "network/EncodedPacket.h"
+#include "network/IBulkSource.h"
+#include "network/OutboundQueue.h"
+#include "network/RateLimit.h"
+#include "network/WebSocket.h"
 
 class Sockets;
 class ByteBuffer;
@@ -20,13 +38,10 @@ class Entity;
 class Event;
 struct BlockDefinition;
 
-namespace D3PP::network {
-    class IPacket;
-}
-
 namespace D3PP::Common {
     struct UndoItem;
     struct Vector3S;
+    struct IoRequest;
 }
 
 namespace D3PP::world {
@@ -55,9 +70,16 @@ public:
     virtual void DespawnEntity(std::shared_ptr<Entity> e) = 0;
     virtual bool IsDataAvailable() = 0;
     virtual void NotifyDataAvailable() = 0;
+    virtual void NotifyWritable() = 0;
     virtual void SendQueued() = 0;
     virtual void HandleData() = 0;
+    virtual bool HasPendingInput() = 0;
     virtual void SendPacket(D3PP::network::IPacket& p) = 0;
+    // -- Queues an already encoded packet by reference, see EncodedPacket and OutboundQueue for lane, key and fence.
+    virtual void SendShared(const D3PP::network::SharedPacket& packet, D3PP::network::SendLane lane = D3PP::network::SendLane::Control, int key = -1, bool fence = false) = 0;
+    // -- Sends source's packets on the Bulk lane as the socket drains, replacing any stream still running.
+    // -- Everything queued after this call waits for the stream's closing fence.
+    virtual void StreamBulk(const std::shared_ptr<D3PP::network::IBulkSource>& source) = 0;
     virtual void Undo(int steps) = 0;
     virtual void Redo(int steps) = 0;
     virtual void AddUndoItem(const D3PP::Common::UndoItem& item) = 0;
@@ -91,7 +113,8 @@ public:
     int CustomExtensions;
     int CustomBlocksLevel;
     bool GlobalChat;
-
+    // -- Index of the reactor thread that owns this client's socket.
+    int Shard;
 
 
     std::map<std::string, int> Extensions;
@@ -123,20 +146,54 @@ public:
     void SendQueued() override;
     void HandleData() override;
     void SendPacket(D3PP::network::IPacket& p) override;
+    void SendShared(const D3PP::network::SharedPacket& packet, D3PP::network::SendLane lane = D3PP::network::SendLane::Control, int key = -1, bool fence = false) override;
+    void StreamBulk(const std::shared_ptr<D3PP::network::IBulkSource>& source) override;
     void Undo(int steps) override;
     void Redo(int steps) override;
     void AddUndoItem(const D3PP::Common::UndoItem& item) override;
     void NotifyDataAvailable() override;
+    void NotifyWritable() override;
+    bool HasPendingInput() override;
     bool GetLoggedIn() override;
     std::shared_ptr<D3PP::world::IMinecraftPlayer> GetPlayerInstance() override;
 
     std::shared_ptr<NetworkClient> GetSelfPointer() const;
+    // -- Batched socket I/O (io_uring backend): queue this tick's recv/send, then consume each completion.
+    void PrepareIo(std::vector<D3PP::Common::IoRequest>& requests);
+    void CompleteIo(const D3PP::Common::IoRequest& request);
 private:
     int Id;
     int eventSubId, addSubId, removeSubId, m_currentUndoIndex;
     std::vector<D3PP::Common::UndoItem> m_undoItems;
     std::atomic<bool> DataAvailable;
     std::atomic<bool> DataWaiting;
+    std::atomic<bool> WriteBlocked;
+    bool InputBacklog;
+    // -- Inbound packet rate limit, checked before each packet is dispatched.
+    D3PP::network::TokenBucket PacketBucket;
+    std::chrono::steady_clock::time_point ConnectedAt;
+    // -- Set once the client turned out to speak WebSocket; WebSocketInput then holds the unwrapped stream.
+    std::unique_ptr<D3PP::network::WebSocketCodec> WebSocket;
+    std::shared_ptr<ByteBuffer> WebSocketInput;
+    // -- Outgoing packets by priority, guarded by sendLock. SendBuffer's contents always come after these.
+    D3PP::network::OutboundQueue Outbound;
+    // -- Set once the queue passed SendQueueLimit; the client is dropped on its next tick.
+    bool SendOverflow;
+    // -- Last time the socket took bytes, or the queue went from empty to busy.
+    time_t LastSendProgress;
+    // -- Open Bulk stream, guarded by sendLock. Only the shard thread pulls from it.
+    std::shared_ptr<D3PP::network::IBulkSource> BulkSource;
+    // -- The stream had nothing ready when last asked; it wakes the client once it has.
+    bool BulkStarved;
+    // -- MSG_ZEROCOPY: packets the kernel may still read from, tagged with the send that pinned them.
+    bool ZeroCopy;
+    unsigned int ZeroCopySequence;
+    std::deque<std::pair<unsigned int, D3PP::network::SharedPacket>> ZeroCopyHeld;
+#ifdef __linux__
+    // -- Vectored send in flight on the io_uring backend.
+    struct iovec SendIov[SOCKET_MAX_SLICES];
+    struct msghdr SendMessage;
+#endif
     std::unique_ptr<Sockets> clientSocket;
     std::shared_ptr<D3PP::world::IMinecraftPlayer> player;
     std::vector<unsigned char> Selections;
@@ -148,6 +205,14 @@ private:
     bool ReadData();
     void MainFunc();
     void DataReady();
+    void QueueSendBuffer();
+    void RefillBulk();
+    void WakeBulk();
+    [[nodiscard]] bool NeedsBulk() const;
+    bool ReadWebSocket();
+    int GatherFramed(std::span<const unsigned char>* slices, size_t& total, std::vector<D3PP::network::SharedPacket>* owners);
+    void QueueOutbound(const D3PP::network::SharedPacket& packet, D3PP::network::SendLane lane, int key, bool fence);
+    void ReleaseZeroCopy();
     void OutputPing();
 };
 #endif //D3PP_NETWORKCLIENT_H
@@ -0,0 +1,59 @@
+#ifndef D3PP_NETWORKSHARD_H
+#define D3PP_NETWORKSHARD_H
+#include <atomic>
+#include <functional>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+class ServerSocket;
+class IMinecraftClient;
+
+namespace D3PP::Common {
+    class IoUring;
+}
+
+namespace D3PP::network {
+    // -- One reactor thread with its own poller and its own set of clients. Reads, packet handling and
+    // -- socket writes for those clients only ever happen on this thread; other threads only append to a
+    // -- client's send queue, which keeps every client's packets in the order they were sent.
+    class NetworkShard {
+    public:
+        NetworkShard(int index, std::unique_ptr<ServerSocket> socket);
+        ~NetworkShard();
+        NetworkShard(const NetworkShard&) = delete;
+        NetworkShard& operator=(const NetworkShard&) = delete;
+
+        // -- onConnect runs when the shard's poller reports the listen socket, onTick once per loop.
+        void Start(const std::function<void()>& onConnect, const std::function<void()>& onTick);
+        void Join();
+        void Add(const std::shared_ptr<IMinecraftClient>& client, int fd);
+        void Remove(int clientId);
+        void Wake() const;
+        [[nodiscard]] int Index() const { return m_index; }
+        [[nodiscard]] size_t ClientCount();
+        [[nodiscard]] ServerSocket* Socket() const { return m_socket.get(); }
+    private:
+        int m_index;
+        std::unique_ptr<ServerSocket> m_socket;
+#ifdef __linux__
+        std::unique_ptr<D3PP::Common::IoUring> m_ioRing;
+#endif
+        std::thread m_thread;
+        std::function<void()> m_onConnect;
+        std::function<void()> m_onTick;
+
+        std::mutex m_clientLock;
+        std::map<int, std::shared_ptr<IMinecraftClient>> m_clients;
+        std::atomic<bool> m_needsUpdate;
+        // -- Only touched by the shard thread.
+        std::vector<std::shared_ptr<IMinecraftClient>> m_roClients;
+
+        void Run();
+        void HandleEvents(int timeoutMs);
+        void HandleBatchedIo();
+    };
+}
+#endif //D3PP_NETWORKSHARD_H
@@ -5,9 +5,12 @@
 #ifndef D3PP_NETWORK_FUNCTIONS_H
 #define D3PP_NETWORK_FUNCTIONS_H
 #include <string>
+#include <vector>
 
 #include "common/MinecraftLocation.h"
+#include "common/Vectors.h"
 #include "network/IPacket.h"
+#include "network/EncodedPacket.h"
 
 class NetworkFunctions {
 public:
@@ -18,10 +21,13 @@ public:
     // -- Map
     static void NetworkOutBlockSet(const int& clientId, const short& x, const short& y, const short& z, const unsigned char& type);
     static void NetworkOutBlockSet2Map(const int& mapId, const unsigned short& x, const unsigned short& y, const unsigned short& z, const unsigned char& type);
+    // -- Sends a batch of changes, as BulkBlockUpdates to clients supporting it and SetBlocks to the rest.
+    static void NetworkOutBlockSets2Map(const int& mapId, const D3PP::Common::Vector3S& mapSize, const std::vector<D3PP::Common::Vector3S>& locations, const std::vector<unsigned char>& types);
     // -- Player
     static void NetworkOutEntityAdd(const int& clientId, const char& playerId, const std::string& name, const MinecraftLocation& location);
     static void NetworkOutEntityDelete(const int& clientId, const char& playerId);
     static void NetworkOutEntityPosition(const int& clientId, const char& playerId, const MinecraftLocation& location);
+    static D3PP::network::SharedPacket EncodeEntityPosition(const char& playerId, const MinecraftLocation& location);
     static void PacketToMap(const int& mapId, D3PP::network::IPacket& p, std::string reqExt = "", int reqVer = 0);
 };
 #endif //D3PP_NETWORK_FUNCTIONS_H
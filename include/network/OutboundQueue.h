@@ -0,0 +1,78 @@
+#ifndef D3PP_OUTBOUNDQUEUE_H
+#define D3PP_OUTBOUNDQUEUE_H
+#include <array>
+#include <cstdint>
+#include <deque>
+#include <span>
+#include <vector>
+
+#include "network/EncodedPacket.h"
+
+namespace D3PP::network {
+    // -- Outbound lanes, highest priority first.
+    enum class SendLane : unsigned char {
+        Control, // -- Chat, pings, kicks and everything written to a client's SendBuffer.
+        Block, // -- Block changes. Never overtake map data, they belong to the map being sent.
+        Movement, // -- Entity positions, coalesced per entity while they wait.
+        Bulk // -- Map transfer.
+    };
+
+    // -- A client's pending output split into priority lanes. Higher lanes go first, except that a fence
+    // -- (level init / finalize) is a full barrier: nothing queued after it is sent before it, and it waits
+    // -- for everything queued before it. Not thread-safe, NetworkClient guards it with sendLock.
+    class OutboundQueue {
+    public:
+        OutboundQueue();
+        // -- key >= 0 on the Movement lane replaces an unsent update with the same key instead of queueing another,
+        // -- unless a fence was queued since.
+        void Push(const SharedPacket& packet, SendLane lane, int key = -1, bool fence = false);
+        // -- Fills slices in send order (max at most). The next Advance consumes from exactly these packets;
+        // -- until then they are neither replaced nor dropped. owners, if given, receives the packets behind the slices.
+        int Gather(std::span<const unsigned char>* slices, int max, size_t& total, std::vector<SharedPacket>* owners = nullptr);
+        // -- Consumes sent bytes from the last Gather, a partly sent packet stays first in line.
+        void Advance(size_t sent);
+        void Clear();
+
+        // -- Opens a Bulk stream: a fence whose packet is not known yet. Anything queued after it waits for it,
+        // -- while PushStream puts packets in front of it. Only one stream is open at a time.
+        void OpenStream();
+        void PushStream(const SharedPacket& packet);
+        // -- Gives the stream's fence its packet, or drops the fence if closing is nullptr.
+        void CloseStream(const SharedPacket& closing);
+
+        [[nodiscard]] bool Empty() const { return m_queuedBytes == 0; }
+        [[nodiscard]] size_t QueuedBytes() const { return m_queuedBytes; }
+        // -- Bytes outside the Bulk lane, what backpressure limits apply to.
+        [[nodiscard]] size_t InteractiveBytes() const { return m_queuedBytes - m_laneBytes[static_cast<int>(SendLane::Bulk)]; }
+        [[nodiscard]] size_t LaneBytes(SendLane lane) const { return m_laneBytes[static_cast<int>(lane)]; }
+        [[nodiscard]] bool StreamOpen() const { return m_streamOpen; }
+    private:
+        struct QueuedPacket {
+            SharedPacket Packet;
+            uint64_t Sequence;
+            int Key;
+            bool Fence;
+        };
+        static constexpr int LaneCount = 4;
+
+        std::array<std::deque<QueuedPacket>, LaneCount> m_lanes;
+        std::array<size_t, LaneCount> m_laneBytes;
+        // -- Sequences of fences still queued, oldest first.
+        std::deque<uint64_t> m_fences;
+        // -- Packet whose first bytes already went out; always continued before anything else.
+        QueuedPacket m_partial;
+        int m_partialLane;
+        size_t m_partialOffset;
+        // -- Lanes the last Gather took from, in order, and how many it took from each.
+        std::vector<int> m_gathered;
+        std::array<size_t, LaneCount> m_gatheredCount;
+        uint64_t m_nextSequence;
+        size_t m_queuedBytes;
+        bool m_streamOpen;
+
+        bool CanSend(int lane, const std::array<size_t, LaneCount>& cursor, size_t fenceCursor) const;
+        void PopFront(int lane);
+        std::deque<QueuedPacket>::iterator StreamFence();
+    };
+}
+#endif //D3PP_OUTBOUNDQUEUE_H
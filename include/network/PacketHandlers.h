@@ -9,18 +9,22 @@
 
 class NetworkClient;
 
+namespace D3PP::network {
+    class PacketReader;
+}
+
 class PacketHandlers {
 public:
-    static void HandleHandshake(const std::shared_ptr<NetworkClient>& client);
-    static void HandlePing(const std::shared_ptr<NetworkClient>& client);
-    static void HandleBlockChange(const std::shared_ptr<NetworkClient>& client);
-    static void HandlePlayerTeleport(const std::shared_ptr<NetworkClient>& client);
-    static void HandleChatPacket(const std::shared_ptr<NetworkClient>& client);
-    static void HandleExtInfo(const std::shared_ptr<NetworkClient>& client);
-    static void HandleExtEntry(const std::shared_ptr<NetworkClient>& client);
-    static void HandleCustomBlockSupportLevel(const std::shared_ptr<NetworkClient>& client);
-    static void HandlePlayerClicked(const std::shared_ptr<NetworkClient>& client);
-    static void HandleTwoWayPing(const std::shared_ptr<NetworkClient>& client);
+    static void HandleHandshake(const std::shared_ptr<NetworkClient>& client, D3PP::network::PacketReader& reader);
+    static void HandlePing(const std::shared_ptr<NetworkClient>& client, D3PP::network::PacketReader& reader);
+    static void HandleBlockChange(const std::shared_ptr<NetworkClient>& client, D3PP::network::PacketReader& reader);
+    static void HandlePlayerTeleport(const std::shared_ptr<NetworkClient>& client, D3PP::network::PacketReader& reader);
+    static void HandleChatPacket(const std::shared_ptr<NetworkClient>& client, D3PP::network::PacketReader& reader);
+    static void HandleExtInfo(const std::shared_ptr<NetworkClient>& client, D3PP::network::PacketReader& reader);
+    static void HandleExtEntry(const std::shared_ptr<NetworkClient>& client, D3PP::network::PacketReader& reader);
+    static void HandleCustomBlockSupportLevel(const std::shared_ptr<NetworkClient>& client, D3PP::network::PacketReader& reader);
+    static void HandlePlayerClicked(const std::shared_ptr<NetworkClient>& client, D3PP::network::PacketReader& reader);
+    static void HandleTwoWayPing(const std::shared_ptr<NetworkClient>& client, D3PP::network::PacketReader& reader);
 };
 
 
@@ -0,0 +1,42 @@
+#ifndef D3PP_PACKETREADER_H
+#define D3PP_PACKETREADER_H
+#include <span>
+#include <string>
+
+// -- Longest packet a client sends (the handshake).
+#define NETWORK_MAX_INBOUND_PACKET 131
+
+namespace D3PP::network {
+    // -- Total length (opcode included) of every packet a client may send, or -1 for opcodes we don't accept.
+    int InboundPacketLength(unsigned char opcode);
+
+    // -- Decodes big-endian fields straight out of one complete packet. The caller checked the length against
+    // -- InboundPacketLength first, so reads don't bounds-check.
+    class PacketReader {
+    public:
+        explicit PacketReader(std::span<const unsigned char> data) : m_data(data), m_position(0) {}
+
+        unsigned char ReadByte() { return m_data[m_position++]; }
+
+        short ReadShort() {
+            auto result = static_cast<short>((m_data[m_position] << 8) | m_data[m_position + 1]);
+            m_position += 2;
+            return result;
+        }
+
+        int ReadInt() {
+            int result = (m_data[m_position] << 24) | (m_data[m_position + 1] << 16) | (m_data[m_position + 2] << 8) | m_data[m_position + 3];
+            m_position += 4;
+            return result;
+        }
+
+        // -- Classic strings: 64 bytes, space padded. Trimmed the same way ByteBuffer::ReadString trims.
+        std::string ReadString();
+
+        [[nodiscard]] size_t Remaining() const { return m_data.size() - m_position; }
+    private:
+        std::span<const unsigned char> m_data;
+        size_t m_position;
+    };
+}
+#endif //D3PP_PACKETREADER_H
@@ -4,10 +4,15 @@
 
 #ifndef D3PP_PACKETS_H
 #define D3PP_PACKETS_H
+#define BULK_BLOCK_UPDATE_MAX 256
+// -- Fewer changes than this go as SetBlocks: they fit one gathered send and are far smaller than a padded
+// -- BulkBlockUpdate (8 bytes each against 1282).
+#define BULK_BLOCK_UPDATE_MIN 64
 
 #include <string>
 #include <memory>
 #include "CustomBlocks.h"
+#include "network/EncodedPacket.h"
 
 class IMinecraftClient;
 class NetworkClient;
@@ -15,7 +20,8 @@ class NetworkClient;
 class Packets {
 public:
     static void SendClientHandshake(int clientId, char protocolVersion, std::string serverName, std::string serverMotd, char userType);
-    static void SendMapInit(int clientId);
+    // -- With FastMap the volume rides along in the init and the level data is raw deflate.
+    static void SendMapInit(int clientId, int fastMapVolume = -1);
     static void SendMapData(int clientId, short chunkSize, char* data, unsigned char percentComplete);
     static void SendMapFinalize(int clientId, short sizeX, short sizeY, short sizeZ);
     static void SendBlockChange(int clientId, short x, short y, short z, unsigned char type);
@@ -47,5 +53,16 @@ public:
     static void SendDefineBlock(const std::shared_ptr<NetworkClient>& client, BlockDefinition def);
     static void SendRemoveBlock(const std::shared_ptr<NetworkClient>& client, unsigned char blockId);
     static void SendDefineBlockExt(const std::shared_ptr<NetworkClient>& client, BlockDefinition def);
+    // -- Broadcast variants: encoded once, then queued on each recipient with IMinecraftClient::SendShared.
+    static D3PP::network::SharedPacket EncodeBlockChange(short x, short y, short z, unsigned char type);
+    // -- CPE BulkBlockUpdate, count (1 to BULK_BLOCK_UPDATE_MAX) changes given as level data indices.
+    static D3PP::network::SharedPacket EncodeBulkBlockUpdate(const int* indices, const unsigned char* types, int count);
+    static D3PP::network::SharedPacket EncodePlayerTeleport(char playerId, short x, short y, short z, char rotation, char look);
+    static D3PP::network::SharedPacket EncodeChatMessage(std::string message, char location);
+    static D3PP::network::SharedPacket EncodeExtAddPlayerName(short nameId, std::string playerName, std::string listName, std::string groupName, char groupRank);
+    // -- Level data chunks for length bytes of a gzipped map as one packet. Without percentComplete each chunk
+    // -- reports its offset into data, a stream sent in pieces passes its own progress.
+    static D3PP::network::SharedPacket EncodeLevelData(const unsigned char* data, int length, int percentComplete = -1);
+    static D3PP::network::SharedPacket EncodeMapFinalize(short sizeX, short sizeY, short sizeZ);
 };
 #endif //D3PP_PACKETS_H
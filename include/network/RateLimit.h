@@ -0,0 +1,38 @@
+#ifndef D3PP_RATELIMIT_H
+#define D3PP_RATELIMIT_H
+#include <chrono>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+
+namespace D3PP::network {
+    // -- Allows bursts of up to Burst events, refilled at Rate per second. A rate of 0 or less never limits.
+    class TokenBucket {
+    public:
+        TokenBucket();
+        TokenBucket(double rate, double burst, std::chrono::steady_clock::time_point now);
+        bool Take(std::chrono::steady_clock::time_point now);
+        // -- True once the bucket refilled completely, it then carries no state worth keeping.
+        [[nodiscard]] bool Idle(std::chrono::steady_clock::time_point now) const;
+    private:
+        double m_rate;
+        double m_burst;
+        double m_tokens;
+        std::chrono::steady_clock::time_point m_last;
+
+        [[nodiscard]] double TokensAt(std::chrono::steady_clock::time_point now) const;
+    };
+
+    // -- One TokenBucket per remote address, for limiting how fast a host may open connections.
+    class ConnectionLimiter {
+    public:
+        bool Allow(const std::string& ip, double rate, double burst, std::chrono::steady_clock::time_point now);
+        // -- Forgets addresses whose bucket refilled, so the table only holds recently active hosts.
+        void Prune(std::chrono::steady_clock::time_point now);
+        size_t Tracked();
+    private:
+        std::mutex m_lock;
+        std::unordered_map<std::string, TokenBucket> m_buckets;
+    };
+}
+#endif //D3PP_RATELIMIT_H
@@ -11,8 +11,11 @@
 #include <string>
 #include <mutex>
 #include <shared_mutex>
+#include <atomic>
 
 #include "common/TaskScheduler.h"
+#include "network/EncodedPacket.h"
+#include "network/RateLimit.h"
 
 class ServerSocket;
 class IMinecraftClient;
@@ -20,6 +23,7 @@ class NetworkClient;
 
 namespace D3PP::network {
     class IPacket;
+    class NetworkShard;
 
  class Server : public TaskItem {
  public:
@@ -28,30 +32,38 @@ namespace D3PP::network {
      static float BytesReceived;
      static std::atomic<int> SentIncrement;
      static std::atomic<int> ReceivedIncrement;
+     // -- Flood protection counters since startup.
+     static std::atomic<int> RejectedConnections;
+     static std::atomic<int> FloodKicks;
+     static std::atomic<int> HandshakeTimeouts;
      static std::vector<std::shared_ptr<IMinecraftClient>> roClients;
      static std::shared_mutex roMutex;
      Server();
      static void Start();
      static void Stop();
+     // -- Wakes a client's reactor thread so freshly queued output goes out without waiting for socket activity.
+     static void WakeNetwork(int shard);
      void Shutdown();
 
-     static void RegisterClient(NetworkClient client);
+     static void RegisterClient(NetworkClient client, NetworkShard& shard);
      static void UnregisterClient(const std::shared_ptr<IMinecraftClient>& client);
      static void SendToAll(IPacket& packet, std::string extension, int extVersion);
      static void SendAllExcept(IPacket& packet, std::shared_ptr<IMinecraftClient> toNot);
  private:
      static Server* m_Instance;
      static std::map<int, std::shared_ptr<IMinecraftClient>> m_clients;
-     std::unique_ptr<ServerSocket> m_serverSocket;
-     std::thread m_handleThread;
+     // -- Shard 0 also owns the listen socket and accepts for everyone.
+     std::vector<std::unique_ptr<NetworkShard>> m_shards;
+     ServerSocket* m_listenSocket;
+     ConnectionLimiter m_connectLimiter;
      static std::mutex m_ClientMutex;
 
      int m_port;
-     bool m_needsUpdate;
-     void HandleClientData();
+     std::atomic<bool> m_needsUpdate;
      void HandleIncomingClient();
+     NetworkShard& LeastLoadedShard();
      void MainFunc();
-     void HandleEvents();
+     static void SendSharedToAll(const SharedPacket& packet, const std::string& extension, int extVersion, const std::shared_ptr<IMinecraftClient>& toNot);
      static void RebuildRoClients();
  };
 }
@@ -0,0 +1,53 @@
+#ifndef D3PP_WEBSOCKET_H
+#define D3PP_WEBSOCKET_H
+#define WEBSOCKET_MAX_HANDSHAKE 4096
+#define WEBSOCKET_MAX_FRAME 65536
+// -- Longest server frame header: opcode, length marker, 64-bit length.
+#define WEBSOCKET_MAX_HEADER 10
+#include <array>
+#include <cstdint>
+#include <span>
+#include <string>
+
+class ByteBuffer;
+
+namespace D3PP::network {
+    enum class WebSocketStatus {
+        Ok,
+        Closed,
+        Error
+    };
+
+    // -- Server side of RFC 6455 for web clients. Inbound frames are unmasked into a second ByteBuffer the packet
+    // -- handlers read as if it came off a plain socket; outbound, whatever the send queue gathers goes out as one
+    // -- binary frame. Classic's stream doesn't care where frames split, so frames never have to line up with packets.
+    class WebSocketCodec {
+    public:
+        WebSocketCodec();
+        // -- Consumes the HTTP upgrade and then complete frames from raw, appending their payload to payload.
+        WebSocketStatus Decode(ByteBuffer& raw, ByteBuffer& payload);
+
+        // -- Given up to count gathered payload slices (the array must hold count + 1), puts the pending frame header
+        // -- or handshake response in front and cuts the payload to what the current frame still covers.
+        int Frame(std::span<const unsigned char>* slices, int count, size_t& total);
+        // -- Records bytes the socket took from the last Frame, returns how many of them were payload.
+        size_t Consume(size_t sent);
+        // -- Handshake response or frame bytes are still owed to the socket.
+        [[nodiscard]] bool Pending() const { return m_prefixSent < m_prefix.size() || m_frameRemaining > 0; }
+
+        static std::string AcceptKey(const std::string& key);
+        // -- XORs data with the four byte mask, offset being data[0]'s position in the frame payload.
+        static void Unmask(std::span<unsigned char> data, const std::array<unsigned char, 4>& mask, size_t offset);
+        static int EncodeHeader(size_t payloadLength, unsigned char* header);
+    private:
+        bool m_open;
+        // -- Unsent handshake response, or the current frame's header.
+        std::string m_prefix;
+        size_t m_prefixSent;
+        // -- Payload bytes the current frame header still promises.
+        size_t m_frameRemaining;
+
+        WebSocketStatus Handshake(ByteBuffer& raw);
+    };
+}
+#endif //D3PP_WEBSOCKET_H
@@ -22,7 +22,8 @@ enum ServerSocketEvent {
     SOCKET_EVENT_NONE,
     SOCKET_EVENT_CONNECT,
     SOCKET_EVENT_DATA,
-    SOCKET_EVENT_DISCONNECT
+    SOCKET_EVENT_DISCONNECT,
+    SOCKET_EVENT_WRITABLE
 };
 
 class ServerSocket {
@@ -31,11 +32,14 @@ public:
     ServerSocket(int port);
     void Init(int port);
     void Listen();
-    std::map<ServerSocketEvent, std::vector<SOCKET>> CheckEvents();
+    std::map<ServerSocketEvent, std::vector<SOCKET>> CheckEvents(int timeoutMs);
     std::unique_ptr<Sockets> Accept();
     void Unaccept(SOCKET fd);
     void Stop();
     SOCKET GetEventSocket();
+    void Wake() const { }
+    // -- Accept() already tracks the client for select().
+    void Adopt(SOCKET fd) const { }
 private:
     bool hasInit;
     int listenPort;
@@ -20,6 +20,12 @@
 #include <ws2tcpip.h>
 #include <stdio.h>
 #include <exception>
+#include <span>
+
+// -- Returned by Read/Send on a non-blocking socket that has nothing to read or no room to write.
+#define SOCKET_WOULD_BLOCK (-2)
+// -- Most slices handed to one SendVectored call.
+#define SOCKET_MAX_SLICES 64
 
 class Sockets
 {
@@ -32,6 +38,10 @@ public:
     void Disconnect();
     int Read(char* buffer, int size);
     int Send(char* data, int size);
+    // -- One WSASend for all slices. There is no zero-copy mode here, the flag is ignored.
+    int SendVectored(const std::span<const unsigned char>* slices, int count, bool zeroCopy);
+    bool EnableZeroCopy() { return false; }
+    bool ReapZeroCopy(unsigned int& first, unsigned int& last) { return false; }
     bool GetConnected() const { return connected; }
     SOCKET GetSocketFd();
     std::string GetSocketIp();
@@ -16,10 +16,15 @@ namespace D3PP::world {
         D3MapProvider();
         void CreateNew(const Common::Vector3S& size, const std::string& path, const std::string& name) override;
         bool Save(const std::string& filePath) override;
+        bool SaveWithoutBlocks() override;
+        bool SupportsConcurrentSave() override;
+        bool UseChunkedBlockLayer() override;
         bool Load(const std::string& filePath) override;
         Common::Vector3S GetSize() const override;
         void SetSize(const Common::Vector3S& newSize) override;
         bool Unload() override;
+        int64_t Compact() override;
+        bool Expand() override;
         bool Reload() override;
         void SetBlock(const Common::Vector3S& location, const unsigned char& type) override;
         unsigned char GetBlock(const Common::Vector3S& location) override;
@@ -27,6 +32,7 @@ namespace D3PP::world {
         void SetLastPlayer(const Common::Vector3S& location, const short& player) override;
         void SetBlocks(const std::vector<unsigned char>& blocks) override;
         std::vector<unsigned char> GetBlocks() override;
+        bool ReadBlocks(int64_t offset, unsigned char* output, int64_t count) override;
         MinecraftLocation GetSpawn() override;
         void SetSpawn(const MinecraftLocation& location) override;
         MapPermissions GetPermissions() override;
@@ -39,7 +45,7 @@ namespace D3PP::world {
 
         std::vector<CustomParticle> getParticles() override;
         void SetParticles(std::vector<CustomParticle> particles) override;
-    private:
+    protected:
         std::string m_currentPath;
         std::unique_ptr<files::D3Map> m_d3map;
     };
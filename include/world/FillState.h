@@ -11,13 +11,13 @@ namespace D3PP::world {
     struct FillState {
         std::vector<unsigned char> fillData;
 
-        FillState(Common::Vector3S mapSize) { MapSize = mapSize; fillData.resize((mapSize.X * mapSize.Y * mapSize.Z) * 4);}
+        FillState(Common::Vector3S mapSize) { MapSize = mapSize; fillData.resize(mapSize.X * mapSize.Y * mapSize.Z);}
         void SetBlock(Common::Vector3S location, unsigned char type) { int index = GetIndex(location.X, location.Y, location.Z); if (index < fillData.size()) fillData.at(index) = type; }
         unsigned char GetBlock(Common::Vector3S location) { int index = GetIndex(location.X, location.Y, location.Z); if (index > fillData.size()) return -1; return fillData.at(index); }
     private:
         Common::Vector3S MapSize;
         int GetIndex(int x, int y, int z) {
-            return (x + y * MapSize.X + z * MapSize.X * MapSize.Y) * 4;
+            return x + y * MapSize.X + z * MapSize.X * MapSize.Y;
         }
     };
 }
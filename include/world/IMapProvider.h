@@ -4,6 +4,7 @@
 
 #ifndef D3PP_IMAPPROVIDER_H
 #define D3PP_IMAPPROVIDER_H
+#include <cstdint>
 #include <string>
 #include <vector>
 #include "common/Vectors.h"
@@ -27,12 +28,23 @@ namespace D3PP::world {
             virtual void CreateNew(const Common::Vector3S& size, const std::string& path, const std::string& name)=0;
 
             virtual bool Save(const std::string& filePath) = 0;
+            // -- Saves everything except the block layer; providers that can't split the two do a full save.
+            virtual bool SaveWithoutBlocks() { return Save(""); }
+            // -- True when Save() works from its own snapshot and may run on another thread while blocks keep changing.
+            virtual bool SupportsConcurrentSave() { return false; }
+            // -- Switches the block layer to the chunked v2 format on the next save; false if the provider has no such format.
+            virtual bool UseChunkedBlockLayer() { return false; }
             virtual bool Load(const std::string& filePath) = 0;
 
             [[nodiscard]] virtual Common::Vector3S GetSize() const = 0;
             virtual void SetSize(const Common::Vector3S& newSize) = 0;
 
             virtual bool Unload() = 0;
+            // -- Keeps the block layer compressed in memory instead of dropping it, so Reload() needs no disk I/O.
+            // -- Returns the bytes held, or -1 if the provider can't do this (the caller then falls back to Unload()).
+            virtual int64_t Compact() { return -1; }
+            // -- Restores the block layer kept by Compact(); false if there is none, Reload() then reads it from disk.
+            virtual bool Expand() { return false; }
             virtual bool Reload() = 0;
 
             virtual void SetBlock(const Common::Vector3S& location, const unsigned char& type) = 0;
@@ -41,8 +53,22 @@ namespace D3PP::world {
             virtual short GetLastPlayer(const Common::Vector3S& location) = 0;
             virtual void SetLastPlayer(const Common::Vector3S& location, const short& player) = 0;
 
+            // -- Bulk block access works on block types only, one byte per block in X, Y, Z order.
             virtual void SetBlocks(const std::vector<unsigned char>& blocks) = 0;
             virtual std::vector<unsigned char> GetBlocks() = 0;
+            // -- Copies count block types starting at index offset in that order, false if the range is outside the map.
+            virtual bool ReadBlocks(int64_t offset, unsigned char* output, int64_t count) {
+                Common::Vector3S size = GetSize();
+                int64_t layer = static_cast<int64_t>(size.X) * size.Y;
+                if (offset < 0 || count < 0 || size.X <= 0 || offset + count > layer * size.Z)
+                    return false;
+
+                for (int64_t i = 0; i < count; i++) {
+                    int64_t index = offset + i;
+                    output[i] = GetBlock(Common::Vector3S(static_cast<short>(index % size.X), static_cast<short>((index / size.X) % size.Y), static_cast<short>(index / layer)));
+                }
+                return true;
+            }
 
             virtual MinecraftLocation GetSpawn() = 0;
             virtual void SetSpawn(const MinecraftLocation& location) = 0;
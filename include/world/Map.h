@@ -10,10 +10,16 @@
 
 #include <string>
 #include <vector>
+#include <array>
 #include <map>
 #include <thread>
 #include <memory>
 #include <filesystem>
+#include <atomic>
+#include <mutex>
+#include <shared_mutex>
+#include <future>
+#include <unordered_map>
 
 #include "common/TaskScheduler.h"
 #include "common/MinecraftLocation.h"
@@ -24,6 +30,8 @@
 #include "world/MapIntensiveActions.h"
 #include "world/FillState.h"
 #include "world/CustomParticle.h"
+#include "files/BlockJournal.h"
+#include "network/EncodedPacket.h"
 
 #include "BlockChangeQueue.h"
 #include "PhysicsQueue.h"
@@ -55,9 +63,13 @@ namespace D3PP::world {
     const std::string MAP_LIST_FILE = "Map_List";
     const std::string MAP_SETTINGS_FILE = "Map_Settings";
 
-    const int MAP_BLOCK_ELEMENT_SIZE = 4;
+    const int MAP_BLOCK_ELEMENT_SIZE = 1;
+    // -- GetBlockType result while the map isn't loaded (a load has been requested); 255 is still out of bounds.
+    const int MAP_BLOCK_NOT_LOADED = -1;
+    // -- Distinct client block translations whose finished level stream is kept per map.
+    const int MAP_SEND_CACHE_PROFILES = 4;
 
-    class Map {
+    class Map : public std::enable_shared_from_this<Map> {
         friend class MapMain;
 
     public:
@@ -72,8 +84,11 @@ namespace D3PP::world {
         std::vector<CustomParticle> Particles;
         std::vector<D3PP::files::MapRankElement> RankBoxes;
 
-        bool BlockchangeStopped, PhysicsStopped, loading, loaded;
+        bool BlockchangeStopped, PhysicsStopped;
+        std::atomic<bool> loading, loaded;
         std::string filePath;
+        std::string ProviderType;
+        int64_t JournalSnapshotSize;
         time_t LastClient;
         int Clients;
 
@@ -96,8 +111,9 @@ namespace D3PP::world {
 
         void ProcessPhysics(unsigned short X, unsigned short Y, unsigned short Z);
         bool Save(const std::string& directory);
+        bool ConvertToChunked();
         void Load(const std::string& directory);
-        unsigned char GetBlockType(unsigned short X, unsigned short Y, unsigned short Z);
+        int GetBlockType(unsigned short X, unsigned short Y, unsigned short Z);
         unsigned short GetBlockPlayer(unsigned short X, unsigned short Y, unsigned short Z);
         int BlockGetRank(unsigned short X, unsigned short Y, unsigned short Z);
 
@@ -105,7 +121,17 @@ namespace D3PP::world {
                         unsigned short Z1, short rank);
 
         void Reload();
-        void Unload();
+        // -- Queues a load on the map load pool unless the map is already loaded. Never blocks;
+        // -- the future resolves to whether the map ended up loaded. With a directory the map is (re)loaded from there.
+        // -- A directory load requested while another load is pending is queued behind it.
+        std::shared_future<bool> RequestLoad(const std::string& directory = "");
+        // -- Runs callback as soon as the map is loaded and not being rebuilt (immediately if it already is),
+        // -- requesting a load if needed. Callbacks run on the thread that finishes the load, with false if it failed.
+        void WhenLoaded(const std::function<void(bool)>& callback);
+        void Unload(bool keepWarm = false);
+        // -- Drops the compressed block layer of a warm map, leaving it fully unloaded. False if a save held it up.
+        bool EvictWarm();
+        [[nodiscard]] int64_t WarmSize() const { return m_warmSize; }
         void Send(int clientId);
         void Resend();
 
@@ -130,7 +156,7 @@ namespace D3PP::world {
         std::vector<int> GetEntities();
         void RemoveEntity(std::shared_ptr<Entity> e);
         void AddEntity(std::shared_ptr<Entity> e);
-        void SetBlocks(const std::vector<unsigned char>& blocks) { m_mapProvider->SetBlocks(blocks); }
+        void SetBlocks(const std::vector<unsigned char>& blocks);
         std::mutex BlockChangeMutex;
         std::unique_ptr<FillState> CurrentFillState;
         MapIntensiveActions IActions;
@@ -138,10 +164,47 @@ namespace D3PP::world {
         std::unique_ptr<IMapProvider> m_mapProvider;
     private:
         MapActions m_actions;
+        std::unique_ptr<files::BlockJournal> m_journal;
+        std::atomic<bool> m_snapshotRequired;
+        // -- Set while a save queued by Unload() for a required snapshot hasn't started yet.
+        std::atomic<bool> m_snapshotQueued;
+        int64_t m_warmSize;
+        // -- Held for the whole of a save, which may run on IActions; anything replacing the block storage waits on it.
+        std::mutex m_saveLock;
+
+        std::mutex m_loadLock;
+        std::shared_future<bool> m_pendingLoad;
+        // -- Directory load waiting for the pending one to finish.
+        std::shared_ptr<std::promise<bool>> m_queuedLoad;
+        std::shared_future<bool> m_queuedLoadResult;
+        std::string m_queuedDirectory;
+        std::vector<std::function<void(bool)>> m_loadCallbacks;
+
+        struct SendCacheEntry {
+            uint64_t Generation;
+            bool FastMap;
+            std::array<unsigned char, 256> Translation;
+            std::vector<network::SharedPacket> LevelData;
+        };
+        // -- Bumped after every change to the block layer, so cached level streams from before it go stale.
+        std::atomic<uint64_t> m_blockGeneration;
+        std::mutex m_sendCacheLock;
+        std::vector<SendCacheEntry> m_sendCache;
+        // -- Layer each client's latest send started on, guarded by m_sendCacheLock.
+        std::unordered_map<int, uint64_t> m_sendLayers;
+        // -- Held exclusively while the block storage is replaced or freed, shared by level streams reading it.
+        std::shared_mutex m_layerLock;
+        // -- Bumped under m_layerLock whenever the storage is replaced, a stream started on an older one stops reading.
+        std::atomic<uint64_t> m_layerGeneration;
+
+        // -- Queues a load on the load pool, m_loadLock is held by the caller.
+        void StartLoad(const std::string& directory, const std::shared_ptr<std::promise<bool>>& promise);
+        void ReplayJournal();
+        void FinishLoading(bool result = true);
         void QueueBlockPhysics(Common::Vector3S location);
 
         void QueueBlockChange(Common::Vector3S location, unsigned char priority,
-                              unsigned char oldType) const;
+                              unsigned char oldType);
 
         void  QueuePhysicsAround(const Common::Vector3S& loc);
     };
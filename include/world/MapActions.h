@@ -6,6 +6,7 @@
 #define D3PP_MAPACTIONS_H
 #include "common/TaskScheduler.h"
 #include <queue>
+#include <mutex>
 
 namespace D3PP::world {
     class MapActions : public TaskItem {
@@ -16,6 +17,7 @@ namespace D3PP::world {
         void AddTask(const std::function<void()>& task);
     private:
         std::queue<std::function<void()>> itemQueue;
+        std::mutex m_queueLock;
         std::string taskId;
     };
 }
@@ -5,6 +5,7 @@
 #ifndef D3PP_MAPINTENSIVEACTIONS_H
 #define D3PP_MAPINTENSIVEACTIONS_H
 #include <queue>
+#include <mutex>
 #include <thread>
 #include <functional>
 
@@ -18,6 +19,7 @@ namespace D3PP::world {
         void AddTask(const std::function<void()>& task);
     private:
         std::queue<std::function<void()>> itemQueue;
+        std::mutex m_queueLock;
         std::thread runner;
         bool m_finished;
     };
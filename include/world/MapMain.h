@@ -3,13 +3,23 @@
 
 #include <memory>
 #include <thread>
+#include <string>
+#include <functional>
 
 #include "common/TaskScheduler.h"
 #include "common/MinecraftLocation.h"
 #include "common/Vectors.h"
+#include "common/WorkerPool.h"
+#include "common/AdmissionQueue.h"
 
 namespace D3PP::world {
     class Map;
+    class IMapProvider;
+
+    // -- Values for the "Provider" key in Map_List
+    const std::string MAP_PROVIDER_D3 = "D3";
+    const std::string MAP_PROVIDER_PALETTED = "Paletted";
+    const std::string MAP_PROVIDER_MMAP = "Mmap";
 
     enum MapAction {
         SAVE = 0,
@@ -37,7 +47,7 @@ namespace D3PP::world {
         std::shared_ptr<Map> GetPointer(int id);
         std::shared_ptr<Map> GetPointer(const std::string& name);
         
-        int Add(int id, short x, short y, short z, const std::string &name);
+        int Add(int id, short x, short y, short z, const std::string &name, const std::string &providerType = MAP_PROVIDER_D3);
         void Delete(int id);
         static MapMain *GetInstance();
         static std::string GetMapMOTDOverride(int mapId);
@@ -46,11 +56,19 @@ namespace D3PP::world {
             return (x + y * sizeX + z * sizeX * sizeY) * blockSize;
         }
         static Common::Vector3S GetMapExportSize(const std::string &filename);
+        static std::unique_ptr<IMapProvider> CreateProvider(const std::string &providerType);
         void Init();
         void MainFunc();
         void AddSaveAction(int clientId, int mapId, const std::string &directory);
         void AddLoadAction(int clientId, int mapId, const std::string &directory);
+        void AddConvertAction(int clientId, int mapId);
         void LoadImmediately(int mapId, const std::string &directory);
+        // -- Runs a map load on the load pool; Load_Threads in Map_Settings limits how many run at once.
+        void QueueLoadTask(const std::function<void()>& task);
+        // -- Runs map send encoding on the send pool, sized by Send_Threads in Map_Settings.
+        void QueueSendTask(const std::function<void()>& task);
+        // -- Starts job once fewer than Max_Map_Sends sends are encoding, returns its place in line (0 if started).
+        size_t QueueMapSend(const std::function<void(Common::AdmissionQueue::Ticket)>& job);
         void AddResizeAction(int clientId, int mapId, unsigned short X, unsigned short Y, unsigned short Z);
         void AddFillAction(int clientId, int mapId, std::string functionName, std::string argString);
         void AddDeleteAction(int clientId, int mapId);
@@ -75,12 +93,22 @@ namespace D3PP::world {
         long mapSettingsLastWriteTime;
         int mapSettingsTimerFileCheck;
         int mapSettingsMaxChangesSec;
+        bool mapSettingsHugePages;
+        int mapSettingsJournalSnapshotSize;
+        int64_t mapSettingsWarmTierSize;
+        int mapSettingsLoadThreads;
+        std::unique_ptr<Common::WorkerPool> m_loadPool;
+        int mapSettingsSendThreads;
+        int mapSettingsMaxMapSends;
+        std::unique_ptr<Common::WorkerPool> m_sendPool;
+        std::unique_ptr<Common::AdmissionQueue> m_sendAdmission;
         
         int GetMapId();
         void MapListSave();
         void MapListLoad();
         void MapSettingsSave();
         void MapSettingsLoad();
+        void EnforceWarmTierSize();
         void MapBlockChange();
         void MapBlockPhysics();
     };
@@ -0,0 +1,90 @@
+#ifndef D3PP_MAPSENDSTREAM_H
+#define D3PP_MAPSENDSTREAM_H
+// -- Blocks read, translated and deflated per step.
+#define MAP_STREAM_READ_BLOCKS 65536
+// -- Compressed bytes gathered before a level data packet is cut.
+#define MAP_STREAM_PACKET_BYTES 16384
+// -- Encoded bytes a stream running on a worker keeps ready ahead of the client.
+#define MAP_STREAM_AHEAD_BYTES 262144
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+#include "common/Vectors.h"
+#include "network/IBulkSource.h"
+
+class GZipStream;
+
+namespace D3PP::world {
+    // -- A level transfer pulled by the client as its socket drains. Blocks are read, translated and gzipped a
+    // -- slice at a time, so a join holds a few buffers instead of copies of the whole map.
+    class MapSendStream : public network::IBulkSource, public std::enable_shared_from_this<MapSendStream> {
+    public:
+        // -- Copies count block types starting at offset, false if that range no longer exists.
+        typedef std::function<bool(int64_t offset, unsigned char* output, int count)> BlockReader;
+        typedef std::function<void(MapSendStream& stream, bool complete)> FinishedCallback;
+        typedef std::function<void(const std::function<void()>& task)> Scheduler;
+
+        // -- fastMap sends bare deflate without the length prefix, the client got the volume with the level init.
+        MapSendStream(BlockReader reader, const Common::Vector3S& size, const std::array<unsigned char, 256>& translation, FinishedCallback finished, bool fastMap = false);
+        // -- Replays level data an earlier stream encoded.
+        MapSendStream(std::vector<network::SharedPacket> encoded, const Common::Vector3S& size, FinishedCallback finished);
+        ~MapSendStream() override;
+
+        // -- Encodes on schedule's threads, staying up to MAP_STREAM_AHEAD_BYTES ahead of the client, instead of
+        // -- inside Next. Nothing is encoded before Admit, the ticket is held until the stream is dropped.
+        void RunOn(const Scheduler& schedule);
+        void Admit(std::shared_ptr<void> ticket);
+        // -- Ends the stream without encoding anything more and gives its ticket back; the client sees it fail.
+        void Abort();
+
+        network::SharedPacket Next() override;
+        bool Ended() override;
+        void SetWake(const std::function<void()>& wake) override;
+        network::SharedPacket Closing() override;
+        void Finished(bool complete) override;
+
+        [[nodiscard]] bool Replayed() const { return m_gzip == nullptr; }
+        // -- Level data packets produced so far, in order.
+        [[nodiscard]] const std::vector<network::SharedPacket>& Encoded() const { return m_encoded; }
+    private:
+        BlockReader m_reader;
+        FinishedCallback m_finished;
+        Common::Vector3S m_size;
+        std::array<unsigned char, 256> m_translation;
+        int64_t m_volume;
+
+        // -- Encoder state, used by one Encode at a time.
+        int64_t m_position;
+        std::unique_ptr<GZipStream> m_gzip;
+        std::vector<unsigned char> m_input;
+        // -- Compressed bytes not cut into a packet yet.
+        std::vector<unsigned char> m_pending;
+        bool m_deflated;
+        std::atomic<bool> m_failed;
+
+        // -- Shared between the encoder and the client, guarded by m_lock.
+        std::mutex m_lock;
+        Scheduler m_schedule;
+        std::shared_ptr<void> m_ticket;
+        std::function<void()> m_wake;
+        std::deque<network::SharedPacket> m_ready;
+        size_t m_readyBytes;
+        std::vector<network::SharedPacket> m_encoded;
+        size_t m_replayed;
+        bool m_admitted;
+        bool m_encoding;
+        bool m_ended;
+        bool m_starved;
+
+        network::SharedPacket Produce();
+        void Encode();
+        bool ShouldEncode() const;
+    };
+}
+#endif //D3PP_MAPSENDSTREAM_H
@@ -0,0 +1,66 @@
+#ifndef D3PP_MMAPMAPPROVIDER_H
+#define D3PP_MMAPMAPPROVIDER_H
+#ifdef __linux__
+#include <cstdint>
+#include <shared_mutex>
+#include "world/D3MapProvider.h"
+
+#define MMAP_MAP_BLOCKS_NAME "Data-Layer.raw"
+
+namespace D3PP::world {
+    // -- Blocks live in an uncompressed file that is memory-mapped, so loading a map is just an mmap()
+    // -- and only the pages players actually touch become resident. All offsets are 64-bit.
+    // -- File layout: one header page, the block type plane, then the last-player plane (both page aligned).
+    class MmapMapProvider : public D3MapProvider {
+    public:
+        explicit MmapMapProvider(bool hugePages = false);
+        ~MmapMapProvider() override;
+        void CreateNew(const Common::Vector3S& size, const std::string& path, const std::string& name) override;
+        bool Save(const std::string& filePath) override;
+        bool Load(const std::string& filePath) override;
+        void SetSize(const Common::Vector3S& newSize) override;
+        bool Unload() override;
+        void SetBlock(const Common::Vector3S& location, const unsigned char& type) override;
+        unsigned char GetBlock(const Common::Vector3S& location) override;
+        short GetLastPlayer(const Common::Vector3S& location) override;
+        void SetLastPlayer(const Common::Vector3S& location, const short& player) override;
+        void SetBlocks(const std::vector<unsigned char>& blocks) override;
+        std::vector<unsigned char> GetBlocks() override;
+        bool ReadBlocks(int64_t offset, unsigned char* output, int64_t count) override;
+    private:
+        struct LayerMapping {
+            int Fd;
+            unsigned char* Data;
+            uint64_t Size;
+        };
+
+        bool m_hugePages;
+        // -- Shared by anything touching the mapped planes; the mapping is only swapped while it is held exclusively.
+        mutable std::shared_mutex m_mappingLock;
+        int m_fd;
+        unsigned char* m_mapping;
+        uint64_t m_mappingSize;
+        unsigned char* m_types;
+        short* m_lastPlayers;
+        Common::Vector3S m_size;
+
+        [[nodiscard]] bool InBounds(const Common::Vector3S& location) const;
+        [[nodiscard]] uint64_t GetBlockOffset(const Common::Vector3S& location) const;
+        static uint64_t GetVolume(const Common::Vector3S& size);
+        static uint64_t GetLastPlayerOffset(uint64_t volume);
+        static uint64_t GetFileSize(uint64_t volume);
+
+        bool OpenFile(const std::string& fileName, const Common::Vector3S& size, bool create, LayerMapping& result);
+        // -- Publishes mapping as the block layer, the caller holds m_mappingLock exclusively. Returns the one it replaced.
+        LayerMapping SetMapping(const LayerMapping& mapping, const Common::Vector3S& size);
+        static void CloseMapping(const LayerMapping& mapping);
+        bool MapFile(const std::string& fileName, const Common::Vector3S& size, bool create);
+        // -- Maps folder's raw layer, converting Data-Layer.gz first when the raw file is missing or older.
+        bool OpenLayer(const std::string& folder, const Common::Vector3S& size);
+        void UnmapFile();
+        bool ConvertFromGzip(const std::string& folder, const Common::Vector3S& size);
+        bool ExportGzip(const std::string& folder);
+    };
+}
+#endif
+#endif //D3PP_MMAPMAPPROVIDER_H
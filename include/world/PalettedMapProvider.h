@@ -0,0 +1,77 @@
+#ifndef D3PP_PALETTEDMAPPROVIDER_H
+#define D3PP_PALETTEDMAPPROVIDER_H
+#include <atomic>
+#include <cstdint>
+#include <shared_mutex>
+#include <unordered_map>
+#include "world/D3MapProvider.h"
+
+namespace D3PP::world {
+    const int PALETTED_SECTION_SIZE = 16;
+    const int PALETTED_SECTION_VOLUME = PALETTED_SECTION_SIZE * PALETTED_SECTION_SIZE * PALETTED_SECTION_SIZE;
+
+    // -- A 16x16x16 block of the map, stored as a palette of block types plus bit-packed palette indices.
+    // -- Sections holding a single block type (e.g. all air) keep no index data at all.
+    class PalettedSection {
+    public:
+        explicit PalettedSection(unsigned char fill = 0);
+
+        [[nodiscard]] unsigned char Get(int localIndex) const;
+        void Set(int localIndex, unsigned char type);
+        void SetAll(const unsigned char* types);
+
+        [[nodiscard]] bool IsUniform() const { return m_bitsPerIndex == 0; }
+        [[nodiscard]] int BitsPerIndex() const { return m_bitsPerIndex; }
+        [[nodiscard]] size_t MemoryUsage() const;
+    private:
+        std::vector<unsigned char> m_palette;
+        std::vector<unsigned short> m_paletteCounts;
+        std::vector<uint64_t> m_indices;
+        int m_bitsPerIndex;
+
+        [[nodiscard]] int GetPaletteIndex(int localIndex) const;
+        void SetPaletteIndex(int localIndex, int paletteIndex);
+        void Repack(int newBits);
+        void Collapse(unsigned char type);
+    };
+
+    // -- Keeps config, portals and particles in the D3 format, but holds blocks in paletted sections
+    // -- so that mostly-empty maps only pay for the sections that actually contain something.
+    class PalettedMapProvider : public D3MapProvider {
+    public:
+        PalettedMapProvider();
+        void CreateNew(const Common::Vector3S& size, const std::string& path, const std::string& name) override;
+        bool Save(const std::string& filePath) override;
+        bool Load(const std::string& filePath) override;
+        void SetSize(const Common::Vector3S& newSize) override;
+        bool Unload() override;
+        void SetBlock(const Common::Vector3S& location, const unsigned char& type) override;
+        unsigned char GetBlock(const Common::Vector3S& location) override;
+        short GetLastPlayer(const Common::Vector3S& location) override;
+        void SetLastPlayer(const Common::Vector3S& location, const short& player) override;
+        void SetBlocks(const std::vector<unsigned char>& blocks) override;
+        std::vector<unsigned char> GetBlocks() override;
+        bool ReadBlocks(int64_t offset, unsigned char* output, int64_t count) override;
+
+        [[nodiscard]] size_t MemoryUsage() const;
+    private:
+        // -- Setting a block can repack its section, so readers on other threads (map sends) share this lock
+        // -- and anything changing sections or last players takes it exclusively.
+        mutable std::shared_mutex m_sectionLock;
+        std::vector<PalettedSection> m_sections;
+        std::unordered_map<int64_t, short> m_lastPlayers;
+        Common::Vector3S m_size;
+        int m_sectionsX, m_sectionsY, m_sectionsZ;
+        // -- Set by every block write under m_sectionLock, cleared by a save before it starts reading the sections.
+        std::atomic<bool> m_blocksChanged;
+
+        void AllocateSections(const Common::Vector3S& size);
+        [[nodiscard]] bool InBounds(const Common::Vector3S& location) const;
+        [[nodiscard]] int64_t GetSectionIndex(int x, int y, int z) const;
+        [[nodiscard]] int64_t GetBlockIndex(const Common::Vector3S& location) const;
+        static int GetLocalIndex(int x, int y, int z);
+        bool ReadBlockLayer(const std::string& folder);
+        bool SaveBlockLayer(const std::string& folder);
+    };
+}
+#endif //D3PP_PALETTEDMAPPROVIDER_H
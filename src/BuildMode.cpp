@@ -149,7 +149,8 @@ void BuildModeMain::Resend(int clientId) {
         std::shared_ptr<Map> thisMap = mapMain->GetPointer(toResend.mapId);
         if (thisMap != nullptr) {
             int blockType = thisMap->GetBlockType(toResend.Location.X, toResend.Location.Y, toResend.Location.Z);
-            NetworkFunctions::NetworkOutBlockSet(clientId, toResend.Location.X, toResend.Location.Y, toResend.Location.Z, blockType);
+            if (blockType != MAP_BLOCK_NOT_LOADED)
+                NetworkFunctions::NetworkOutBlockSet(clientId, toResend.Location.X, toResend.Location.Y, toResend.Location.Z, blockType);
         }
         _resendBlocks.erase(_resendBlocks.begin());
     }
@@ -236,6 +236,8 @@ void CPE::AfterLoginActions(const std::shared_ptr<IMinecraftClient>& client) {
     std::string prettyName = Entity::GetDisplayname(clientEntity->Id);
     int extVersion = CPE::GetClientExtVersion(client, EXT_PLAYER_LIST_EXT_NAME);
     int tempNameId = concrete->GetPlayerInstance()->GetNameId();
+    // -- Every other ExtPlayerList v2 client gets the same entry for the new player.
+    D3PP::network::SharedPacket addSelf;
 
     std::shared_lock lock(D3PP::network::Server::roMutex);
     for(auto const &nc : D3PP::network::Server::roClients) {
@@ -244,8 +246,10 @@ void CPE::AfterLoginActions(const std::shared_ptr<IMinecraftClient>& client) {
 
         if (nc->GetId() != clientId) {
             if (CPE::GetClientExtVersion(nc, EXT_PLAYER_LIST_EXT_NAME) == 2) {
-                auto concrete2 = std::static_pointer_cast<NetworkClient>(nc);
-                Packets::SendExtAddPlayerName(concrete2, tempNameId, loginName, prettyName, clientMap->Name(), 0);
+                if (addSelf == nullptr)
+                    addSelf = Packets::EncodeExtAddPlayerName(static_cast<short>(tempNameId), loginName, prettyName, clientMap->Name(), 0);
+
+                nc->SendShared(addSelf);
             }
             if (extVersion == 2) {
                 std::shared_ptr<Map> dudesMap = mapMain->GetPointer(nc->GetPlayerInstance()->GetEntity()->MapID);
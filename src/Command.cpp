@@ -226,6 +226,17 @@ void CommandMain::Init() {
     mapSaveCommand.Function = [this] { CommandMain::CommandSaveMap(); };
     Commands.push_back(mapSaveCommand);
 
+    Command mapConvertCommand;
+    mapConvertCommand.Id = "Map-Convert";
+    mapConvertCommand.Name = "mapconvert";
+    mapConvertCommand.Internal = true;
+    mapConvertCommand.Hidden = false;
+    mapConvertCommand.Rank = 0;
+    mapConvertCommand.RankShow = 0;
+    mapConvertCommand.CanConsole = false;
+    mapConvertCommand.Function = [this] { CommandMain::CommandConvertMap(); };
+    Commands.push_back(mapConvertCommand);
+
     Command getRankCommand;
     getRankCommand.Id = "Get-Rank";
     getRankCommand.Name = "getrank";
@@ -964,6 +975,18 @@ void CommandMain::CommandSaveMap() {
     c->SendChat("§SSave Queued.");
 }
 
+void CommandMain::CommandConvertMap() {
+    std::shared_ptr<IMinecraftClient> c = Network::GetClient(CommandClientId);
+    std::shared_ptr<Entity> e = Entity::GetPointer(CommandClientId, true);
+
+    if (e == nullptr)
+        return;
+
+    MapMain* mm = MapMain::GetInstance();
+    mm->AddConvertAction(CommandClientId, e->MapID);
+    c->SendChat("§SConversion Queued.");
+}
+
 void CommandMain::CommandGetRank() {
     
     std::shared_ptr<IMinecraftClient> c = Network::GetClient(CommandClientId);
@@ -0,0 +1,81 @@
+#include "common/AdmissionQueue.h"
+
+#include <algorithm>
+
+namespace D3PP::Common {
+    AdmissionQueue::AdmissionQueue(int limit) : m_limit(std::max(1, limit)), m_active(0), m_starting(false) {
+    }
+
+    size_t AdmissionQueue::Enqueue(const std::function<void(Ticket)>& job) {
+        size_t position;
+        {
+            std::scoped_lock<std::mutex> qLock(m_lock);
+            size_t ahead = static_cast<size_t>(m_active) + m_waiting.size();
+            position = ahead < static_cast<size_t>(m_limit) ? 0 : ahead - m_limit + 1;
+            m_waiting.push_back(job);
+
+            if (m_starting)
+                return position;
+            m_starting = true;
+        }
+
+        StartWaiting();
+        return position;
+    }
+
+    void AdmissionQueue::SetLimit(int limit) {
+        {
+            std::scoped_lock<std::mutex> qLock(m_lock);
+            m_limit = std::max(1, limit);
+
+            if (m_starting)
+                return;
+            m_starting = true;
+        }
+
+        StartWaiting();
+    }
+
+    int AdmissionQueue::Active() {
+        std::scoped_lock<std::mutex> qLock(m_lock);
+        return m_active;
+    }
+
+    size_t AdmissionQueue::Waiting() {
+        std::scoped_lock<std::mutex> qLock(m_lock);
+        return m_waiting.size();
+    }
+
+    void AdmissionQueue::Release() {
+        {
+            std::scoped_lock<std::mutex> qLock(m_lock);
+            m_active--;
+
+            if (m_starting)
+                return;
+            m_starting = true;
+        }
+
+        StartWaiting();
+    }
+
+    void AdmissionQueue::StartWaiting() {
+        while (true) {
+            std::function<void(Ticket)> job;
+            {
+                std::scoped_lock<std::mutex> qLock(m_lock);
+                if (m_waiting.empty() || m_active >= m_limit) {
+                    m_starting = false;
+                    return;
+                }
+
+                job = std::move(m_waiting.front());
+                m_waiting.pop_front();
+                m_active++;
+            }
+
+            // -- A job that drops its ticket right away releases the slot from in here, the loop then reuses it.
+            job(Ticket(new Slot { this }));
+        }
+    }
+}
@@ -2,147 +2,116 @@
 // Created by unknown on 8/19/21.
 //
 #include "common/ByteBuffer.h"
-#include <cmath>
-#include <utility>
+#include <algorithm>
+#include <cstring>
+#include <stdexcept>
 #include "Utils.h"
 
 
-ByteBuffer::ByteBuffer(const std::function<void()>& callback) : _buffer(initial_size), _bufLock() {
-    this->_size = (unsigned int) ByteBuffer::initial_size;
+ByteBuffer::ByteBuffer(const std::function<void()>& callback) : _buffer(initial_size), _mask(initial_size - 1), _head(0), _tail(0) {
     if (callback != nullptr)
         this->cbfunc = callback;
-    this->Interval = std::chrono::seconds(10);
-    this->LastRun = std::chrono::system_clock::now();
-    this->Main = [this] { MainFunc(); };
     _readPos = 0;
-    _writePos = 0;
-    _largestAlloc = 0;
-    std::string myId = TaskScheduler::RegisterTask("ByteBuffer", *this);
-    this->TaskId = myId;
 }
 
-void ByteBuffer::MainFunc() {
-    if ((_largestAlloc > ByteBuffer::initial_size) && (_writePos > ByteBuffer::initial_size || _readPos > ByteBuffer::initial_size)) {
-        _largestAlloc = 0;
-        return;
-    }
-    // -- We can resize to save memory space.
-    if (_writePos == 0 && _readPos == 0) {
-        bool didLock = _bufLock.try_lock();
-        if (didLock) {
-            if (_buffer.size() == 0 || _buffer.data() == nullptr) {
-                return; // -- In the process of being dealloced
-            }
-            _buffer.resize(initial_size);
-            _size = initial_size;
-            _bufLock.unlock();
-        }
-    }
-    _largestAlloc = 0;
+int ByteBuffer::Size() const {
+    return static_cast<int>(_tail.load(std::memory_order_acquire) - _head.load(std::memory_order_relaxed));
 }
 
-int ByteBuffer::Size() const {
-    return (int)this->_writePos;
+int ByteBuffer::ReadSize() const {
+    return static_cast<int>(_tail.load(std::memory_order_acquire) - _readPos);
 }
 
 unsigned char ByteBuffer::PeekByte() {
-    unsigned char result = 0;
-    {
-        const std::scoped_lock<std::mutex> pqlock(_bufLock);
-        result = _buffer.at(_readPos);
-    }
-    return result;
+    CheckReadable(1);
+    return _buffer[_readPos & _mask];
 }
 
 int ByteBuffer::PeekIntLE() {
-    int result = 0;
-    const std::scoped_lock<std::mutex> pqlock(_bufLock);
-    result |= _buffer.at(_readPos);
-    result |= _buffer.at(_readPos + 1l) << 8;
-    result |= _buffer.at(_readPos + 2) << 16;
-    result |= _buffer.at(_readPos + 3) << 24;
-    return result;
+    unsigned char bytes[4];
+    CheckReadable(4);
+    CopyOut(_readPos, bytes, 4);
+    return bytes[0] | (bytes[1] << 8) | (bytes[2] << 16) | (bytes[3] << 24);
 }
 
 unsigned char ByteBuffer::ReadByte() {
-    unsigned char result = 0;
-    const std::scoped_lock<std::mutex> pqlock(_bufLock);
-    result = _buffer.at(_readPos++);
-    return result;
+    CheckReadable(1);
+    return _buffer[_readPos++ & _mask];
 }
 
 short ByteBuffer::ReadShort() {
-    short result = 0;
-    const std::scoped_lock<std::mutex> pqlock(_bufLock);
-    result |= _buffer.at(_readPos++) << 8;
-    result |= _buffer.at(_readPos++);
-    return result;
+    unsigned char bytes[2];
+    CheckReadable(2);
+    CopyOut(_readPos, bytes, 2);
+    _readPos += 2;
+    return static_cast<short>((bytes[0] << 8) | bytes[1]);
 }
 
 int ByteBuffer::ReadInt() {
-    int result = 0;
-    const std::scoped_lock<std::mutex> pqlock(_bufLock);
-    result |= _buffer.at(_readPos++) << 24;
-    result |= _buffer.at(_readPos++) << 16;
-    result |= _buffer.at(_readPos++) << 8;
-    result |= _buffer.at(_readPos++);
-    return result;
+    unsigned char bytes[4];
+    CheckReadable(4);
+    CopyOut(_readPos, bytes, 4);
+    _readPos += 4;
+    return (bytes[0] << 24) | (bytes[1] << 16) | (bytes[2] << 8) | bytes[3];
 }
 
 std::string ByteBuffer::ReadString() {
-    const std::scoped_lock<std::mutex> pqlock(_bufLock);
-    std::string result(_buffer.begin()+_readPos, _buffer.begin()+_readPos+64);
+    std::string result(64, ' ');
+    CheckReadable(64);
+    CopyOut(_readPos, reinterpret_cast<unsigned char*>(result.data()), 64);
     _readPos += 64;
     Utils::TrimString(result);
     return result;
 }
 
 std::vector<unsigned char> ByteBuffer::ReadByteArray() {
-    const std::scoped_lock<std::mutex> pqlock(_bufLock);
-    std::vector<unsigned char> result(_buffer.begin()+_readPos, _buffer.begin()+_readPos+1024);
-    _readPos += 1024;
-    return result;
+    return ReadByte(1024);
 }
 
 std::vector<unsigned char> ByteBuffer::ReadByte(int length) {
-    const std::scoped_lock<std::mutex> pqlock(_bufLock);
-    std::vector<unsigned char> result(_buffer.begin()+_readPos, _buffer.begin()+_readPos+length);
+    std::vector<unsigned char> result(length);
+    CheckReadable(length);
+    CopyOut(_readPos, result.data(), length);
     _readPos += length;
     return result;
 }
 
+int ByteBuffer::Read(std::span<unsigned char> out) {
+    int copied = Peek(out);
+    _readPos += copied;
+    return copied;
+}
+
+int ByteBuffer::Peek(std::span<unsigned char> out) const {
+    size_t length = std::min(out.size(), static_cast<size_t>(ReadSize()));
+    CopyOut(_readPos, out.data(), length);
+    return static_cast<int>(length);
+}
+
+std::span<const unsigned char> ByteBuffer::ReadableSpan() const {
+    size_t index = _readPos & _mask;
+    size_t length = std::min(static_cast<size_t>(ReadSize()), _buffer.size() - index);
+    return {_buffer.data() + index, length};
+}
+
 void ByteBuffer::Write(unsigned char value) {
-    const std::scoped_lock<std::mutex> pqlock(_bufLock);
-    Resize(1);
-    _buffer.at(_writePos++) = value;
+    Write(std::span<const unsigned char>(&value, 1));
 }
 
 void ByteBuffer::Write(short value) {
-    const std::scoped_lock<std::mutex> pqlock(_bufLock);
-    Resize(2);
-    _buffer.at(_writePos++) = (unsigned char) (value >> 8);
-    _buffer.at(_writePos++) = (unsigned char)value;
+    unsigned char bytes[2] = { (unsigned char) (value >> 8), (unsigned char)value };
+    Write(std::span<const unsigned char>(bytes));
 }
 
 void ByteBuffer::Write(int value) {
-    const std::scoped_lock<std::mutex> pqlock(_bufLock);
-    Resize(4);
-    _buffer.at(_writePos++) = (unsigned char) (value >> 24);
-    _buffer.at(_writePos++) = (unsigned char) (value >> 16);
-    _buffer.at(_writePos++) = (unsigned char) (value >> 8);
-    _buffer.at(_writePos++) = (unsigned char)value;
+    unsigned char bytes[4] = { (unsigned char) (value >> 24), (unsigned char) (value >> 16), (unsigned char) (value >> 8), (unsigned char)value };
+    Write(std::span<const unsigned char>(bytes));
 }
 
 void ByteBuffer::Write(std::string value) {
-    const std::scoped_lock<std::mutex> pqlock(_bufLock);
-    Resize(64);
-    if (value.size() < 64) {
-        std::string padded(64-value.size(), ' ');
-        value += padded;
-    }
-    const auto * constStr = reinterpret_cast<const unsigned char *> (value.c_str());
-    _buffer.insert(_buffer.begin()+_writePos, value.begin(), value.end());
-    _writePos += 64;
+    // -- Classic strings are always exactly 64 bytes, space padded.
+    value.resize(64, ' ');
+    Write(std::span<const unsigned char>(reinterpret_cast<const unsigned char*>(value.data()), 64));
 }
 
 void ByteBuffer::Write(std::vector<unsigned char> memory, int length) {
@@ -150,17 +119,53 @@ void ByteBuffer::Write(std::vector<unsigned char> memory, int length) {
     if (memory.size() != length) {
         actualLen = memory.size();
     }
-    const std::scoped_lock<std::mutex> pqlock(_bufLock);
-    Resize(actualLen);
-    _buffer.insert(_buffer.begin()+_writePos, memory.begin(), memory.begin()+actualLen);
-    _writePos += actualLen;
+    Write(std::span<const unsigned char>(memory.data(), actualLen));
+}
+
+void ByteBuffer::Write(std::span<const unsigned char> data) {
+    if (data.empty())
+        return;
+
+    Reserve(data.size());
+    size_t tail = _tail.load(std::memory_order_relaxed);
+    CopyIn(tail, data.data(), data.size());
+    _tail.store(tail + data.size(), std::memory_order_release);
+}
+
+std::span<unsigned char> ByteBuffer::WritableSpan(int minimum) {
+    Reserve(minimum);
+    size_t tail = _tail.load(std::memory_order_relaxed);
+    size_t index = tail & _mask;
+    size_t free = _buffer.size() - (tail - _head.load(std::memory_order_acquire));
+    size_t contiguous = std::min(free, _buffer.size() - index);
+
+    if (contiguous < static_cast<size_t>(minimum)) {
+        // -- Free space is split by the wrap point, move the data back to the start.
+        Relayout(_buffer.size());
+        tail = _tail.load(std::memory_order_relaxed);
+        index = tail & _mask;
+        contiguous = free;
+    }
+
+    return {_buffer.data() + index, contiguous};
+}
+
+void ByteBuffer::CommitWrite(int length) {
+    if (length <= 0)
+        return;
+
+    _tail.store(_tail.load(std::memory_order_relaxed) + length, std::memory_order_release);
 }
 
 void ByteBuffer::Shift(int size) {
-    const std::scoped_lock<std::mutex> pqlock(_bufLock);
-    std::copy(_buffer.begin()+size, _buffer.end(), _buffer.begin());
-    _readPos -= size;
-    _writePos -= size;
+    if (size <= 0)
+        return;
+
+    size_t head = _head.load(std::memory_order_relaxed);
+    size_t held = _tail.load(std::memory_order_acquire) - head;
+    head += std::min(static_cast<size_t>(size), held);
+    _readPos = std::max(_readPos, head);
+    _head.store(head, std::memory_order_release);
 }
 
 void ByteBuffer::Purge() {
@@ -170,34 +175,71 @@ void ByteBuffer::Purge() {
 }
 
 std::vector<unsigned char> ByteBuffer::GetAllBytes() {
-    const std::scoped_lock<std::mutex> pqlock(_bufLock);
-    std::vector<unsigned char> result(_buffer.begin(), _buffer.begin()+_writePos);
-    _writePos = 0;
-    _readPos = 0; // -- Not in the OG but I think it's needed..
+    size_t head = _head.load(std::memory_order_relaxed);
+    size_t tail = _tail.load(std::memory_order_acquire);
+    std::vector<unsigned char> result(tail - head);
+    CopyOut(head, result.data(), result.size());
+    _readPos = tail;
+    _head.store(tail, std::memory_order_release);
+
+    // -- A burst (e.g. a map send) should not pin its high-water mark forever.
+    if (_buffer.size() > shrink_size) {
+        std::vector<unsigned char>(initial_size).swap(_buffer);
+        _mask = initial_size - 1;
+    }
+
     return result;
 }
 
-void ByteBuffer::Resize(int size) {
-    if (size> _largestAlloc)
-        _largestAlloc = size;
+void ByteBuffer::Reserve(size_t length) {
+    size_t head = _head.load(std::memory_order_acquire);
+    size_t tail = _tail.load(std::memory_order_relaxed);
+    size_t held = tail - head;
 
-    if ((this->_size - this->_writePos) < size) {
-        int blockMultiplier = std::ceil(size/(float)block_size);
-        int newSize = (block_size * blockMultiplier) + _size;
-        _buffer.resize(newSize);
-        _largestAlloc = newSize - _size;
-        _size = newSize;
-    }
+    if (_buffer.size() - held >= length)
+        return;
+
+    size_t capacity = _buffer.size();
+    while (capacity - held < length)
+        capacity *= 2;
+
+    Relayout(capacity);
 }
 
-ByteBuffer::~ByteBuffer() {
-    TaskScheduler::UnregisterTask(this->TaskId);
-    _writePos = 0;
-    _readPos = 0;
-    _size = 0;
-    _buffer.clear();
+void ByteBuffer::Relayout(size_t capacity) {
+    size_t head = _head.load(std::memory_order_acquire);
+    size_t held = _tail.load(std::memory_order_relaxed) - head;
+
+    // -- Relinearize into the new storage: data starts at 0, cursors keep their distance from the head.
+    std::vector<unsigned char> grown(capacity);
+    CopyOut(head, grown.data(), held);
+    size_t readOffset = _readPos - head;
+    _buffer.swap(grown);
+    _mask = capacity - 1;
+    _readPos = readOffset;
+    _head.store(0, std::memory_order_relaxed);
+    _tail.store(held, std::memory_order_release);
 }
 
-int ByteBuffer::ReadSize() const {
-    return _writePos - _readPos;
+void ByteBuffer::CopyIn(size_t position, const unsigned char* data, size_t length) {
+    size_t index = position & _mask;
+    size_t first = std::min(length, _buffer.size() - index);
+    std::memcpy(_buffer.data() + index, data, first);
+    std::memcpy(_buffer.data(), data + first, length - first);
+}
+
+void ByteBuffer::CopyOut(size_t position, unsigned char* out, size_t length) const {
+    size_t index = position & _mask;
+    size_t first = std::min(length, _buffer.size() - index);
+    std::memcpy(out, _buffer.data() + index, first);
+    std::memcpy(out + first, _buffer.data(), length - first);
+}
+
+void ByteBuffer::CheckReadable(size_t length) const {
+    if (_readPos + length > _tail.load(std::memory_order_acquire))
+        throw std::out_of_range("ByteBuffer: read past end of data");
+}
+
+ByteBuffer::~ByteBuffer() {
+    _buffer.clear();
 }
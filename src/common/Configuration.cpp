@@ -6,7 +6,7 @@
 
 #define GLF __FILE__, __LINE__, __FUNCTION__
 
-NetworkSettings Configuration::NetSettings { 32, 25565, true, false};
+NetworkSettings Configuration::NetSettings { 32, 25565, true, false, "", 128, 0, 0, "auto", 1, 64, false, 4194304, 30, 10, 200, 400, 10, false };
 GeneralSettings Configuration::GenSettings { "D3PP Server", "Welcome to D3PP!","&cWelcome to D3PP", "INFO", 1,160, 3, true };
 KillSettings Configuration::killSettings { 1, MinecraftLocation{ 0, 0, Vector3S((short)0, (short)0, (short)0)} };
 TextSettings Configuration::textSettings { "&4Error:&f ", "&e", "&3|" };
@@ -0,0 +1,206 @@
+#include "common/IoUring.h"
+
+#ifdef __linux__
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <sys/mman.h>
+#include <sys/socket.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+namespace D3PP::Common {
+    IoUring::IoUring(unsigned int entries) {
+        m_ringFd = -1;
+        m_entries = 0;
+        m_sqRing = MAP_FAILED;
+        m_sqRingSize = 0;
+        m_cqRing = MAP_FAILED;
+        m_cqRingSize = 0;
+        m_sqes = static_cast<io_uring_sqe*>(MAP_FAILED);
+        m_sqesSize = 0;
+        m_sqHead = m_sqTail = m_sqMask = m_sqArray = nullptr;
+        m_cqHead = m_cqTail = m_cqMask = nullptr;
+        m_cqes = nullptr;
+
+        io_uring_params params{};
+        int fd = static_cast<int>(syscall(__NR_io_uring_setup, entries, &params));
+
+        if (fd < 0)
+            return;
+
+        m_ringFd = fd;
+        m_entries = params.sq_entries;
+        m_sqRingSize = params.sq_off.array + params.sq_entries * sizeof(unsigned);
+        m_cqRingSize = params.cq_off.cqes + params.cq_entries * sizeof(io_uring_cqe);
+
+        bool singleMap = (params.features & IORING_FEAT_SINGLE_MMAP) != 0;
+        if (singleMap)
+            m_sqRingSize = m_cqRingSize = std::max(m_sqRingSize, m_cqRingSize);
+
+        m_sqRing = mmap(nullptr, m_sqRingSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd, IORING_OFF_SQ_RING);
+        if (m_sqRing == MAP_FAILED) {
+            Release();
+            return;
+        }
+
+        if (singleMap) {
+            m_cqRing = m_sqRing;
+        } else {
+            m_cqRing = mmap(nullptr, m_cqRingSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd, IORING_OFF_CQ_RING);
+            if (m_cqRing == MAP_FAILED) {
+                Release();
+                return;
+            }
+        }
+
+        m_sqesSize = params.sq_entries * sizeof(io_uring_sqe);
+        m_sqes = static_cast<io_uring_sqe*>(mmap(nullptr, m_sqesSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd, IORING_OFF_SQES));
+        if (m_sqes == MAP_FAILED) {
+            Release();
+            return;
+        }
+
+        auto* sq = static_cast<unsigned char*>(m_sqRing);
+        auto* cq = static_cast<unsigned char*>(m_cqRing);
+        m_sqHead = reinterpret_cast<unsigned*>(sq + params.sq_off.head);
+        m_sqTail = reinterpret_cast<unsigned*>(sq + params.sq_off.tail);
+        m_sqMask = reinterpret_cast<unsigned*>(sq + params.sq_off.ring_mask);
+        m_sqArray = reinterpret_cast<unsigned*>(sq + params.sq_off.array);
+        m_cqHead = reinterpret_cast<unsigned*>(cq + params.cq_off.head);
+        m_cqTail = reinterpret_cast<unsigned*>(cq + params.cq_off.tail);
+        m_cqMask = reinterpret_cast<unsigned*>(cq + params.cq_off.ring_mask);
+        m_cqes = reinterpret_cast<io_uring_cqe*>(cq + params.cq_off.cqes);
+    }
+
+    IoUring::~IoUring() {
+        Release();
+    }
+
+    void IoUring::Release() {
+        if (m_sqes != MAP_FAILED)
+            munmap(m_sqes, m_sqesSize);
+        if (m_cqRing != MAP_FAILED && m_cqRing != m_sqRing)
+            munmap(m_cqRing, m_cqRingSize);
+        if (m_sqRing != MAP_FAILED)
+            munmap(m_sqRing, m_sqRingSize);
+        if (m_ringFd != -1)
+            close(m_ringFd);
+
+        m_sqes = static_cast<io_uring_sqe*>(MAP_FAILED);
+        m_sqRing = m_cqRing = MAP_FAILED;
+        m_ringFd = -1;
+    }
+
+    bool IoUring::Supported() {
+        static const bool supported = IoUring(2).Available();
+        return supported;
+    }
+
+    bool IoUring::Enter(unsigned int toSubmit, unsigned int waitFor) {
+        while (true) {
+            long result = syscall(__NR_io_uring_enter, m_ringFd, toSubmit, waitFor, waitFor > 0 ? IORING_ENTER_GETEVENTS : 0, nullptr, 0);
+
+            if (result >= 0)
+                return true;
+            if (errno != EINTR)
+                return false;
+
+            // -- Whatever the kernel took before the signal stays submitted, only the rest is offered again.
+            toSubmit = *m_sqTail - __atomic_load_n(m_sqHead, __ATOMIC_ACQUIRE);
+        }
+    }
+
+    bool IoUring::SubmitAndWait(std::vector<IoRequest>& requests) {
+        if (!Available())
+            return false;
+
+        size_t done = 0;
+        while (done < requests.size()) {
+            auto batch = static_cast<unsigned int>(std::min<size_t>(m_entries, requests.size() - done));
+            unsigned int tail = *m_sqTail;
+
+            for (unsigned int i = 0; i < batch; i++) {
+                IoRequest& request = requests[done + i];
+                unsigned int index = tail & *m_sqMask;
+                io_uring_sqe* sqe = &m_sqes[index];
+                std::memset(sqe, 0, sizeof(io_uring_sqe));
+
+                switch (request.Op) {
+                    case IoOperation::Read:
+                        sqe->opcode = IORING_OP_READ;
+                        break;
+                    case IoOperation::Write:
+                        sqe->opcode = IORING_OP_WRITE;
+                        break;
+                    case IoOperation::Recv:
+                        sqe->opcode = IORING_OP_RECV;
+                        sqe->msg_flags = MSG_DONTWAIT;
+                        break;
+                    case IoOperation::Send:
+                        sqe->opcode = IORING_OP_SEND;
+                        sqe->msg_flags = MSG_DONTWAIT | MSG_NOSIGNAL;
+                        break;
+                    case IoOperation::SendMsg:
+                        sqe->opcode = IORING_OP_SENDMSG;
+                        sqe->msg_flags = MSG_DONTWAIT | MSG_NOSIGNAL;
+                        break;
+                }
+
+                sqe->fd = request.Fd;
+                sqe->addr = reinterpret_cast<uint64_t>(request.Buffer);
+                sqe->len = request.Op == IoOperation::SendMsg ? 1 : request.Length;
+                sqe->off = static_cast<uint64_t>(request.Offset);
+                sqe->user_data = done + i;
+                m_sqArray[index] = index;
+                request.Result = -ECANCELED;
+                tail++;
+            }
+
+            unsigned int sqHead = __atomic_load_n(m_sqHead, __ATOMIC_ACQUIRE);
+            __atomic_store_n(m_sqTail, tail, __ATOMIC_RELEASE);
+
+            // -- The kernel doesn't wait after a short submit, so whatever it left is offered again until it stops taking any.
+            bool submittedAll = Enter(batch, batch);
+            unsigned int submitted = __atomic_load_n(m_sqHead, __ATOMIC_ACQUIRE) - sqHead;
+            while (submittedAll && submitted < batch) {
+                unsigned int before = submitted;
+                submittedAll = Enter(batch - submitted, 0);
+                submitted = __atomic_load_n(m_sqHead, __ATOMIC_ACQUIRE) - sqHead;
+                submittedAll = submittedAll && submitted > before;
+            }
+
+            // -- Entries the kernel never took are withdrawn, a later call must not submit them against another vector.
+            if (!submittedAll)
+                __atomic_store_n(m_sqTail, sqHead + submitted, __ATOMIC_RELEASE);
+
+            // -- Everything submitted is reaped even after an error, so no completion is left for a later call.
+            unsigned int completed = 0;
+            while (completed < submitted) {
+                unsigned int head = *m_cqHead;
+                unsigned int cqTail = __atomic_load_n(m_cqTail, __ATOMIC_ACQUIRE);
+
+                for (; head != cqTail; head++, completed++) {
+                    const io_uring_cqe& cqe = m_cqes[head & *m_cqMask];
+                    requests[cqe.user_data].Result = cqe.res;
+                }
+
+                __atomic_store_n(m_cqHead, head, __ATOMIC_RELEASE);
+
+                if (completed < submitted && !Enter(0, submitted - completed)) {
+                    // -- Closing the ring cancels whatever is still in flight.
+                    Release();
+                    return false;
+                }
+            }
+
+            if (!submittedAll)
+                return false;
+
+            done += batch;
+        }
+
+        return true;
+    }
+}
+#endif
@@ -0,0 +1,94 @@
+#include "common/WorkerPool.h"
+
+#include <algorithm>
+
+namespace D3PP::Common {
+    WorkerPool::WorkerPool(int threads) {
+        m_stopping = false;
+        m_target = 0;
+        SetThreadCount(threads);
+    }
+
+    WorkerPool::~WorkerPool() {
+        std::vector<std::thread> workers;
+        {
+            std::scoped_lock<std::mutex> pLock(m_lock);
+            // -- Workers keep going until the queue is empty, so nothing waiting on a queued task is left hanging.
+            m_stopping = true;
+            std::swap(workers, m_workers);
+        }
+        m_wake.notify_all();
+
+        for (auto& worker : workers)
+            worker.join();
+
+        JoinRetired();
+    }
+
+    void WorkerPool::Submit(const std::function<void()>& task) {
+        {
+            std::scoped_lock<std::mutex> pLock(m_lock);
+            m_tasks.push(task);
+        }
+        m_wake.notify_one();
+    }
+
+    void WorkerPool::SetThreadCount(int threads) {
+        {
+            std::scoped_lock<std::mutex> pLock(m_lock);
+            m_target = static_cast<size_t>(std::max(1, threads));
+
+            while (m_workers.size() < m_target)
+                m_workers.emplace_back([this]() { this->Run(); });
+        }
+
+        // -- Surplus workers notice the lower target between tasks; nobody waits for them here.
+        m_wake.notify_all();
+        JoinRetired();
+    }
+
+    int WorkerPool::ThreadCount() {
+        std::scoped_lock<std::mutex> pLock(m_lock);
+        return static_cast<int>(m_target);
+    }
+
+    size_t WorkerPool::Pending() {
+        std::scoped_lock<std::mutex> pLock(m_lock);
+        return m_tasks.size();
+    }
+
+    void WorkerPool::JoinRetired() {
+        std::vector<std::thread> retired;
+        {
+            std::scoped_lock<std::mutex> pLock(m_lock);
+            std::swap(retired, m_retired);
+        }
+
+        for (auto& worker : retired)
+            worker.join();
+    }
+
+    void WorkerPool::Run() {
+        while (true) {
+            std::function<void()> task;
+            {
+                std::unique_lock<std::mutex> pLock(m_lock);
+                m_wake.wait(pLock, [this]() { return m_stopping || !m_tasks.empty() || m_workers.size() > m_target; });
+
+                if (!m_stopping && m_workers.size() > m_target) {
+                    auto self = std::find_if(m_workers.begin(), m_workers.end(), [](const std::thread& worker) { return worker.get_id() == std::this_thread::get_id(); });
+                    m_retired.push_back(std::move(*self));
+                    m_workers.erase(self);
+                    return;
+                }
+
+                if (m_tasks.empty())
+                    return;
+
+                task = std::move(m_tasks.front());
+                m_tasks.pop();
+            }
+            task();
+        }
+    }
+}
@@ -6,7 +6,14 @@
 
 #include <zlib.h>
 #include <fstream>
+#include <vector>
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
 #include "common/Logger.h"
+#include "common/WorkerPool.h"
 #include "Utils.h"
 
 int GZIP::GZip_Decompress(unsigned char *output, int outputLen, unsigned char *input, int inputLen) {
@@ -66,22 +73,17 @@ int GZIP::GZip_CompressBound(int inputLen) {
 }
 
 bool GZIP::GZip_CompressToFile(unsigned char *input, int inputLen, std::string filename) {
-    unsigned char* compressed;
-    compressed = new unsigned char[inputLen];
-    int compResult = GZip_Compress(compressed, inputLen, input, inputLen);
+    std::vector<unsigned char> compressed;
+    compressed.reserve(compressBound(inputLen) + 64);
 
-    if (compResult == -1) {
-        delete[] compressed;
+    if (GZip_CompressParallel(compressed, input, inputLen) == -1)
         return false;
-    }
 
     std::ofstream wf(filename, std::ios::out | std::ios::binary);
-    wf.write((char *)compressed, compResult);
+    wf.write(reinterpret_cast<char *>(compressed.data()), static_cast<std::streamsize>(compressed.size()));
     wf.close();
 
-    delete[] compressed;
-
-    return true;
+    return !wf.fail();
 }
 
 int GZIP::GZip_DecompressFromFile(unsigned char *output, int outputLen, std::string filename) {
@@ -107,3 +109,371 @@ int GZIP::GZip_DecompressFromFile(unsigned char *output, int outputLen, std::str
     delete[] data;
     return decompResult;
 }
+
+const int GZIP_STREAM_CHUNK = 65536;
+
+bool GZIP::GZip_CompressToFileStreamed(int64_t inputLen, const std::function<int(unsigned char *, int)>& source, const std::string& filename) {
+    z_stream strm;
+    strm.zalloc = Z_NULL;
+    strm.zfree = Z_NULL;
+    strm.opaque = Z_NULL;
+
+    if (deflateInit2(&strm, Z_DEFAULT_COMPRESSION, Z_DEFLATED, 15+16, 8, Z_DEFAULT_STRATEGY) != Z_OK)
+        return false;
+
+    std::ofstream wf(filename, std::ios::out | std::ios::binary);
+    if (!wf.is_open()) {
+        deflateEnd(&strm);
+        return false;
+    }
+
+    std::vector<unsigned char> inBuf(GZIP_STREAM_CHUNK);
+    std::vector<unsigned char> outBuf(GZIP_STREAM_CHUNK);
+    int64_t remaining = inputLen;
+    int flush;
+
+    do {
+        int want = static_cast<int>(std::min(remaining, static_cast<int64_t>(GZIP_STREAM_CHUNK)));
+        int got = (want > 0) ? source(inBuf.data(), want) : 0;
+
+        if (got < 0 || got > want) {
+            deflateEnd(&strm);
+            return false;
+        }
+
+        remaining -= got;
+        flush = (remaining == 0 || got == 0) ? Z_FINISH : Z_NO_FLUSH;
+        strm.next_in = inBuf.data();
+        strm.avail_in = got;
+
+        do {
+            strm.next_out = outBuf.data();
+            strm.avail_out = GZIP_STREAM_CHUNK;
+            if (deflate(&strm, flush) == Z_STREAM_ERROR) {
+                deflateEnd(&strm);
+                return false;
+            }
+            wf.write(reinterpret_cast<char*>(outBuf.data()), GZIP_STREAM_CHUNK - strm.avail_out);
+        } while (strm.avail_out == 0);
+    } while (flush != Z_FINISH);
+
+    deflateEnd(&strm);
+    wf.close();
+    return !wf.fail();
+}
+
+int64_t GZIP::GZip_DecompressFromFileStreamed(const std::function<void(const unsigned char *, int)>& sink, const std::string& filename) {
+    std::ifstream rf(filename, std::ios::in | std::ios::binary);
+
+    if (!rf.is_open())
+        return -1;
+
+    z_stream strm;
+    strm.zalloc = Z_NULL;
+    strm.zfree = Z_NULL;
+    strm.opaque = Z_NULL;
+    strm.avail_in = 0;
+    strm.next_in = Z_NULL;
+
+    if (inflateInit2(&strm, 15+32) != Z_OK)
+        return -1;
+
+    std::vector<unsigned char> inBuf(GZIP_STREAM_CHUNK);
+    std::vector<unsigned char> outBuf(GZIP_STREAM_CHUNK);
+    int64_t total = 0;
+    int ret = Z_OK;
+
+    while (ret != Z_STREAM_END) {
+        rf.read(reinterpret_cast<char*>(inBuf.data()), GZIP_STREAM_CHUNK);
+        auto readBytes = static_cast<unsigned int>(rf.gcount());
+
+        if (readBytes == 0)
+            break;
+
+        strm.next_in = inBuf.data();
+        strm.avail_in = readBytes;
+
+        do {
+            strm.next_out = outBuf.data();
+            strm.avail_out = GZIP_STREAM_CHUNK;
+            ret = inflate(&strm, Z_NO_FLUSH);
+
+            if (ret != Z_OK && ret != Z_STREAM_END && ret != Z_BUF_ERROR) {
+                inflateEnd(&strm);
+                return -1;
+            }
+
+            int produced = GZIP_STREAM_CHUNK - static_cast<int>(strm.avail_out);
+            if (produced > 0) {
+                sink(outBuf.data(), produced);
+                total += produced;
+            }
+        } while (strm.avail_out == 0 && ret != Z_STREAM_END);
+    }
+
+    inflateEnd(&strm);
+    return total;
+}
+
+const int GZIP_PARALLEL_BLOCK = 131072;
+const int GZIP_WINDOW_SIZE = 32768;
+
+namespace {
+    // -- Shared by all parallel compression; callers deflate blocks of their own batch as well.
+    D3PP::Common::WorkerPool& DeflatePool() {
+        static D3PP::Common::WorkerPool pool(static_cast<int>(std::max(1u, std::thread::hardware_concurrency())));
+        return pool;
+    }
+
+    // -- Deflates consecutive batches of input as one raw deflate stream. Each block is primed with the
+    // -- 32 KiB preceding it, so the ratio stays close to a single-threaded stream.
+    class ParallelDeflater {
+    public:
+        ParallelDeflater() : m_crc(crc32(0L, Z_NULL, 0)), m_totalLen(0) {
+            m_threads = std::max(1u, std::thread::hardware_concurrency());
+        }
+
+        [[nodiscard]] int ThreadCount() const { return static_cast<int>(m_threads); }
+
+        static void WriteHeader(std::vector<unsigned char>& output) {
+            const unsigned char header[10] = { 0x1f, 0x8b, Z_DEFLATED, 0, 0, 0, 0, 0, 0, 0xff };
+            output.insert(output.end(), header, header + 10);
+        }
+
+        void WriteTrailer(std::vector<unsigned char>& output) const {
+            for (int i = 0; i < 4; i++)
+                output.push_back(static_cast<unsigned char>((m_crc >> (8 * i)) & 0xFF));
+            for (int i = 0; i < 4; i++)
+                output.push_back(static_cast<unsigned char>((m_totalLen >> (8 * i)) & 0xFF));
+        }
+
+        bool CompressBatch(const unsigned char* data, int64_t len, bool last, std::vector<unsigned char>& output) {
+            int blockCount = std::max(1, static_cast<int>((len + GZIP_PARALLEL_BLOCK - 1) / GZIP_PARALLEL_BLOCK));
+            auto batch = std::make_shared<Batch>(blockCount);
+            int workers = std::min(static_cast<int>(m_threads), blockCount);
+
+            // -- Blocks are claimed one at a time by the caller and by pool tasks alike, so the batch finishes
+            // -- even if every pool thread is busy. Tasks that start late find nothing left and never touch data.
+            auto work = [batch, data, len, last, dictionary = &m_dictionary]() {
+                int i;
+                while ((i = batch->Next++) < batch->BlockCount) {
+                    int64_t start = static_cast<int64_t>(i) * GZIP_PARALLEL_BLOCK;
+                    int blockLen = static_cast<int>(std::min(static_cast<int64_t>(GZIP_PARALLEL_BLOCK), len - start));
+                    const unsigned char* dict;
+                    int dictLen;
+
+                    if (i == 0) {
+                        dict = dictionary->data();
+                        dictLen = static_cast<int>(dictionary->size());
+                    } else {
+                        dictLen = static_cast<int>(std::min(static_cast<int64_t>(GZIP_WINDOW_SIZE), start));
+                        dict = data + start - dictLen;
+                    }
+
+                    batch->Crcs[i] = crc32(0L, data + start, blockLen);
+                    batch->Succeeded[i] = DeflateBlock(data + start, blockLen, dict, dictLen, last && i == batch->BlockCount - 1, batch->Results[i]);
+
+                    std::scoped_lock<std::mutex> bLock(batch->Lock);
+                    if (++batch->Done == batch->BlockCount)
+                        batch->Finished.notify_all();
+                }
+            };
+
+            for (int t = 1; t < workers; t++)
+                DeflatePool().Submit(work);
+            work();
+
+            {
+                std::unique_lock<std::mutex> bLock(batch->Lock);
+                batch->Finished.wait(bLock, [&batch]() { return batch->Done == batch->BlockCount; });
+            }
+
+            std::vector<std::vector<unsigned char>>& results = batch->Results;
+            std::vector<uLong>& crcs = batch->Crcs;
+            std::vector<char>& succeeded = batch->Succeeded;
+
+            for (int i = 0; i < blockCount; i++) {
+                if (!succeeded[i])
+                    return false;
+
+                int64_t start = static_cast<int64_t>(i) * GZIP_PARALLEL_BLOCK;
+                int64_t blockLen = std::min(static_cast<int64_t>(GZIP_PARALLEL_BLOCK), len - start);
+                m_crc = crc32_combine(m_crc, crcs[i], static_cast<z_off_t>(blockLen));
+                output.insert(output.end(), results[i].begin(), results[i].end());
+            }
+
+            m_totalLen += len;
+            int keep = static_cast<int>(std::min(static_cast<int64_t>(GZIP_WINDOW_SIZE), len));
+            if (keep < GZIP_WINDOW_SIZE && !m_dictionary.empty()) {
+                int carry = std::min(static_cast<int>(m_dictionary.size()), GZIP_WINDOW_SIZE - keep);
+                m_dictionary.erase(m_dictionary.begin(), m_dictionary.end() - carry);
+            } else {
+                m_dictionary.clear();
+            }
+            m_dictionary.insert(m_dictionary.end(), data + len - keep, data + len);
+            return true;
+        }
+    private:
+        struct Batch {
+            explicit Batch(int blockCount) : BlockCount(blockCount), Results(blockCount), Crcs(blockCount), Succeeded(blockCount, 0), Next(0), Done(0) {}
+
+            int BlockCount;
+            std::vector<std::vector<unsigned char>> Results;
+            std::vector<uLong> Crcs;
+            std::vector<char> Succeeded;
+            std::atomic<int> Next;
+            int Done;
+            std::mutex Lock;
+            std::condition_variable Finished;
+        };
+
+        unsigned int m_threads;
+        uLong m_crc;
+        int64_t m_totalLen;
+        std::vector<unsigned char> m_dictionary;
+
+        static bool DeflateBlock(const unsigned char* input, int inputLen, const unsigned char* dict, int dictLen, bool last, std::vector<unsigned char>& output) {
+            z_stream strm;
+            strm.zalloc = Z_NULL;
+            strm.zfree = Z_NULL;
+            strm.opaque = Z_NULL;
+
+            if (deflateInit2(&strm, Z_DEFAULT_COMPRESSION, Z_DEFLATED, -15, 8, Z_DEFAULT_STRATEGY) != Z_OK)
+                return false;
+
+            if (dictLen > 0 && deflateSetDictionary(&strm, dict, dictLen) != Z_OK) {
+                deflateEnd(&strm);
+                return false;
+            }
+
+            // -- Sync flush byte-aligns every block that isn't the last, so the pieces can simply be concatenated.
+            int flush = last ? Z_FINISH : Z_SYNC_FLUSH;
+            output.resize(deflateBound(&strm, inputLen) + 16);
+            strm.next_in = const_cast<unsigned char*>(input);
+            strm.avail_in = inputLen;
+            strm.next_out = output.data();
+            strm.avail_out = static_cast<uInt>(output.size());
+
+            int result = deflate(&strm, flush);
+            while (result == Z_OK && strm.avail_out == 0) {
+                size_t used = output.size();
+                output.resize(used * 2);
+                strm.next_out = output.data() + used;
+                strm.avail_out = static_cast<uInt>(output.size() - used);
+                result = deflate(&strm, flush);
+            }
+
+            bool ok = last ? (result == Z_STREAM_END) : (result == Z_OK || result == Z_BUF_ERROR);
+            output.resize(strm.total_out);
+            deflateEnd(&strm);
+            return ok;
+        }
+    };
+}
+
+int64_t GZIP::GZip_CompressParallel(std::vector<unsigned char>& output, const unsigned char *input, int64_t inputLen) {
+    ParallelDeflater deflater;
+    size_t startSize = output.size();
+
+    ParallelDeflater::WriteHeader(output);
+    if (!deflater.CompressBatch(input, inputLen, true, output)) {
+        output.resize(startSize);
+        return -1;
+    }
+    deflater.WriteTrailer(output);
+
+    return static_cast<int64_t>(output.size() - startSize);
+}
+
+bool GZIP::GZip_CompressToFileParallel(int64_t inputLen, const std::function<int(unsigned char *, int)>& source, const std::string& filename) {
+    std::ofstream wf(filename, std::ios::out | std::ios::binary);
+    if (!wf.is_open())
+        return false;
+
+    ParallelDeflater deflater;
+    // -- A few blocks per thread are pulled from the source at a time, so memory use stays bounded.
+    int64_t batchSize = static_cast<int64_t>(deflater.ThreadCount()) * 4 * GZIP_PARALLEL_BLOCK;
+    std::vector<unsigned char> inBuf(static_cast<size_t>(std::min(batchSize, std::max(inputLen, static_cast<int64_t>(1)))));
+    std::vector<unsigned char> outBuf;
+    int64_t remaining = inputLen;
+    bool last = false;
+
+    ParallelDeflater::WriteHeader(outBuf);
+
+    while (!last) {
+        int64_t want = std::min(remaining, static_cast<int64_t>(inBuf.size()));
+        int64_t got = 0;
+
+        while (got < want) {
+            int request = static_cast<int>(std::min(want - got, static_cast<int64_t>(GZIP_STREAM_CHUNK)));
+            int read = source(inBuf.data() + got, request);
+
+            if (read < 0 || read > request)
+                return false;
+            if (read == 0)
+                break;
+
+            got += read;
+        }
+
+        remaining -= got;
+        last = (remaining == 0 || got < want);
+
+        if (!deflater.CompressBatch(inBuf.data(), got, last, outBuf))
+            return false;
+
+        if (last)
+            deflater.WriteTrailer(outBuf);
+
+        wf.write(reinterpret_cast<char*>(outBuf.data()), static_cast<std::streamsize>(outBuf.size()));
+        outBuf.clear();
+    }
+
+    wf.close();
+    return !wf.fail();
+}
+
+GZipStream::GZipStream(bool raw) : m_stream(std::make_unique<z_stream>()) {
+    m_stream->zalloc = Z_NULL;
+    m_stream->zfree = Z_NULL;
+    m_stream->opaque = Z_NULL;
+    m_valid = deflateInit2(m_stream.get(), Z_DEFAULT_COMPRESSION, Z_DEFLATED, raw ? -15 : 15+16, 8, Z_DEFAULT_STRATEGY) == Z_OK;
+}
+
+GZipStream::~GZipStream() {
+    if (m_valid)
+        deflateEnd(m_stream.get());
+}
+
+bool GZipStream::Write(const unsigned char *input, int inputLen, bool finish, std::vector<unsigned char>& output) {
+    if (!m_valid)
+        return false;
+
+    int flush = finish ? Z_FINISH : Z_NO_FLUSH;
+    m_stream->next_in = const_cast<unsigned char *>(input);
+    m_stream->avail_in = inputLen;
+
+    // -- Deflate keeps up to its window buffered, so most calls without finish produce little or nothing.
+    do {
+        size_t used = output.size();
+        output.resize(used + GZIP_STREAM_CHUNK);
+        m_stream->next_out = output.data() + used;
+        m_stream->avail_out = GZIP_STREAM_CHUNK;
+
+        int result = deflate(m_stream.get(), flush);
+        output.resize(output.size() - m_stream->avail_out);
+
+        if (result == Z_STREAM_ERROR) {
+            deflateEnd(m_stream.get());
+            m_valid = false;
+            return false;
+        }
+    } while (m_stream->avail_out == 0);
+
+    if (finish) {
+        deflateEnd(m_stream.get());
+        m_valid = false;
+    }
+
+    return true;
+}
@@ -0,0 +1,231 @@
+#include "files/BlockJournal.h"
+
+#include <ctime>
+#include <filesystem>
+#include <fstream>
+#include <vector>
+#ifdef __linux__
+#include <fcntl.h>
+#include <unistd.h>
+#else
+#include <io.h>
+#endif
+#include "common/Logger.h"
+#include "Utils.h"
+
+const int JOURNAL_RECORD_SIZE = 16;
+// -- Coordinate no block can have, used for all three axes of a barrier record.
+const short JOURNAL_BARRIER = -1;
+
+static bool SyncFile(std::FILE* file) {
+    if (std::fflush(file) != 0)
+        return false;
+#ifdef __linux__
+    return fsync(fileno(file)) == 0;
+#else
+    return _commit(_fileno(file)) == 0;
+#endif
+}
+
+namespace D3PP::files {
+    BlockJournal::BlockJournal(const std::string& folder) {
+        m_fileName = folder;
+        if (!m_fileName.empty() && m_fileName[m_fileName.size() - 1] != '/')
+            m_fileName += "/";
+
+        m_fileName += D3_MAP_JOURNAL_NAME;
+        m_file = nullptr;
+        m_size = 0;
+    }
+
+    BlockJournal::~BlockJournal() {
+        if (m_file != nullptr)
+            std::fclose(m_file);
+    }
+
+    bool BlockJournal::Open() {
+        if (m_file != nullptr)
+            return true;
+
+        m_file = std::fopen(m_fileName.c_str(), "ab");
+        if (m_file == nullptr) {
+            Logger::LogAdd("BlockJournal", "Could not open journal [" + m_fileName + "]", LogType::L_ERROR, GLF);
+            return false;
+        }
+
+        std::error_code ec;
+        auto fileSize = std::filesystem::file_size(m_fileName, ec);
+        m_size = ec ? 0 : static_cast<int64_t>(fileSize);
+        return true;
+    }
+
+    bool BlockJournal::AppendBarrier() {
+        return Append(Common::Vector3S(JOURNAL_BARRIER, JOURNAL_BARRIER, JOURNAL_BARRIER), 0, 0);
+    }
+
+    bool BlockJournal::Append(const Common::Vector3S& location, unsigned char type, short player) {
+        unsigned char record[JOURNAL_RECORD_SIZE];
+        auto now = static_cast<int64_t>(time(nullptr));
+        record[0] = location.X & 0xFF;
+        record[1] = (location.X >> 8) & 0xFF;
+        record[2] = location.Y & 0xFF;
+        record[3] = (location.Y >> 8) & 0xFF;
+        record[4] = location.Z & 0xFF;
+        record[5] = (location.Z >> 8) & 0xFF;
+        record[6] = type;
+        record[7] = player & 0xFF;
+        record[8] = (player >> 8) & 0xFF;
+        for (int i = 0; i < 6; i++)
+            record[9 + i] = static_cast<unsigned char>((now >> (i * 8)) & 0xFF);
+
+        unsigned char check = 0xA5;
+        for (int i = 0; i < JOURNAL_RECORD_SIZE - 1; i++)
+            check ^= record[i];
+        record[JOURNAL_RECORD_SIZE - 1] = check;
+
+        std::scoped_lock<std::mutex> pLock(m_lock);
+        if (!Open())
+            return false;
+
+        if (std::fwrite(record, 1, JOURNAL_RECORD_SIZE, m_file) != JOURNAL_RECORD_SIZE)
+            return false;
+
+        m_size += JOURNAL_RECORD_SIZE;
+        return true;
+    }
+
+    bool BlockJournal::Sync() {
+        std::scoped_lock<std::mutex> pLock(m_lock);
+        if (m_file == nullptr)
+            return true;
+
+        return SyncFile(m_file);
+    }
+
+    bool BlockJournal::Truncate(int64_t offset) {
+        std::scoped_lock<std::mutex> pLock(m_lock);
+        if (m_file != nullptr) {
+            std::fclose(m_file);
+            m_file = nullptr;
+        }
+
+        // -- Records appended while the snapshot was being written are kept; replaying them again is harmless.
+        std::vector<char> tail;
+        std::ifstream iStream(m_fileName, std::ios::in | std::ios::binary);
+        if (iStream.is_open()) {
+            iStream.seekg(0, std::ios::end);
+            int64_t fileSize = iStream.tellg();
+            if (fileSize > offset) {
+                tail.resize(fileSize - offset);
+                iStream.seekg(offset, std::ios::beg);
+                iStream.read(tail.data(), static_cast<std::streamsize>(tail.size()));
+            }
+            iStream.close();
+        }
+
+        // -- The tail goes to a temp file that replaces the journal whole, a crash leaves either the old or the new one.
+        std::string tempName = m_fileName + ".tmp";
+        std::FILE* rewritten = std::fopen(tempName.c_str(), "wb");
+        if (rewritten == nullptr) {
+            Logger::LogAdd("BlockJournal", "Could not open [" + tempName + "]", LogType::L_ERROR, GLF);
+            return false;
+        }
+
+        bool written = tail.empty() || std::fwrite(tail.data(), 1, tail.size(), rewritten) == tail.size();
+        written = SyncFile(rewritten) && written;
+        std::fclose(rewritten);
+
+        std::error_code ec;
+        if (written)
+            std::filesystem::rename(tempName, m_fileName, ec);
+
+        if (!written || ec) {
+            Logger::LogAdd("BlockJournal", "Could not replace journal [" + m_fileName + "]", LogType::L_ERROR, GLF);
+            std::filesystem::remove(tempName, ec);
+            return false;
+        }
+
+#ifdef __linux__
+        // -- The rename itself only survives a crash once the directory entry is on disk.
+        std::string folder = std::filesystem::path(m_fileName).parent_path().string();
+        int dirFd = open(folder.empty() ? "." : folder.c_str(), O_RDONLY | O_DIRECTORY);
+        if (dirFd != -1) {
+            fsync(dirFd);
+            close(dirFd);
+        }
+#endif
+        m_size = static_cast<int64_t>(tail.size());
+        return true;
+    }
+
+    int BlockJournal::Replay(const std::function<void(const BlockJournalEntry&)>& apply) {
+        std::scoped_lock<std::mutex> pLock(m_lock);
+        if (m_file != nullptr)
+            std::fflush(m_file);
+
+        std::ifstream iStream(m_fileName, std::ios::in | std::ios::binary);
+        if (!iStream.is_open())
+            return 0;
+
+        int applied = 0;
+        int64_t fileSize = 0;
+        unsigned char record[JOURNAL_RECORD_SIZE];
+        iStream.seekg(0, std::ios::end);
+        fileSize = iStream.tellg();
+        iStream.seekg(0, std::ios::beg);
+
+        while (iStream.read(reinterpret_cast<char*>(record), JOURNAL_RECORD_SIZE)) {
+            unsigned char check = 0xA5;
+            for (int i = 0; i < JOURNAL_RECORD_SIZE - 1; i++)
+                check ^= record[i];
+
+            if (check != record[JOURNAL_RECORD_SIZE - 1]) {
+                Logger::LogAdd("BlockJournal", "Corrupt record in [" + m_fileName + "], stopping replay after " + stringulate(applied) + " entries.", LogType::WARNING, GLF);
+                break;
+            }
+
+            BlockJournalEntry entry{};
+            entry.Location.X = static_cast<short>(record[0] | (record[1] << 8));
+            entry.Location.Y = static_cast<short>(record[2] | (record[3] << 8));
+            entry.Location.Z = static_cast<short>(record[4] | (record[5] << 8));
+
+            if (entry.Location.X == JOURNAL_BARRIER && entry.Location.Y == JOURNAL_BARRIER && entry.Location.Z == JOURNAL_BARRIER) {
+                Logger::LogAdd("BlockJournal", "Barrier in [" + m_fileName + "], the block layer was replaced after the last snapshot; dropping the records behind it.", LogType::WARNING, GLF);
+                break;
+            }
+
+            entry.Type = record[6];
+            entry.Player = static_cast<short>(record[7] | (record[8] << 8));
+            for (int i = 0; i < 6; i++)
+                entry.Time |= static_cast<int64_t>(record[9 + i]) << (i * 8);
+
+            apply(entry);
+            applied++;
+        }
+        iStream.close();
+
+        // -- Drop a torn or corrupt tail so that new records are not appended behind it.
+        int64_t validSize = static_cast<int64_t>(applied) * JOURNAL_RECORD_SIZE;
+        if (validSize < fileSize) {
+            if (m_file != nullptr) {
+                std::fclose(m_file);
+                m_file = nullptr;
+            }
+            std::error_code ec;
+            std::filesystem::resize_file(m_fileName, validSize, ec);
+        }
+
+        return applied;
+    }
+
+    int64_t BlockJournal::Size() {
+        std::scoped_lock<std::mutex> pLock(m_lock);
+        if (m_file == nullptr) {
+            std::error_code ec;
+            auto fileSize = std::filesystem::file_size(m_fileName, ec);
+            return ec ? 0 : static_cast<int64_t>(fileSize);
+        }
+
+        return m_size;
+    }
+}
@@ -0,0 +1,259 @@
+#include "files/ChunkedBlockFile.h"
+
+#include <algorithm>
+#include <cstring>
+#include <zlib.h>
+#ifdef __linux__
+#include <unistd.h>
+#include "common/IoUring.h"
+#else
+#include <io.h>
+#endif
+#include "common/Logger.h"
+#include "Utils.h"
+
+namespace D3PP::files {
+    ChunkedBlockFile::ChunkedBlockFile(const std::string& fileName) : m_header{} {
+        m_fileName = fileName;
+        m_file = nullptr;
+        m_fileSize = 0;
+    }
+
+    ChunkedBlockFile::~ChunkedBlockFile() {
+        Close();
+    }
+
+    void ChunkedBlockFile::Close() {
+        if (m_file != nullptr) {
+            std::fclose(m_file);
+            m_file = nullptr;
+        }
+    }
+
+    bool ChunkedBlockFile::Create(const Common::Vector3S& size, int chunkBlocks) {
+        Close();
+        m_file = std::fopen(m_fileName.c_str(), "w+b");
+
+        if (m_file == nullptr) {
+            Logger::LogAdd("ChunkedBlockFile", "Could not create [" + m_fileName + "]", LogType::L_ERROR, GLF);
+            return false;
+        }
+
+        int64_t volume = static_cast<int64_t>(size.X) * size.Y * size.Z;
+        m_header = ChunkedFileHeader{};
+        std::memcpy(m_header.Magic, "D3CK", 4);
+        m_header.Version = D3_MAP_CHUNKED_VERSION;
+        m_header.SizeX = size.X;
+        m_header.SizeY = size.Y;
+        m_header.SizeZ = size.Z;
+        m_header.ChunkBlocks = chunkBlocks;
+        m_header.ChunkCount = static_cast<uint32_t>((volume + chunkBlocks - 1) / chunkBlocks);
+        m_index.assign(m_header.ChunkCount, ChunkIndexEntry{});
+
+        if (std::fwrite(&m_header, sizeof(m_header), 1, m_file) != 1) {
+            Close();
+            return false;
+        }
+
+        m_fileSize = sizeof(m_header);
+        return true;
+    }
+
+    bool ChunkedBlockFile::Open() {
+        Close();
+        m_file = std::fopen(m_fileName.c_str(), "r+b");
+
+        if (m_file == nullptr)
+            return false;
+
+        if (std::fread(&m_header, sizeof(m_header), 1, m_file) != 1 || std::memcmp(m_header.Magic, "D3CK", 4) != 0 || m_header.Version != D3_MAP_CHUNKED_VERSION || m_header.ChunkBlocks == 0) {
+            Logger::LogAdd("ChunkedBlockFile", "Invalid header in [" + m_fileName + "]", LogType::L_ERROR, GLF);
+            Close();
+            return false;
+        }
+
+        m_index.assign(m_header.ChunkCount, ChunkIndexEntry{});
+        if (!Seek(static_cast<int64_t>(m_header.IndexOffset)) || std::fread(m_index.data(), sizeof(ChunkIndexEntry), m_index.size(), m_file) != m_index.size() || IndexCrc() != m_header.IndexCrc) {
+            Logger::LogAdd("ChunkedBlockFile", "Corrupt chunk index in [" + m_fileName + "]", LogType::L_ERROR, GLF);
+            Close();
+            return false;
+        }
+
+#ifdef __linux__
+        fseeko(m_file, 0, SEEK_END);
+        m_fileSize = ftello(m_file);
+#else
+        _fseeki64(m_file, 0, SEEK_END);
+        m_fileSize = _ftelli64(m_file);
+#endif
+        return true;
+    }
+
+    bool ChunkedBlockFile::ReadChunk(int chunk, std::vector<unsigned char>& data) {
+        if (m_file == nullptr || chunk < 0 || chunk >= ChunkCount() || m_index[chunk].Length == 0)
+            return false;
+
+        const ChunkIndexEntry& entry = m_index[chunk];
+        std::vector<unsigned char> compressed(entry.Length);
+
+        if (!Seek(static_cast<int64_t>(entry.Offset)) || std::fread(compressed.data(), 1, compressed.size(), m_file) != compressed.size())
+            return false;
+
+        return Inflate(chunk, compressed, data);
+    }
+
+    bool ChunkedBlockFile::ReadChunks(int first, int count, std::vector<std::vector<unsigned char>>& chunks) {
+        if (m_file == nullptr || first < 0 || count < 0 || first + count > ChunkCount())
+            return false;
+
+        chunks.resize(count);
+#ifdef __linux__
+        if (m_ring == nullptr && Common::IoUring::Supported())
+            m_ring = std::make_unique<Common::IoUring>();
+
+        if (m_ring != nullptr && m_ring->Available()) {
+            std::vector<std::vector<unsigned char>> compressed(count);
+            std::vector<Common::IoRequest> requests(count);
+            int fd = fileno(m_file);
+
+            for (int i = 0; i < count; i++) {
+                const ChunkIndexEntry& entry = m_index[first + i];
+                if (entry.Length == 0)
+                    return false;
+
+                compressed[i].resize(entry.Length);
+                requests[i] = Common::IoRequest{fd, Common::IoOperation::Read, compressed[i].data(), entry.Length, static_cast<int64_t>(entry.Offset), 0};
+            }
+
+            if (std::fflush(m_file) != 0 || !m_ring->SubmitAndWait(requests))
+                return false;
+
+            for (int i = 0; i < count; i++) {
+                if (requests[i].Result != static_cast<int>(requests[i].Length) || !Inflate(first + i, compressed[i], chunks[i]))
+                    return false;
+            }
+
+            return true;
+        }
+#endif
+        for (int i = 0; i < count; i++) {
+            if (!ReadChunk(first + i, chunks[i]))
+                return false;
+        }
+
+        return true;
+    }
+
+    bool ChunkedBlockFile::Inflate(int chunk, const std::vector<unsigned char>& compressed, std::vector<unsigned char>& data) {
+        const ChunkIndexEntry& entry = m_index[chunk];
+        uLongf expected = static_cast<uLongf>(ChunkLength(chunk)) * 4;
+        data.resize(expected);
+        uLongf produced = expected;
+
+        if (uncompress(data.data(), &produced, compressed.data(), entry.Length) != Z_OK || produced != expected) {
+            Logger::LogAdd("ChunkedBlockFile", "Could not inflate chunk " + stringulate(chunk) + " of [" + m_fileName + "]", LogType::L_ERROR, GLF);
+            return false;
+        }
+
+        if (crc32(0L, data.data(), static_cast<uInt>(produced)) != entry.Crc) {
+            Logger::LogAdd("ChunkedBlockFile", "Checksum mismatch in chunk " + stringulate(chunk) + " of [" + m_fileName + "]", LogType::L_ERROR, GLF);
+            return false;
+        }
+
+        return true;
+    }
+
+    bool ChunkedBlockFile::WriteChunk(int chunk, const unsigned char* data, int length) {
+        if (m_file == nullptr || chunk < 0 || chunk >= ChunkCount() || length != ChunkLength(chunk) * 4)
+            return false;
+
+        uLongf compressedLength = compressBound(length);
+        std::vector<unsigned char> compressed(compressedLength);
+
+        if (compress2(compressed.data(), &compressedLength, data, length, Z_DEFAULT_COMPRESSION) != Z_OK)
+            return false;
+
+        if (!Seek(m_fileSize) || std::fwrite(compressed.data(), 1, compressedLength, m_file) != compressedLength)
+            return false;
+
+        m_index[chunk].Offset = static_cast<uint64_t>(m_fileSize);
+        m_index[chunk].Length = static_cast<uint32_t>(compressedLength);
+        m_index[chunk].Crc = crc32(0L, data, length);
+        m_fileSize += static_cast<int64_t>(compressedLength);
+        return true;
+    }
+
+    bool ChunkedBlockFile::Commit() {
+        if (m_file == nullptr)
+            return false;
+
+        int64_t indexOffset = m_fileSize;
+        if (!Seek(indexOffset) || std::fwrite(m_index.data(), sizeof(ChunkIndexEntry), m_index.size(), m_file) != m_index.size())
+            return false;
+
+        // -- Chunks and index must be on disk before the header points at them.
+        if (!Sync())
+            return false;
+
+        m_fileSize += static_cast<int64_t>(m_index.size() * sizeof(ChunkIndexEntry));
+        m_header.IndexOffset = static_cast<uint64_t>(indexOffset);
+        m_header.IndexCrc = IndexCrc();
+
+        if (!Seek(0) || std::fwrite(&m_header, sizeof(m_header), 1, m_file) != 1)
+            return false;
+
+        return Sync();
+    }
+
+    bool ChunkedBlockFile::Verify() {
+        std::vector<std::vector<unsigned char>> chunks;
+
+        for (int i = 0; i < ChunkCount(); i += D3_MAP_CHUNKED_READ_BATCH) {
+            if (!ReadChunks(i, std::min(D3_MAP_CHUNKED_READ_BATCH, ChunkCount() - i), chunks))
+                return false;
+        }
+
+        return true;
+    }
+
+    Common::Vector3S ChunkedBlockFile::GetSize() const {
+        return Common::Vector3S{m_header.SizeX, m_header.SizeY, m_header.SizeZ};
+    }
+
+    int ChunkedBlockFile::ChunkLength(int chunk) const {
+        int64_t volume = static_cast<int64_t>(m_header.SizeX) * m_header.SizeY * m_header.SizeZ;
+        int64_t start = static_cast<int64_t>(chunk) * m_header.ChunkBlocks;
+        return static_cast<int>(std::min(static_cast<int64_t>(m_header.ChunkBlocks), volume - start));
+    }
+
+    int64_t ChunkedBlockFile::DeadBytes() const {
+        int64_t live = sizeof(m_header) + static_cast<int64_t>(m_index.size() * sizeof(ChunkIndexEntry));
+
+        for (const auto& entry : m_index)
+            live += entry.Length;
+
+        return m_fileSize - live;
+    }
+
+    bool ChunkedBlockFile::Seek(int64_t offset) {
+#ifdef __linux__
+        return fseeko(m_file, offset, SEEK_SET) == 0;
+#else
+        return _fseeki64(m_file, offset, SEEK_SET) == 0;
+#endif
+    }
+
+    bool ChunkedBlockFile::Sync() {
+        if (std::fflush(m_file) != 0)
+            return false;
+#ifdef __linux__
+        return fsync(fileno(m_file)) == 0;
+#else
+        return _commit(_fileno(m_file)) == 0;
+#endif
+    }
+
+    uint32_t ChunkedBlockFile::IndexCrc() const {
+        return crc32(0L, reinterpret_cast<const unsigned char*>(m_index.data()), static_cast<uInt>(m_index.size() * sizeof(ChunkIndexEntry)));
+    }
+}
@@ -3,8 +3,12 @@
 #include "common/Logger.h"
 #include "Utils.h"
 #include "compression.h"
+#include "files/ChunkedBlockFile.h"
 #include "world/CustomParticle.h"
 #include <climits>
+#include <algorithm>
+#include <memory>
+#include <zlib.h>
 
 namespace D3PP::files {
 		D3Map::D3Map(const std::string& folder) :
@@ -26,12 +30,14 @@ namespace D3PP::files {
             rboxChanged = true;
 		}
 
-		D3Map::D3Map(const std::string& folder, const std::string& name, const Common::Vector3S& mapSize) :
+		D3Map::D3Map(const std::string& folder, const std::string& name, const Common::Vector3S& mapSize, bool externalBlockLayer) :
+        MapSpawn{},
         m_configFile(D3_MAP_CONFIG_NAME, folder),
         Particles(),
         Teleporter()
 		{
             mapPath = folder;
+            ExternalBlockLayer = externalBlockLayer;
             SaveInterval = 10;
             ServerVersion = 1004;
             OverviewType = D3OverviewType::Iso;
@@ -48,7 +54,7 @@ namespace D3PP::files {
                 static_cast<short>(MapSize.Z/2)};
 
             MapSpawn.SetAsBlockCoords(defaultSpawn);
-            MapData.resize((mapSize.X * mapSize.Y * mapSize.Z) * 4);
+            Resize(mapSize);
 		}
 
 		bool D3Map::Load()
@@ -61,7 +67,7 @@ namespace D3PP::files {
                 mapPath = mapPath + "/";
             }
 
-            bool loadResult = ReadConfig() && ReadMapData();
+            bool loadResult = ReadConfig() && (ExternalBlockLayer || ReadMapData());
             ReadRankBoxes();
             ReadPortals();
             ReadParticles();
@@ -78,7 +84,7 @@ namespace D3PP::files {
             }
             std::string ogMapPath = mapPath;
             mapPath = path;
-            bool loadResult = ReadConfig() && ReadMapData();
+            bool loadResult = ReadConfig() && (ExternalBlockLayer || ReadMapData());
             ReadRankBoxes();
             ReadPortals();
             ReadParticles();
@@ -97,7 +103,7 @@ namespace D3PP::files {
             if (result)
                 result = SavePortals();
 
-            if (result)
+            if (result && !ExternalBlockLayer)
                 result = SaveMapData();
 
             if (result)
@@ -120,7 +126,7 @@ namespace D3PP::files {
             if (result)
                 result = SavePortals();
 
-            if (result)
+            if (result && !ExternalBlockLayer)
                 result = SaveMapData();
 
             if (result)
@@ -129,8 +135,13 @@ namespace D3PP::files {
             mapPath = oldPath;
             return result;
         }
+        bool D3Map::SaveWithoutBlocks() {
+            std::filesystem::create_directory(mapPath);
+            return SaveConfig() && SaveRankBoxes() && SavePortals() && SaveParticles();
+        }
+
         void D3Map::Resize(Common::Vector3S newSize) {
-            int newMapSize = (newSize.X * newSize.Y * newSize.Z) * 4;
+            size_t newMapSize = static_cast<size_t>(newSize.X) * newSize.Y * newSize.Z;
             // -- Spawn limiting..
             int spawnX, spawnY, spawnZ;
             if (MapSpawn.X() > newSize.X)
@@ -143,35 +154,177 @@ namespace D3PP::files {
                 spawnZ = newSize.Z - 1;
 
             MapSize = newSize;
-            MapData.resize(newMapSize);
             dataChanged = true;
+            ResetChunkTracking(true);
+            m_compactedBlocks.clear();
+            m_compactedBlocks.shrink_to_fit();
+
+            if (ExternalBlockLayer) {
+                ClearBlocks();
+                return;
+            }
+
+            BlockTypes.resize(newMapSize);
+
+            if (StoreMetadata)
+                BlockMetadata.resize(newMapSize);
+            else
+                BlockMetadata.clear();
+
+            if (StoreLastPlayer)
+                BlockLastPlayer.resize(newMapSize);
+            else
+                BlockLastPlayer.clear();
+        }
+
+        void D3Map::SetBlocks(const std::vector<unsigned char>& types) {
+            BlockTypes.assign(types.begin(), types.end());
+            BlockTypes.resize(MapSize.X * MapSize.Y * MapSize.Z);
+            std::fill(BlockMetadata.begin(), BlockMetadata.end(), 0);
+            std::fill(BlockLastPlayer.begin(), BlockLastPlayer.end(), 0);
+            dataChanged = true;
+            ResetChunkTracking(true);
+        }
+
+        void D3Map::ClearBlocks() {
+            BlockTypes.clear();
+            BlockTypes.shrink_to_fit();
+            BlockMetadata.clear();
+            BlockMetadata.shrink_to_fit();
+            BlockLastPlayer.clear();
+            BlockLastPlayer.shrink_to_fit();
+            m_compactedBlocks.clear();
+            m_compactedBlocks.shrink_to_fit();
+            ResetChunkTracking(false);
+        }
+
+        int64_t D3Map::CompactBlocks() {
+            int mapVolume = MapSize.X * MapSize.Y * MapSize.Z;
+
+            if (ExternalBlockLayer || static_cast<int>(BlockTypes.size()) != mapVolume)
+                return -1;
+
+            z_stream strm;
+            strm.zalloc = Z_NULL;
+            strm.zfree = Z_NULL;
+            strm.opaque = Z_NULL;
+
+            if (deflateInit(&strm, Z_BEST_SPEED) != Z_OK)
+                return -1;
+
+            // -- The planes go into one stream back to back; their lengths follow from MapSize and the Store flags.
+            std::vector<unsigned char> compacted(deflateBound(&strm, mapVolume * 4));
+            strm.next_out = compacted.data();
+            strm.avail_out = static_cast<uInt>(compacted.size());
+
+            auto feed = [&strm](const void* data, size_t length, int flush) {
+                strm.next_in = reinterpret_cast<Bytef*>(const_cast<void*>(data));
+                strm.avail_in = static_cast<uInt>(length);
+                int result = deflate(&strm, flush);
+                return (flush == Z_FINISH) ? result == Z_STREAM_END : (result == Z_OK || result == Z_BUF_ERROR);
+            };
+
+            bool result = feed(BlockTypes.data(), BlockTypes.size(), Z_NO_FLUSH) &&
+                          feed(BlockMetadata.data(), BlockMetadata.size(), Z_NO_FLUSH) &&
+                          feed(BlockLastPlayer.data(), BlockLastPlayer.size() * sizeof(short), Z_FINISH);
+            compacted.resize(strm.total_out);
+            deflateEnd(&strm);
+
+            if (!result)
+                return -1;
+
+            compacted.shrink_to_fit();
+            BlockTypes.clear();
+            BlockTypes.shrink_to_fit();
+            BlockMetadata.clear();
+            BlockMetadata.shrink_to_fit();
+            BlockLastPlayer.clear();
+            BlockLastPlayer.shrink_to_fit();
+            m_compactedBlocks = std::move(compacted);
+            return static_cast<int64_t>(m_compactedBlocks.size());
+        }
+
+        bool D3Map::ExpandBlocks() {
+            if (m_compactedBlocks.empty())
+                return false;
+
+            int mapVolume = MapSize.X * MapSize.Y * MapSize.Z;
+            BlockTypes.resize(mapVolume);
+            BlockMetadata.resize(StoreMetadata ? mapVolume : 0);
+            BlockLastPlayer.resize(StoreLastPlayer ? mapVolume : 0);
+
+            z_stream strm;
+            strm.zalloc = Z_NULL;
+            strm.zfree = Z_NULL;
+            strm.opaque = Z_NULL;
+            strm.next_in = m_compactedBlocks.data();
+            strm.avail_in = static_cast<uInt>(m_compactedBlocks.size());
+
+            if (inflateInit(&strm) != Z_OK)
+                return false;
+
+            auto drain = [&strm](void* data, size_t length) {
+                strm.next_out = reinterpret_cast<Bytef*>(data);
+                strm.avail_out = static_cast<uInt>(length);
+                int result = Z_OK;
+                while (strm.avail_out > 0 && result == Z_OK)
+                    result = inflate(&strm, Z_NO_FLUSH);
+                return strm.avail_out == 0 && (result == Z_OK || result == Z_STREAM_END);
+            };
+
+            bool result = drain(BlockTypes.data(), BlockTypes.size()) &&
+                          drain(BlockMetadata.data(), BlockMetadata.size()) &&
+                          drain(BlockLastPlayer.data(), BlockLastPlayer.size() * sizeof(short));
+            inflateEnd(&strm);
+
+            if (!result) {
+                Logger::LogAdd("D3Map", "Could not expand compacted blocks [" + mapPath + "]", LogType::L_ERROR, GLF);
+                return false;
+            }
+
+            m_compactedBlocks.clear();
+            m_compactedBlocks.shrink_to_fit();
+            return true;
+        }
+
+        void D3Map::ConvertBlockLayer(bool chunked) {
+            ChunkedFormat = chunked;
+            ResetChunkTracking(true);
+            dataChanged = true;
+        }
+
+        void D3Map::MarkChunkDirty(int index) {
+            int chunk = index / D3_MAP_CHUNK_BLOCKS;
+
+            if (chunk >= 0 && chunk < static_cast<int>(m_chunkDirty.size()))
+                std::atomic_ref<unsigned char>(m_chunkDirty[chunk]).store(1, std::memory_order_release);
+        }
+
+        void D3Map::ResetChunkTracking(bool dirty) {
+            int mapVolume = MapSize.X * MapSize.Y * MapSize.Z;
+            m_chunkDirty.assign((mapVolume + D3_MAP_CHUNK_BLOCKS - 1) / D3_MAP_CHUNK_BLOCKS, dirty ? 1 : 0);
+            m_chunkFileCurrent = false;
         }
 
         unsigned char D3Map::GetBlock(Common::Vector3S blockLocation) {
             if (!BlockInBounds(blockLocation))
                 return 0;
 
-            int index = GetBlockIndex(blockLocation);
-            return MapData[(index*4)];
+            return BlockTypes[GetBlockIndex(blockLocation)];
         }
 
         unsigned char D3Map::GetBlockMetadata(Common::Vector3S blockLocation) {
-            if (!BlockInBounds(blockLocation))
+            if (!BlockInBounds(blockLocation) || BlockMetadata.empty())
                 return 0;
 
-            int index = GetBlockIndex(blockLocation);
-            return MapData[(index*4)+1];
+            return BlockMetadata[GetBlockIndex(blockLocation)];
         }
 
         short D3Map::GetBlockLastPlayer(Common::Vector3S blockLocation) {
-            if (!BlockInBounds(blockLocation))
+            if (!BlockInBounds(blockLocation) || BlockLastPlayer.empty())
                 return -1;
-            int index = GetBlockIndex(blockLocation);
-            short result = 0;
-            result |= MapData[(index*4)+2] << 8;
-            result |= MapData[(index*4)+3];
 
-            return result;
+            return BlockLastPlayer[GetBlockIndex(blockLocation)];
         }
 
         void D3Map::SetBlock(Common::Vector3S blockLocation, unsigned char type) {
@@ -179,28 +332,38 @@ namespace D3PP::files {
                 return;
 
             int index = GetBlockIndex(blockLocation);
-            MapData[(index*4)] = type;
+            std::scoped_lock<std::mutex> sLock(m_snapshotLock);
+            if (m_snapshotActive)
+                PreserveChunk(index / D3_MAP_CHUNK_BLOCKS);
+            BlockTypes[index] = type;
+            MarkChunkDirty(index);
             dataChanged = true;
         }
 
         void D3Map::SetBlockMetadata(Common::Vector3S blockLocation, unsigned char metadata) {
-            if (!BlockInBounds(blockLocation))
+            if (!BlockInBounds(blockLocation) || BlockMetadata.empty())
                 return;
 
             int index = GetBlockIndex(blockLocation);
-            MapData[(index*4)+1] = metadata;
+            std::scoped_lock<std::mutex> sLock(m_snapshotLock);
+            if (m_snapshotActive)
+                PreserveChunk(index / D3_MAP_CHUNK_BLOCKS);
+            BlockMetadata[index] = metadata;
+            MarkChunkDirty(index);
             dataChanged = true;
         }
 
         void D3Map::SetBlockLastPlayer(Common::Vector3S blockLocation, short playerNumber) {
-            if (!BlockInBounds(blockLocation))
+            if (!BlockInBounds(blockLocation) || BlockLastPlayer.empty())
                 return;
 
             int index = GetBlockIndex(blockLocation);
-            MapData[(index*4)+2] = (playerNumber & 0xFF00) >> 8;
-            MapData[(index*4)+3] = (playerNumber&0xFF);
+            std::scoped_lock<std::mutex> sLock(m_snapshotLock);
+            if (m_snapshotActive)
+                PreserveChunk(index / D3_MAP_CHUNK_BLOCKS);
+            BlockLastPlayer[index] = playerNumber;
+            MarkChunkDirty(index);
             dataChanged = true;
-
         }
 
         std::string D3Map::GenerateUuid() {
@@ -269,6 +432,8 @@ namespace D3PP::files {
                 oStream << "weatherFade = " << weatherFade << "\n";
                 oStream << "expoFog = " << expoFog << "\n";
                 oStream << "mapSideOffset = " << mapSideOffset << "\n";
+                oStream << "Store_Metadata = " << StoreMetadata << "\n";
+                oStream << "Store_Last_Player = " << StoreLastPlayer << "\n";
 
                 oStream.close();
                 Logger::LogAdd("D3Map", "File saved [" + mapPath + D3_MAP_CONFIG_NAME + "]", LogType::NORMAL, GLF);
@@ -326,26 +491,207 @@ namespace D3PP::files {
             return true;
         }
 
+        void D3Map::BeginSnapshot() {
+            std::scoped_lock<std::mutex> sLock(m_snapshotLock);
+            int mapVolume = MapSize.X * MapSize.Y * MapSize.Z;
+            int chunkCount = (mapVolume + D3_MAP_CHUNK_BLOCKS - 1) / D3_MAP_CHUNK_BLOCKS;
+
+            if (static_cast<int>(m_chunkEpochs.size()) != chunkCount)
+                m_chunkEpochs.assign(chunkCount, m_snapshotEpoch);
+
+            m_snapshotEpoch++;
+            m_snapshotChunks.clear();
+            // -- Cleared here rather than after writing, so changes made during the save mark the map dirty again.
+            dataChanged = false;
+            m_snapshotActive = true;
+        }
+
+        void D3Map::EndSnapshot() {
+            std::scoped_lock<std::mutex> sLock(m_snapshotLock);
+            m_snapshotActive = false;
+            m_snapshotChunks.clear();
+        }
+
+        void D3Map::PreserveChunk(int chunk) {
+            if (m_chunkEpochs[chunk] == m_snapshotEpoch)
+                return;
+
+            CopyChunk(chunk, m_snapshotChunks[chunk]);
+            m_chunkEpochs[chunk] = m_snapshotEpoch;
+        }
+
+        void D3Map::CopyChunk(int chunk, SnapshotChunk& target) {
+            int mapVolume = MapSize.X * MapSize.Y * MapSize.Z;
+            int start = chunk * D3_MAP_CHUNK_BLOCKS;
+            int end = std::min(start + D3_MAP_CHUNK_BLOCKS, mapVolume);
+
+            target.Types.assign(BlockTypes.begin() + start, BlockTypes.begin() + end);
+            if (!BlockMetadata.empty())
+                target.Metadata.assign(BlockMetadata.begin() + start, BlockMetadata.begin() + end);
+            else
+                target.Metadata.clear();
+
+            if (!BlockLastPlayer.empty())
+                target.LastPlayer.assign(BlockLastPlayer.begin() + start, BlockLastPlayer.begin() + end);
+            else
+                target.LastPlayer.clear();
+        }
+
+        bool D3Map::TakeSnapshotChunk(int chunk, SnapshotChunk& target) {
+            std::scoped_lock<std::mutex> sLock(m_snapshotLock);
+            auto preserved = m_snapshotChunks.find(chunk);
+
+            if (preserved != m_snapshotChunks.end()) {
+                target = std::move(preserved->second);
+                m_snapshotChunks.erase(preserved);
+                return true;
+            }
+
+            CopyChunk(chunk, target);
+            m_chunkEpochs[chunk] = m_snapshotEpoch;
+            return false;
+        }
+
         bool D3Map::SaveMapData() {
+            if (ChunkedFormat)
+                return SaveChunkedData();
+
             if (!dataChanged)
                 return true;
-            int mapDataSize = MapSize.X * MapSize.Y * MapSize.Z * 4;
+            int mapVolume = MapSize.X * MapSize.Y * MapSize.Z;
 
-            if (!GZIP::GZip_CompressToFile(MapData.data(), mapDataSize, "temp.gz"))
+            if (static_cast<int>(BlockTypes.size()) != mapVolume)
                 return false;
 
-            try {
-                if (std::filesystem::exists(mapPath + D3_MAP_BLOCKS_NAME))
-                    std::filesystem::remove(mapPath + D3_MAP_BLOCKS_NAME);
+            int blockIndex = 0;
+            int currentChunk = -1;
+            SnapshotChunk chunkData;
+            std::string tempFile = mapPath + D3_MAP_BLOCKS_NAME + ".tmp";
+
+            // -- The on-disk layer keeps the interleaved D3 layout (type, metadata, last player hi, lo),
+            // -- so the snapshot is re-interleaved chunk by chunk while compressing.
+            auto interleave = [&](unsigned char* buffer, int maxLen) {
+                int written = 0;
+                while (written + 4 <= maxLen && blockIndex < mapVolume) {
+                    if (blockIndex / D3_MAP_CHUNK_BLOCKS != currentChunk) {
+                        currentChunk = blockIndex / D3_MAP_CHUNK_BLOCKS;
+                        TakeSnapshotChunk(currentChunk, chunkData);
+                    }
+                    int local = blockIndex - currentChunk * D3_MAP_CHUNK_BLOCKS;
+                    short lastPlayer = chunkData.LastPlayer.empty() ? 0 : chunkData.LastPlayer[local];
+                    buffer[written++] = chunkData.Types[local];
+                    buffer[written++] = chunkData.Metadata.empty() ? 0 : chunkData.Metadata[local];
+                    buffer[written++] = static_cast<unsigned char>((lastPlayer & 0xFF00) >> 8);
+                    buffer[written++] = static_cast<unsigned char>(lastPlayer & 0xFF);
+                    blockIndex++;
+                }
+                return written;
+            };
+
+            BeginSnapshot();
+            bool compressed = GZIP::GZip_CompressToFileParallel(static_cast<int64_t>(mapVolume) * 4, interleave, tempFile);
+            EndSnapshot();
 
-                std::filesystem::copy("temp.gz", mapPath + D3_MAP_BLOCKS_NAME, std::filesystem::copy_options::overwrite_existing);
+            if (!compressed) {
+                dataChanged = true;
+                return false;
+            }
+
+            try {
+                std::filesystem::rename(tempFile, mapPath + D3_MAP_BLOCKS_NAME);
+                std::filesystem::remove(mapPath + D3_MAP_CHUNKED_BLOCKS_NAME);
             } catch (std::filesystem::filesystem_error& e) {
-                Logger::LogAdd("D3Map", "Could not copy mapfile: " + stringulate(e.what()), LogType::L_ERROR, GLF);
+                Logger::LogAdd("D3Map", "Could not replace mapfile: " + stringulate(e.what()), LogType::L_ERROR, GLF);
+                dataChanged = true;
                 return false;
             }
 
             Logger::LogAdd("D3Map", "File saved [" + mapPath + D3_MAP_BLOCKS_NAME + "]", LogType::NORMAL, GLF);
-            dataChanged = false;
+            return true;
+        }
+
+        bool D3Map::SaveChunkedData() {
+            if (!dataChanged)
+                return true;
+            int mapVolume = MapSize.X * MapSize.Y * MapSize.Z;
+            int chunkCount = (mapVolume + D3_MAP_CHUNK_BLOCKS - 1) / D3_MAP_CHUNK_BLOCKS;
+
+            if (static_cast<int>(BlockTypes.size()) != mapVolume)
+                return false;
+
+            if (static_cast<int>(m_chunkDirty.size()) != chunkCount)
+                ResetChunkTracking(true);
+
+            std::string fileName = mapPath + D3_MAP_CHUNKED_BLOCKS_NAME;
+            std::string targetName = fileName;
+            auto chunkFile = std::make_unique<ChunkedBlockFile>(fileName);
+            // -- While the file on disk matches the map, only changed chunks are appended. Once half of it is
+            // -- superseded chunk versions (or it belongs to another map size or folder), it is rebuilt from scratch.
+            bool incremental = m_chunkFileCurrent && m_chunkFileName == fileName && chunkFile->Open() &&
+                               chunkFile->GetSize().isEqual(MapSize) && chunkFile->ChunkBlocks() == D3_MAP_CHUNK_BLOCKS &&
+                               chunkFile->DeadBytes() * 2 < chunkFile->FileSize();
+
+            if (!incremental) {
+                targetName = fileName + ".tmp";
+                chunkFile = std::make_unique<ChunkedBlockFile>(targetName);
+                if (!chunkFile->Create(MapSize, D3_MAP_CHUNK_BLOCKS))
+                    return false;
+            }
+
+            SnapshotChunk chunkData;
+            std::vector<unsigned char> interleaved;
+            int written = 0;
+            bool result = true;
+
+            BeginSnapshot();
+            for (int chunk = 0; chunk < chunkCount && result; chunk++) {
+                auto dirtyFlag = std::atomic_ref<unsigned char>(m_chunkDirty[chunk]);
+                if (dirtyFlag.exchange(0, std::memory_order_acq_rel) == 0 && incremental)
+                    continue;
+
+                // -- A chunk that was copied aside was changed during this save; the newer data goes out next time.
+                if (TakeSnapshotChunk(chunk, chunkData))
+                    dirtyFlag.store(1, std::memory_order_release);
+
+                int blocks = static_cast<int>(chunkData.Types.size());
+                interleaved.resize(blocks * 4);
+                for (int i = 0; i < blocks; i++) {
+                    short lastPlayer = chunkData.LastPlayer.empty() ? 0 : chunkData.LastPlayer[i];
+                    interleaved[i * 4] = chunkData.Types[i];
+                    interleaved[i * 4 + 1] = chunkData.Metadata.empty() ? 0 : chunkData.Metadata[i];
+                    interleaved[i * 4 + 2] = static_cast<unsigned char>((lastPlayer & 0xFF00) >> 8);
+                    interleaved[i * 4 + 3] = static_cast<unsigned char>(lastPlayer & 0xFF);
+                }
+
+                result = chunkFile->WriteChunk(chunk, interleaved.data(), static_cast<int>(interleaved.size()));
+                written++;
+            }
+            EndSnapshot();
+
+            if (result)
+                result = chunkFile->Commit();
+            chunkFile->Close();
+
+            if (result && !incremental) {
+                try {
+                    std::filesystem::rename(targetName, fileName);
+                    std::filesystem::remove(mapPath + D3_MAP_BLOCKS_NAME);
+                } catch (std::filesystem::filesystem_error& e) {
+                    Logger::LogAdd("D3Map", "Could not replace mapfile: " + stringulate(e.what()), LogType::L_ERROR, GLF);
+                    result = false;
+                }
+            }
+
+            if (!result) {
+                Logger::LogAdd("D3Map", "Error saving map [" + fileName + "]!", L_ERROR, GLF);
+                ResetChunkTracking(true);
+                dataChanged = true;
+                return false;
+            }
+
+            m_chunkFileCurrent = true;
+            m_chunkFileName = fileName;
+            Logger::LogAdd("D3Map", "File saved [" + fileName + "] (" + stringulate(written) + "/" + stringulate(chunkCount) + " chunks written)", LogType::NORMAL, GLF);
             return true;
         }
 
@@ -361,6 +707,9 @@ namespace D3PP::files {
             if (mapSize == 0)
                 return false;
 
+            StoreMetadata = (pLoader.Read("Store_Metadata", 1) > 0);
+            StoreLastPlayer = (pLoader.Read("Store_Last_Player", 1) > 0);
+
             Common::Vector3S newSize {
                 static_cast<short>(sizeX),
                 static_cast<short>(sizeY),
@@ -448,10 +797,41 @@ namespace D3PP::files {
         }
 
         bool D3Map::ReadMapData() {
+            if (std::filesystem::exists(mapPath + D3_MAP_CHUNKED_BLOCKS_NAME))
+                return ReadChunkedData();
+
             int mapSize = MapSize.X* MapSize.Y*MapSize.Z;
-            int dSize = GZIP::GZip_DecompressFromFile(reinterpret_cast<unsigned char*>(MapData.data()), mapSize * 4, mapPath + D3_MAP_BLOCKS_NAME);
+            int expectedSize = mapSize * 4;
+            int offset = 0;
+
+            // -- Split the interleaved on-disk layer into the type, metadata and last-player planes.
+            auto deinterleave = [&](const unsigned char* data, int len) {
+                for (int i = 0; i < len && offset < expectedSize; i++, offset++) {
+                    int blockIndex = offset / 4;
+                    switch (offset % 4) {
+                        case 0:
+                            BlockTypes[blockIndex] = data[i];
+                            break;
+                        case 1:
+                            if (!BlockMetadata.empty())
+                                BlockMetadata[blockIndex] = data[i];
+                            break;
+                        case 2:
+                            if (!BlockLastPlayer.empty())
+                                BlockLastPlayer[blockIndex] = static_cast<short>(data[i] << 8);
+                            break;
+                        case 3:
+                            if (!BlockLastPlayer.empty())
+                                BlockLastPlayer[blockIndex] |= data[i];
+                            break;
+                    }
+                }
+            };
 
-            if (dSize == (mapSize * 4)) {
+            int64_t dSize = GZIP::GZip_DecompressFromFileStreamed(deinterleave, mapPath + D3_MAP_BLOCKS_NAME);
+
+            if (dSize >= expectedSize) {
+                dataChanged = false;
                 Logger::LogAdd("D3Map", "Map Loaded [" + mapPath + D3_MAP_BLOCKS_NAME + "] (" + stringulate(MapSize.X) + "x" + stringulate(MapSize.Y) + "x" + stringulate(MapSize.Z) + ")", LogType::NORMAL, GLF);
                 return true;
             }
@@ -461,6 +841,46 @@ namespace D3PP::files {
             
         }
 
+        bool D3Map::ReadChunkedData() {
+            std::string fileName = mapPath + D3_MAP_CHUNKED_BLOCKS_NAME;
+            ChunkedBlockFile chunkFile(fileName);
+
+            if (!chunkFile.Open() || !chunkFile.GetSize().isEqual(MapSize)) {
+                Logger::LogAdd("D3Map", "Error loading map [" + fileName + "]!", L_ERROR, GLF);
+                return false;
+            }
+
+            std::vector<std::vector<unsigned char>> chunks;
+            for (int first = 0; first < chunkFile.ChunkCount(); first += D3_MAP_CHUNKED_READ_BATCH) {
+                int count = std::min(D3_MAP_CHUNKED_READ_BATCH, chunkFile.ChunkCount() - first);
+                if (!chunkFile.ReadChunks(first, count, chunks)) {
+                    Logger::LogAdd("D3Map", "Error loading map [" + fileName + "]!", L_ERROR, GLF);
+                    return false;
+                }
+
+                for (int chunk = first; chunk < first + count; chunk++) {
+                    const std::vector<unsigned char>& data = chunks[chunk - first];
+                    int start = chunk * chunkFile.ChunkBlocks();
+                    int blocks = static_cast<int>(data.size() / 4);
+                    for (int i = 0; i < blocks; i++) {
+                        BlockTypes[start + i] = data[i * 4];
+                        if (!BlockMetadata.empty())
+                            BlockMetadata[start + i] = data[i * 4 + 1];
+                        if (!BlockLastPlayer.empty())
+                            BlockLastPlayer[start + i] = static_cast<short>((data[i * 4 + 2] << 8) | data[i * 4 + 3]);
+                    }
+                }
+            }
+
+            ChunkedFormat = true;
+            ResetChunkTracking(false);
+            m_chunkFileCurrent = (chunkFile.ChunkBlocks() == D3_MAP_CHUNK_BLOCKS);
+            m_chunkFileName = fileName;
+            dataChanged = false;
+            Logger::LogAdd("D3Map", "Map Loaded [" + fileName + "] (" + stringulate(MapSize.X) + "x" + stringulate(MapSize.Y) + "x" + stringulate(MapSize.Z) + ")", LogType::NORMAL, GLF);
+            return true;
+        }
+
         void D3Map::ReadPortals() {
             PreferenceLoader tpLoader(D3_MAP_PORTALS_NAME, mapPath);
             tpLoader.LoadFile();
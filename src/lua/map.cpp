@@ -862,7 +862,11 @@ int LuaMapLib::LuaMapBlockGetType(lua_State* L) {
         result = map->GetBlockType(X, Y, Z);
     }
 
-    lua_pushinteger(L, result);
+    // -- nil while the map is still loading, so scripts never take it for a block id.
+    if (result == MAP_BLOCK_NOT_LOADED && map != nullptr)
+        lua_pushnil(L);
+    else
+        lua_pushinteger(L, result);
     return 1;
 }
 
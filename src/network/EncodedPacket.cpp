@@ -0,0 +1,16 @@
+#include "network/EncodedPacket.h"
+
+#include "common/ByteBuffer.h"
+#include "network/IPacket.h"
+
+namespace D3PP::network {
+    SharedPacket EncodedPacket::Encode(IPacket& packet) {
+        auto buffer = std::make_shared<ByteBuffer>(nullptr);
+        packet.Write(buffer);
+        return FromBytes(buffer->GetAllBytes());
+    }
+
+    SharedPacket EncodedPacket::FromBytes(std::vector<unsigned char> data) {
+        return std::make_shared<const EncodedPacket>(std::move(data));
+    }
+}
@@ -7,36 +7,45 @@
 
 #ifdef __linux__
 #include "common/Logger.h"
+#include "common/Configuration.h"
 #include "Utils.h"
 #include <errno.h>
+#include <fcntl.h>
 #include <memory>
+#include <sys/eventfd.h>
+#include <netinet/tcp.h>
 #include "arpa/inet.h"
 #include "network/LinuxSockets.h"
 
 const std::string MODULE_NAME = "ServerSocket";
 
-ServerSocket::ServerSocket() : server(), address(), readfds(), clientSockets() {
+ServerSocket::ServerSocket() : server(), address() {
     hasInit = false;
     listenPort = 25565;
     listenSocket = -1;
+    epollSocket = -1;
     eventSocket = -1;
-
-    for (auto i = 0; i < MAXIMUM_CONNECTIONS; i++) {
-        clientSockets[i] = 0;
-    }
+    CreatePoller();
 }
 
-ServerSocket::ServerSocket(int port) : server(), address(), readfds(), clientSockets() {
+ServerSocket::ServerSocket(int port) : server(), address() {
     hasInit = false;
     listenPort = 25565;
     listenSocket = -1;
+    epollSocket = -1;
     eventSocket = -1;
-    for (auto i = 0; i < MAXIMUM_CONNECTIONS; i++) {
-        clientSockets[i] = 0;
-    }
     Init(port);
 }
 
+ServerSocket::~ServerSocket() {
+    Stop();
+
+    if (eventSocket != -1)
+        close(eventSocket);
+    if (epollSocket != -1)
+        close(epollSocket);
+}
+
 void ServerSocket::Listen() {
     if (!hasInit) {
         Logger::LogAdd(MODULE_NAME, "SOCKETS NOT INITIALIZED YET!!!", LogType::L_ERROR, __FILE__, __LINE__, __FUNCTION__);
@@ -50,14 +59,17 @@ void ServerSocket::Listen() {
         return;
     }
 
-    iResult = listen(listenSocket, 5);
+    int backlog = Configuration::NetSettings.ListenBacklog > 0 ? Configuration::NetSettings.ListenBacklog : SOCKET_DEFAULT_BACKLOG;
+    iResult = listen(listenSocket, backlog);
 
     if (iResult < 0) {
         Logger::LogAdd(MODULE_NAME, "Failed to start listening", LogType::L_ERROR, __FILE__, __LINE__, __FUNCTION__);
         close(listenSocket);
+        listenSocket = -1;
         return;
     }
 
+    Watch(listenSocket, EPOLLIN | EPOLLET);
     // -- Now we're ready to accept clients <3
 }
 
@@ -67,95 +79,143 @@ void ServerSocket::Init(int port) {
 
     listenPort = port;
 
-    listenSocket = socket(AF_INET, SOCK_STREAM, 0);
+    listenSocket = socket(AF_INET, SOCK_STREAM | SOCK_NONBLOCK, 0);
     if (listenSocket < 0) {
         Logger::LogAdd(MODULE_NAME, "Failed to initialize sockets[3]", LogType::L_ERROR, __FILE__, __LINE__, __FUNCTION__);
         return;
     }
+
+    if (!CreatePoller())
+        return;
+
     server.sin_family = AF_INET;
     server.sin_addr.s_addr = INADDR_ANY;
     server.sin_port = htons(port);
     int enable = 1;
-    setsockopt(listenSocket, SOL_SOCKET, SO_REUSEADDR, &enable, sizeof(int) < 0);
+    setsockopt(listenSocket, SOL_SOCKET, SO_REUSEADDR, &enable, sizeof(int));
     hasInit = true;
 }
 
+bool ServerSocket::CreatePoller() {
+    if (epollSocket != -1)
+        return true;
+
+    epollSocket = epoll_create1(EPOLL_CLOEXEC);
+    eventSocket = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    if (epollSocket < 0 || eventSocket < 0) {
+        Logger::LogAdd(MODULE_NAME, "Failed to create epoll instance -- " + stringulate(errno), LogType::L_ERROR, __FILE__, __LINE__, __FUNCTION__);
+        return false;
+    }
+
+    Watch(eventSocket, EPOLLIN | EPOLLET);
+    return true;
+}
+
 void ServerSocket::Stop() {
+    if (listenSocket == -1)
+        return;
 
+    epoll_ctl(epollSocket, EPOLL_CTL_DEL, listenSocket, nullptr);
+    close(listenSocket);
+    listenSocket = -1;
+    Wake();
 }
 
 std::unique_ptr<Sockets> ServerSocket::Accept() {
     int newSocket;
-    int addrlen = sizeof(struct sockaddr_in);
-    newSocket = accept(listenSocket, (struct sockaddr*)&address, (socklen_t *) &addrlen);
+    socklen_t addrlen = sizeof(struct sockaddr_in);
+    newSocket = accept4(listenSocket, (struct sockaddr*)&address, &addrlen, SOCK_NONBLOCK | SOCK_CLOEXEC);
 
-    for (auto i = 0; i < MAXIMUM_CONNECTIONS; i++) {
-        if (clientSockets[i] == 0) {
-            clientSockets[i] = newSocket;
-            break;
-        }
+    if (newSocket == -1) {
+        if (errno != EAGAIN && errno != EWOULDBLOCK && errno != EINTR)
+            Logger::LogAdd(MODULE_NAME, "Failed to accept client -- " + stringulate(errno), LogType::WARNING, __FILE__, __LINE__, __FUNCTION__);
+
+        return nullptr;
     }
 
+    ConfigureClient(newSocket);
+
     return std::make_unique<Sockets>(newSocket, inet_ntoa(address.sin_addr));
 }
 
-std::map<ServerSocketEvent, std::vector<int>> ServerSocket::CheckEvents() {
-    if (!hasInit)
-        return std::map<ServerSocketEvent, std::vector<int>> { std::make_pair(SOCKET_EVENT_NONE, std::vector<int>())};
-    if (listenSocket == -1) {
-        return std::map<ServerSocketEvent, std::vector<int>> { std::make_pair(SOCKET_EVENT_NONE, std::vector<int>())};
-    }
+std::map<ServerSocketEvent, std::vector<int>> ServerSocket::CheckEvents(int timeoutMs) {
+    std::map<ServerSocketEvent, std::vector<int>> result;
 
-    FD_ZERO(&readfds);
-    FD_SET(listenSocket, &readfds);
-    int maxFd = listenSocket;
+    if (epollSocket == -1)
+        return result;
 
-    for (auto i = 0; i < MAXIMUM_CONNECTIONS; i++) {
-        if (clientSockets[i] > 0) {
-            if (clientSockets[i] > maxFd)
-                maxFd = clientSockets[i];
-            FD_SET(clientSockets[i], &readfds);
-        }
-    }
-    struct timeval time = {0, 5};
-    int activity = select(maxFd+1, &readfds, NULL, NULL, &time);
+    struct epoll_event events[SOCKET_MAX_EVENTS];
+    int activity = epoll_wait(epollSocket, events, SOCKET_MAX_EVENTS, timeoutMs);
 
     if (activity == -1) {
-        Logger::LogAdd("ServerSocket", "Some error occured calling select.", LogType::L_ERROR, __FILE__, __LINE__, __FUNCTION__);
-        return std::map<ServerSocketEvent, std::vector<int>> { std::make_pair(SOCKET_EVENT_NONE, std::vector<int>())};
-    }
+        if (errno != EINTR)
+            Logger::LogAdd(MODULE_NAME, "Some error occured calling epoll_wait.", LogType::L_ERROR, __FILE__, __LINE__, __FUNCTION__);
 
-    if (FD_ISSET(listenSocket, &readfds)) {
-        // -- Incoming connection
-        return std::map<ServerSocketEvent, std::vector<int>> { std::make_pair(SOCKET_EVENT_CONNECT, std::vector<int>())};
+        return result;
     }
-    std::vector<int> resultSockets;
-    bool hasData = false;
-    for (auto i = 0; i < MAXIMUM_CONNECTIONS; i++) {
-        int s = clientSockets[i];
-        if (FD_ISSET(s, &readfds)) {
-            hasData = true;
-            resultSockets.push_back(s);
+
+    for (int i = 0; i < activity; i++) {
+        int fd = events[i].data.fd;
+        unsigned int flags = events[i].events;
+
+        if (fd == eventSocket) {
+            eventfd_t value;
+            eventfd_read(eventSocket, &value);
+            continue;
+        }
+
+        if (fd == listenSocket) {
+            result[SOCKET_EVENT_CONNECT].push_back(fd);
+            continue;
         }
-    }
 
-    if (hasData) {
-        return std::map<ServerSocketEvent, std::vector<int>> { std::make_pair(SOCKET_EVENT_DATA, resultSockets) };
+        // -- Hangups are reported as readable too, the read that follows sees the EOF and drops the client.
+        if (flags & (EPOLLIN | EPOLLRDHUP | EPOLLHUP | EPOLLERR))
+            result[SOCKET_EVENT_DATA].push_back(fd);
+        if (flags & EPOLLOUT)
+            result[SOCKET_EVENT_WRITABLE].push_back(fd);
     }
 
-    return std::map<ServerSocketEvent, std::vector<int>> { std::make_pair(SOCKET_EVENT_NONE, std::vector<int>())};
+    return result;
+}
+
+void ServerSocket::Adopt(int fd) const {
+    Watch(fd, EPOLLIN | EPOLLOUT | EPOLLRDHUP | EPOLLET);
 }
 
 void ServerSocket::Unaccept(int fd) {
-    for (auto i = 0; i < MAXIMUM_CONNECTIONS; i++) {
-        if (clientSockets[i] == fd) {
-            clientSockets[i] = 0;
-        }
-    }
+    if (epollSocket != -1)
+        epoll_ctl(epollSocket, EPOLL_CTL_DEL, fd, nullptr);
 }
 
 int ServerSocket::GetEventSocket() const {
     return eventSocket;
 }
 
-#endif
\ No newline at end of file
+void ServerSocket::Wake() const {
+    if (eventSocket != -1)
+        eventfd_write(eventSocket, 1);
+}
+
+void ServerSocket::Watch(int fd, unsigned int events) const {
+    struct epoll_event ev {};
+    ev.events = events;
+    ev.data.fd = fd;
+
+    if (epoll_ctl(epollSocket, EPOLL_CTL_ADD, fd, &ev) == -1)
+        Logger::LogAdd(MODULE_NAME, "Failed to watch socket -- " + stringulate(errno), LogType::L_ERROR, __FILE__, __LINE__, __FUNCTION__);
+}
+
+void ServerSocket::ConfigureClient(int fd) const {
+    int enable = 1;
+    setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &enable, sizeof(int));
+
+    int sendBuffer = Configuration::NetSettings.SocketSendBuffer;
+    int receiveBuffer = Configuration::NetSettings.SocketReceiveBuffer;
+    if (sendBuffer > 0)
+        setsockopt(fd, SOL_SOCKET, SO_SNDBUF, &sendBuffer, sizeof(int));
+    if (receiveBuffer > 0)
+        setsockopt(fd, SOL_SOCKET, SO_RCVBUF, &receiveBuffer, sizeof(int));
+}
+
+#endif
@@ -7,6 +7,8 @@
 #include <cerrno>
 #include <iostream>
 #include <cstring>      // Needed for memset
+#include <sys/uio.h>
+#include <linux/errqueue.h>
 
 Sockets::Sockets(const std::string& address, const std::string& port) : host_info(), host_info_list()
 {
@@ -55,6 +57,9 @@ int Sockets::Read(char* buffer, int size) {
 
     bytesRead = recv(socketfd, buffer, (size_t)size, 0);
 
+    if (bytesRead == -1 && (errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR))
+        return SOCKET_WOULD_BLOCK;
+
     if (bytesRead == -1)
         connected = false;
 
@@ -63,7 +68,39 @@ int Sockets::Read(char* buffer, int size) {
 
 int Sockets::Send(char* data, int size) {
     ssize_t bytesSent;
-    bytesSent = send(socketfd, data, (size_t)size, 0);
+    bytesSent = send(socketfd, data, (size_t)size, MSG_NOSIGNAL);
+
+    if (bytesSent == -1 && (errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR))
+        return SOCKET_WOULD_BLOCK;
+
+    if (bytesSent == -1)
+        connected = false;
+
+    return (int)bytesSent;
+}
+
+int Sockets::SendVectored(const std::span<const unsigned char>* slices, int count, bool zeroCopy) {
+    struct iovec iov[SOCKET_MAX_SLICES];
+    int used = count < SOCKET_MAX_SLICES ? count : SOCKET_MAX_SLICES;
+
+    for (int i = 0; i < used; i++) {
+        iov[i].iov_base = const_cast<unsigned char*>(slices[i].data());
+        iov[i].iov_len = slices[i].size();
+    }
+
+    struct msghdr message {};
+    message.msg_iov = iov;
+    message.msg_iovlen = used;
+
+    int flags = MSG_NOSIGNAL;
+#ifdef MSG_ZEROCOPY
+    if (zeroCopy)
+        flags |= MSG_ZEROCOPY;
+#endif
+    ssize_t bytesSent = sendmsg(socketfd, &message, flags);
+
+    if (bytesSent == -1 && (errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR || errno == ENOBUFS))
+        return SOCKET_WOULD_BLOCK;
 
     if (bytesSent == -1)
         connected = false;
@@ -71,6 +108,38 @@ int Sockets::Send(char* data, int size) {
     return (int)bytesSent;
 }
 
+bool Sockets::EnableZeroCopy() {
+#ifdef SO_ZEROCOPY
+    int enable = 1;
+    return setsockopt(socketfd, SOL_SOCKET, SO_ZEROCOPY, &enable, sizeof(int)) == 0;
+#else
+    return false;
+#endif
+}
+
+bool Sockets::ReapZeroCopy(unsigned int& first, unsigned int& last) {
+#ifdef SO_EE_ORIGIN_ZEROCOPY
+    char control[128];
+    struct msghdr message {};
+    message.msg_control = control;
+    message.msg_controllen = sizeof(control);
+
+    if (recvmsg(socketfd, &message, MSG_ERRQUEUE | MSG_DONTWAIT) == -1)
+        return false;
+
+    for (struct cmsghdr* cm = CMSG_FIRSTHDR(&message); cm != nullptr; cm = CMSG_NXTHDR(&message, cm)) {
+        auto* error = reinterpret_cast<struct sock_extended_err*>(CMSG_DATA(cm));
+        if (error->ee_errno != 0 || error->ee_origin != SO_EE_ORIGIN_ZEROCOPY)
+            continue;
+
+        first = error->ee_info;
+        last = error->ee_data;
+        return true;
+    }
+#endif
+    return false;
+}
+
 Sockets::~Sockets()
 {
     //dtor
@@ -6,6 +6,8 @@
 #include "Utils.h"
 #include <memory>
 #include <utility>
+#include <algorithm>
+#include <cerrno>
 #include <events/EventEntityAdd.h>
 #include "common/ByteBuffer.h"
 #include "common/Logger.h"
@@ -26,12 +28,16 @@
 #include "common/Player_List.h"
 #include "network/Server.h"
 #include "network/PacketHandlers.h"
+#include "network/PacketReader.h"
+#include "network/EncodedPacket.h"
+#include "common/Configuration.h"
 #include "Client.h"
 
 #ifndef __linux__
 #include "network/WindowsSockets.h"
 #else
 #include "network/LinuxSockets.h"
+#include "common/IoUring.h"
 #endif
 
 const std::string MODULE_NAME = "NetworkClient";
@@ -48,10 +54,21 @@ NetworkClient::NetworkClient(std::unique_ptr<Sockets> socket) : Selections(MAX_S
     SendBuffer = std::make_shared<ByteBuffer>([this]{this->DataReady();});
     ReceiveBuffer = std::make_shared<ByteBuffer>(nullptr);
     DataAvailable = false;
+    DataWaiting = false;
+    WriteBlocked = false;
+    InputBacklog = false;
+    Shard = -1;
+    SendOverflow = false;
+    BulkStarved = false;
+    LastSendProgress = time(nullptr);
+    ConnectedAt = std::chrono::steady_clock::now();
+    PacketBucket = D3PP::network::TokenBucket(Configuration::NetSettings.PacketRate, Configuration::NetSettings.PacketBurst, ConnectedAt);
     canReceive = true;
     canSend = true;
     LastTimeEvent = time(nullptr);
     clientSocket = std::move(socket);
+    ZeroCopy = Configuration::NetSettings.ZeroCopySend && clientSocket->EnableZeroCopy();
+    ZeroCopySequence = 0;
     PingTime = std::chrono::steady_clock::now() + std::chrono::seconds(5);
     DisconnectTime = 0;
     LoggedIn = false;
@@ -74,6 +91,17 @@ NetworkClient::NetworkClient() : Selections(MAX_SELECTION_BOXES) {
     CustomExtensions = 0;
     m_currentUndoIndex = 0;
     DataAvailable = false;
+    DataWaiting = false;
+    WriteBlocked = false;
+    InputBacklog = false;
+    Shard = -1;
+    SendOverflow = false;
+    BulkStarved = false;
+    LastSendProgress = time(nullptr);
+    ConnectedAt = std::chrono::steady_clock::now();
+    PacketBucket = D3PP::network::TokenBucket(Configuration::NetSettings.PacketRate, Configuration::NetSettings.PacketBurst, ConnectedAt);
+    ZeroCopy = false;
+    ZeroCopySequence = 0;
     canReceive = true;
     canSend = true;
     LastTimeEvent = time(nullptr);
@@ -102,6 +130,25 @@ void NetworkClient::MainFunc() {
         return;
     }
 
+    int handshakeTimeout = Configuration::NetSettings.HandshakeTimeout;
+    if (!LoggedIn && DisconnectTime == 0 && handshakeTimeout > 0 && ConnectedAt + std::chrono::seconds(handshakeTimeout) < std::chrono::steady_clock::now()) {
+        D3PP::network::Server::HandshakeTimeouts++;
+        Kick("Handshake timeout", true);
+        return;
+    }
+
+    bool sendStalled;
+    {
+        const std::scoped_lock<std::mutex> sLock(sendLock);
+        // -- Output held back by a map send that is still waiting for its turn isn't the client's fault.
+        sendStalled = SendOverflow || (!Outbound.Empty() && !BulkStarved && LastSendProgress + NETWORK_SEND_STALL_TIMEOUT < time(nullptr));
+    }
+    // -- A kick would only queue behind the backlog, so slow clients are dropped outright.
+    if (sendStalled) {
+        Shutdown(SendOverflow ? "Send queue overflow" : "Send stalled");
+        return;
+    }
+
     if (PingTime >= std::chrono::steady_clock::now()) return;
 
     PingTime = std::chrono::steady_clock::now() + std::chrono::seconds(5);
@@ -132,9 +179,12 @@ void NetworkClient::HandleEvent(const Event& e) {
 
         if (eventEntity->MapID != player->GetEntity()->MapID)
             return;
-        if (eventEntity->Id != player->GetEntity()->Id)
-            NetworkFunctions::NetworkOutEntityPosition(Id, eventEntity->ClientId, eventEntity->Location);
-        else
+        if (eventEntity->Id != player->GetEntity()->Id) {
+            if (ea.encodedPosition == nullptr)
+                ea.encodedPosition = NetworkFunctions::EncodeEntityPosition(eventEntity->ClientId, eventEntity->Location);
+
+            SendShared(ea.encodedPosition, D3PP::network::SendLane::Movement, static_cast<unsigned char>(eventEntity->ClientId));
+        } else
             NetworkFunctions::NetworkOutEntityPosition(Id, -1, eventEntity->Location);
     } else if (stringulate(e.type()) == ENTITY_EVENT_SPAWN) {
         const auto& ea = static_cast<const EventEntityAdd&>(e);
@@ -281,7 +331,8 @@ void NetworkClient::SetBlockPermissions(int blockId, bool canPlace, bool canDele
 }
 
 void NetworkClient::DataReady() {
-    DataAvailable = true;
+    if (!DataAvailable.exchange(true))
+        D3PP::network::Server::WakeNetwork(Shard);
 }
 
 NetworkClient::NetworkClient(NetworkClient &client) : Selections(MAX_SELECTION_BOXES) {
@@ -289,6 +340,15 @@ NetworkClient::NetworkClient(NetworkClient &client) : Selections(MAX_SELECTION_B
     SendBuffer = std::make_shared<ByteBuffer>([this]{ this->DataReady(); });//
     ReceiveBuffer = std::move(client.ReceiveBuffer);
     DataAvailable = false;
+    DataWaiting = false;
+    WriteBlocked = false;
+    InputBacklog = false;
+    Shard = -1;
+    SendOverflow = false;
+    BulkStarved = false;
+    LastSendProgress = time(nullptr);
+    ConnectedAt = std::chrono::steady_clock::now();
+    PacketBucket = D3PP::network::TokenBucket(Configuration::NetSettings.PacketRate, Configuration::NetSettings.PacketBurst, ConnectedAt);
     canReceive = true;
     m_currentUndoIndex = 0;
     canSend = true;
@@ -402,51 +462,218 @@ void NetworkClient::SendDeleteBlock(unsigned char blockId) {
 }
 
 bool NetworkClient::IsDataAvailable() {
-    return DataAvailable;
+    return DataAvailable && !WriteBlocked;
 }
 
 void NetworkClient::SendQueued() {
+    RefillBulk();
     const std::scoped_lock<std::mutex> sLock(sendLock);
-    int sendSize = SendBuffer->Size();
-    std::vector<unsigned char> allBytes = SendBuffer->GetAllBytes();
+    DataAvailable = false;
+    QueueSendBuffer();
+    ReleaseZeroCopy();
+
+    std::span<const unsigned char> slices[SOCKET_MAX_SLICES];
+    std::vector<D3PP::network::SharedPacket> owners;
+    while (!Outbound.Empty() || (WebSocket != nullptr && WebSocket->Pending())) {
+        // -- Everything queued goes out in one syscall, up to SOCKET_MAX_SLICES packets at a time.
+        size_t total = 0;
+        owners.clear();
+        int count = GatherFramed(slices, total, ZeroCopy ? &owners : nullptr);
+        // -- Whatever is left waits for a bulk stream that has nothing queued right now.
+        if (count == 0)
+            break;
+
+        bool zeroCopy = ZeroCopy && total >= NETWORK_ZEROCOPY_MIN_BYTES;
+        int bytesSent = clientSocket->SendVectored(slices, count, zeroCopy);
+
+        if (bytesSent == SOCKET_WOULD_BLOCK) {
+            // -- Socket buffer is full, the reactor tells us when it drains.
+            WriteBlocked = true;
+            DataAvailable = true;
+            return;
+        }
 
-    int bytesSent = clientSocket->Send(reinterpret_cast<char *>(allBytes.data()), sendSize);
+        if (bytesSent <= 0) {
+            Outbound.Clear();
+            BulkSource = nullptr;
+            BulkStarved = false;
+            return;
+        }
 
-    DataAvailable = false;
-    D3PP::network::Server::SentIncrement += bytesSent;
+        if (zeroCopy) {
+            // -- The kernel numbers every zero-copy send; hold the packets until it reports that one done.
+            for (auto const &packet : owners)
+                ZeroCopyHeld.emplace_back(ZeroCopySequence, packet);
+            ZeroCopySequence++;
+        }
+
+        Outbound.Advance(WebSocket != nullptr ? WebSocket->Consume(bytesSent) : bytesSent);
+        LastSendProgress = time(nullptr);
+        D3PP::network::Server::SentIncrement += bytesSent;
+    }
+
+    // -- The socket took everything, come back for more of the stream on the next pass.
+    if (NeedsBulk())
+        DataAvailable = true;
+}
+
+void NetworkClient::RefillBulk() {
+    std::shared_ptr<D3PP::network::IBulkSource> source;
+    {
+        const std::scoped_lock<std::mutex> sLock(sendLock);
+        if (!NeedsBulk())
+            return;
+        source = BulkSource;
+        // -- Set before asking, so a wake for anything produced after the source came up empty can't be lost.
+        BulkStarved = true;
+    }
+
+    // -- Taken outside the lock, so threads queueing to this client never wait on the source.
+    D3PP::network::SharedPacket packet;
+    while ((packet = source->Next()) != nullptr) {
+        const std::scoped_lock<std::mutex> sLock(sendLock);
+        if (BulkSource != source)
+            return;
+
+        BulkStarved = false;
+        Outbound.PushStream(packet);
+        if (!NeedsBulk())
+            return;
+        BulkStarved = true;
+    }
+
+    if (!source->Ended())
+        return;
+
+    D3PP::network::SharedPacket closing = source->Closing();
+    {
+        const std::scoped_lock<std::mutex> sLock(sendLock);
+        if (BulkSource != source)
+            return;
+
+        Outbound.CloseStream(closing);
+        BulkSource = nullptr;
+        BulkStarved = false;
+    }
+    source->Finished(closing != nullptr);
+}
+
+void NetworkClient::WakeBulk() {
+    const std::scoped_lock<std::mutex> sLock(sendLock);
+    if (!BulkStarved)
+        return;
+
+    BulkStarved = false;
+    // -- Waiting on the source doesn't count against the stall timeout.
+    LastSendProgress = time(nullptr);
+    DataReady();
+}
+
+bool NetworkClient::NeedsBulk() const {
+    return BulkSource != nullptr && !BulkStarved && Outbound.StreamOpen() && Outbound.LaneBytes(D3PP::network::SendLane::Bulk) < NETWORK_BULK_LOW_WATER;
+}
+
+int NetworkClient::GatherFramed(std::span<const unsigned char>* slices, size_t& total, std::vector<D3PP::network::SharedPacket>* owners) {
+    if (WebSocket == nullptr)
+        return Outbound.Gather(slices, SOCKET_MAX_SLICES, total, owners);
+
+    // -- One slot is left for the frame header.
+    int count = Outbound.Gather(slices, SOCKET_MAX_SLICES - 1, total, owners);
+    return WebSocket->Frame(slices, count, total);
+}
+
+void NetworkClient::ReleaseZeroCopy() {
+    unsigned int first, last;
+
+    while (!ZeroCopyHeld.empty() && clientSocket->ReapZeroCopy(first, last)) {
+        std::erase_if(ZeroCopyHeld, [first, last](const auto& held) { return held.first - first <= last - first; });
+    }
+}
+
+void NetworkClient::QueueSendBuffer() {
+    if (SendBuffer->Size() > 0)
+        QueueOutbound(D3PP::network::EncodedPacket::FromBytes(SendBuffer->GetAllBytes()), D3PP::network::SendLane::Control, -1, false);
+}
+
+void NetworkClient::QueueOutbound(const D3PP::network::SharedPacket& packet, D3PP::network::SendLane lane, int key, bool fence) {
+    if (SendOverflow)
+        return;
+
+    if (Outbound.Empty())
+        LastSendProgress = time(nullptr);
+
+    Outbound.Push(packet, lane, key, fence);
+
+    // -- Map data is bounded by the map itself; everything else piling up means the client can't keep up.
+    if (Outbound.InteractiveBytes() > static_cast<size_t>(Configuration::NetSettings.SendQueueLimit)) {
+        SendOverflow = true;
+        Logger::LogAdd(MODULE_NAME, "Send queue overflow [" + stringulate(Id) + "] [" + stringulate(Outbound.InteractiveBytes()) + " bytes]", LogType::WARNING, GLF);
+    }
 }
 
 bool NetworkClient::ReadData() {
-    if (canReceive) {
-        auto *receiveBuf = new char[1026];
-        receiveBuf[1024] = 99;
-        int dataRead = clientSocket->Read(receiveBuf, 1024);
-        LastTimeEvent = time(nullptr);
-        DataWaiting = false;
+    if (!canReceive)
+        return false;
+
+    LastTimeEvent = time(nullptr);
+    DataWaiting = false;
+
+    // -- Edge triggered: keep reading until the socket is drained, or we won't be told about this data again.
+    while (true) {
+        auto receiveBuf = ReceiveBuffer->WritableSpan(4096);
+        int dataRead = clientSocket->Read(reinterpret_cast<char *>(receiveBuf.data()), static_cast<int>(receiveBuf.size()));
 
-        if (dataRead > 0) {
-            std::vector<unsigned char> receive(receiveBuf, receiveBuf + dataRead);
-            ReceiveBuffer->Write(receive, dataRead);
-            D3PP::network::Server::ReceivedIncrement += dataRead;
-            delete[] receiveBuf;
+        if (dataRead == SOCKET_WOULD_BLOCK)
             return true;
-        } else {
-            delete[] receiveBuf;
+
+        if (dataRead <= 0) {
             D3PP::network::Server::UnregisterClient(GetSelfPointer());
             Shutdown("Connection lost");
             return false;
         }
+
+        ReceiveBuffer->CommitWrite(dataRead);
+        D3PP::network::Server::ReceivedIncrement += dataRead;
+
+        if (dataRead < static_cast<int>(receiveBuf.size()))
+            return true;
     }
 }
 void NetworkClient::HandleData() {
+    // -- Zero-copy completions are reported on the socket's error queue, which wakes the poller like incoming data.
+    // -- Reaping them here releases an idle client's buffers without waiting for its next send.
+    if (DataWaiting && ZeroCopy) {
+        const std::scoped_lock<std::mutex> sLock(sendLock);
+        ReleaseZeroCopy();
+    }
+
     if (DataWaiting) {
         if (!ReadData())
             return;
     }
 
-    int maxRepeat = 10;
-    while (ReceiveBuffer->Size() > 0 && maxRepeat > 0 && canReceive) {
-        unsigned char commandByte = ReceiveBuffer->PeekByte();
+    // -- Complete packets are drained in one pass, up to the budget so one busy client can't starve its shard.
+    // -- A web client's upgrade request starts with "GET", which is no valid Classic opcode.
+    if (WebSocket == nullptr && !LoggedIn && Configuration::NetSettings.WebSocket && ReceiveBuffer->Size() > 0 && ReceiveBuffer->PeekByte() == 'G') {
+        const std::scoped_lock<std::mutex> sLock(sendLock);
+        WebSocket = std::make_unique<D3PP::network::WebSocketCodec>();
+        WebSocketInput = std::make_shared<ByteBuffer>(nullptr);
+        // -- Frame headers are rewritten in place, the kernel must not be reading them later.
+        ZeroCopy = false;
+    }
+
+    if (WebSocket != nullptr && !ReadWebSocket())
+        return;
+
+    ByteBuffer& input = (WebSocket != nullptr) ? *WebSocketInput : *ReceiveBuffer;
+    int budget = std::max(1, Configuration::NetSettings.PacketBudget);
+    unsigned char wrapped[NETWORK_MAX_INBOUND_PACKET];
+    auto now = std::chrono::steady_clock::now();
+    InputBacklog = false;
+
+    while (input.Size() > 0 && budget > 0 && canReceive) {
+        auto view = input.ReadableSpan();
+        unsigned char commandByte = view[0];
         LastTimeEvent = time(nullptr);
 
         if (!LoggedIn) {
@@ -461,85 +688,90 @@ void NetworkClient::HandleData() {
             }
         }
 
+        int length = D3PP::network::InboundPacketLength(commandByte);
+        if (length < 0) {
+            Logger::LogAdd(MODULE_NAME, "Unknown Packet Received [" + stringulate((int)commandByte) + "]", LogType::WARNING, GLF);
+            Kick("Invalid Packet", true);
+            return;
+        }
+
+        // -- Incomplete packet, wait for the rest to arrive.
+        if (input.Size() < length)
+            break;
+
+        if (!PacketBucket.Take(now)) {
+            D3PP::network::Server::FloodKicks++;
+            Logger::LogAdd(MODULE_NAME, "Disconnecting " + this->IP + ": Packet flood.", WARNING, GLF);
+            Kick("Packet flood", true);
+            return;
+        }
+
+        // -- Only a packet straddling the end of the ring needs copying to be contiguous.
+        if (view.size() < static_cast<size_t>(length)) {
+            input.Peek(std::span<unsigned char>(wrapped, length));
+            view = std::span<const unsigned char>(wrapped, length);
+        }
+
+        D3PP::network::PacketReader reader(view.first(length));
+        reader.ReadByte();
+
         switch(commandByte) {
             case 0: // -- Login
-                if (ReceiveBuffer->Size() >= 1 + 1 + 64 + 64 + 1) {
-                    ReceiveBuffer->ReadByte();
-                    PacketHandlers::HandleHandshake(GetSelfPointer());
-                    ReceiveBuffer->Shift(1 + 1 + 64 + 64 + 1);
-                }
+                PacketHandlers::HandleHandshake(GetSelfPointer(), reader);
                 break;
             case 1: // -- Ping
-                if (ReceiveBuffer->Size() >= 1) {
-                    ReceiveBuffer->ReadByte();
-                    PacketHandlers::HandlePing(GetSelfPointer());
-                    ReceiveBuffer->Shift(1);
-                }
+                PacketHandlers::HandlePing(GetSelfPointer(), reader);
                 break;
             case 5: // -- Block Change
-                if (ReceiveBuffer->Size() >= 9) {
-                    ReceiveBuffer->ReadByte();
-                    PacketHandlers::HandleBlockChange(GetSelfPointer());
-                    ReceiveBuffer->Shift(9);
-                }
+                PacketHandlers::HandleBlockChange(GetSelfPointer(), reader);
                 break;
             case 8: // -- Player Movement
-                if (ReceiveBuffer->Size() >= 10) {
-                    ReceiveBuffer->ReadByte();
-                    PacketHandlers::HandlePlayerTeleport(GetSelfPointer());
-                    ReceiveBuffer->Shift(10);
-                }
+                PacketHandlers::HandlePlayerTeleport(GetSelfPointer(), reader);
                 break;
             case 13: // -- Chat Message
-                if (ReceiveBuffer->Size() >= 66) {
-                    ReceiveBuffer->ReadByte();
-                    PacketHandlers::HandleChatPacket(GetSelfPointer());
-                    ReceiveBuffer->Shift(66);
-                }
+                PacketHandlers::HandleChatPacket(GetSelfPointer(), reader);
                 break;
             case 16: // -- CPe ExtInfo
-                if (ReceiveBuffer->Size() >= 67) {
-                    ReceiveBuffer->ReadByte();
-                    PacketHandlers::HandleExtInfo(GetSelfPointer());
-                    ReceiveBuffer->Shift(67);
-                }
+                PacketHandlers::HandleExtInfo(GetSelfPointer(), reader);
                 break;
             case 17: // -- CPE ExtEntry
-                if (ReceiveBuffer->Size() >= 1 + 64 + 4) {
-                    ReceiveBuffer->ReadByte();
-                    PacketHandlers::HandleExtEntry(GetSelfPointer());
-                    ReceiveBuffer->Shift(69);
-                }
+                PacketHandlers::HandleExtEntry(GetSelfPointer(), reader);
                 break;
             case 19: // -- CPE Custom Block Support
-                if (ReceiveBuffer->Size() >= 2) {
-                    ReceiveBuffer->ReadByte();
-                    PacketHandlers::HandleCustomBlockSupportLevel(GetSelfPointer());
-                    ReceiveBuffer->Shift(2);
-                }
+                PacketHandlers::HandleCustomBlockSupportLevel(GetSelfPointer(), reader);
                 break;
             case 34: // -- CPE Player Clicked.
-                if (ReceiveBuffer->Size() >= 15) {
-                    ReceiveBuffer->ReadByte();
-                    PacketHandlers::HandlePlayerClicked(GetSelfPointer());
-                    ReceiveBuffer->Shift(15);
-                }
+                PacketHandlers::HandlePlayerClicked(GetSelfPointer(), reader);
                 break;
             case 43:
-                if (ReceiveBuffer->Size() >= 4) {
-                    ReceiveBuffer->ReadByte();
-                    PacketHandlers::HandleTwoWayPing(GetSelfPointer());
-                    ReceiveBuffer->Shift(4);
-                }
+                PacketHandlers::HandleTwoWayPing(GetSelfPointer(), reader);
                 break;
-
-            default:
-                Logger::LogAdd(MODULE_NAME, "Unknown Packet Received [" + stringulate((int)commandByte) + "]", LogType::WARNING, GLF);
-                Kick("Invalid Packet", true);
         }
 
-        maxRepeat--;
+        input.Shift(length);
+        budget--;
     } // -- /While
+
+    InputBacklog = (budget == 0 && input.Size() > 0 && canReceive);
+}
+
+bool NetworkClient::ReadWebSocket() {
+    D3PP::network::WebSocketStatus status;
+    {
+        const std::scoped_lock<std::mutex> sLock(sendLock);
+        status = WebSocket->Decode(*ReceiveBuffer, *WebSocketInput);
+        if (WebSocket->Pending())
+            DataReady();
+    }
+
+    if (status == D3PP::network::WebSocketStatus::Ok)
+        return true;
+
+    if (status == D3PP::network::WebSocketStatus::Error)
+        Logger::LogAdd(MODULE_NAME, "Disconnecting " + this->IP + ": Invalid WebSocket data.", WARNING, GLF);
+
+    Shutdown(status == D3PP::network::WebSocketStatus::Closed ? "WebSocket closed" : "Invalid WebSocket data");
+    return false;
 }
 
 void NetworkClient::SendPacket(D3PP::network::IPacket &p) {
@@ -547,6 +779,37 @@ void NetworkClient::SendPacket(D3PP::network::IPacket &p) {
     p.Write(SendBuffer);
 }
 
+void NetworkClient::SendShared(const D3PP::network::SharedPacket& packet, D3PP::network::SendLane lane, int key, bool fence) {
+    if (packet == nullptr || packet->Size() == 0 || !canSend)
+        return;
+
+    const std::scoped_lock sLock(sendLock);
+    // -- Anything written to SendBuffer so far is queued first.
+    QueueSendBuffer();
+    QueueOutbound(packet, lane, key, fence);
+    DataReady();
+}
+
+void NetworkClient::StreamBulk(const std::shared_ptr<D3PP::network::IBulkSource>& source) {
+    if (source == nullptr || !canSend)
+        return;
+
+    int clientId = Id;
+    source->SetWake([clientId]() {
+        auto client = std::static_pointer_cast<NetworkClient>(Network::GetInstance()->GetClient(clientId));
+        if (client != nullptr)
+            client->WakeBulk();
+    });
+
+    const std::scoped_lock sLock(sendLock);
+    QueueSendBuffer();
+    // -- A stream still open is cut off here, what it already queued still goes out.
+    Outbound.OpenStream();
+    BulkSource = source;
+    BulkStarved = false;
+    DataReady();
+}
+
 void NetworkClient::Undo(int steps) { 
     if (m_undoItems.empty())
         return;
@@ -611,13 +874,117 @@ void NetworkClient::NotifyDataAvailable() {
     DataWaiting = true;
 }
 
+void NetworkClient::NotifyWritable() {
+    WriteBlocked = false;
+}
+
+bool NetworkClient::HasPendingInput() {
+    return InputBacklog || DataWaiting;
+}
+
+#ifdef __linux__
+void NetworkClient::PrepareIo(std::vector<D3PP::Common::IoRequest>& requests) {
+    if (clientSocket == nullptr)
+        return;
+
+    int fd = clientSocket->GetSocketFd();
+
+    if (DataWaiting && canReceive) {
+        // -- The ring receives straight into the buffer, only this shard thread touches it until CompleteIo.
+        auto receiveBuf = ReceiveBuffer->WritableSpan(4096);
+        requests.push_back(D3PP::Common::IoRequest{fd, D3PP::Common::IoOperation::Recv, receiveBuf.data(), static_cast<unsigned int>(receiveBuf.size()), 0, 0});
+    }
+
+    if (!IsDataAvailable())
+        return;
+
+    RefillBulk();
+    const std::scoped_lock<std::mutex> sLock(sendLock);
+    DataAvailable = false;
+
+    QueueSendBuffer();
+
+    if (Outbound.Empty() && (WebSocket == nullptr || !WebSocket->Pending()))
+        return;
+
+    // -- One SENDMSG per client covers its whole queue; the header and iovecs live until CompleteIo,
+    // -- and the queue keeps the gathered packets alive until then.
+    std::span<const unsigned char> slices[SOCKET_MAX_SLICES];
+    size_t total = 0;
+    int count = GatherFramed(slices, total, nullptr);
+    if (count == 0)
+        return;
+
+    for (int i = 0; i < count; i++) {
+        SendIov[i].iov_base = const_cast<unsigned char *>(slices[i].data());
+        SendIov[i].iov_len = slices[i].size();
+    }
+
+    SendMessage = {};
+    SendMessage.msg_iov = SendIov;
+    SendMessage.msg_iovlen = count;
+    requests.push_back(D3PP::Common::IoRequest{fd, D3PP::Common::IoOperation::SendMsg, &SendMessage, static_cast<unsigned int>(total), 0, 0});
+}
+
+void NetworkClient::CompleteIo(const D3PP::Common::IoRequest& request) {
+    if (request.Op == D3PP::Common::IoOperation::Recv) {
+        LastTimeEvent = time(nullptr);
+
+        if (request.Result == -EAGAIN || request.Result == -EINTR) {
+            DataWaiting = (request.Result == -EINTR);
+            return;
+        }
+
+        if (request.Result <= 0) {
+            DataWaiting = false;
+            D3PP::network::Server::UnregisterClient(GetSelfPointer());
+            Shutdown("Connection lost");
+            return;
+        }
+
+        ReceiveBuffer->CommitWrite(request.Result);
+        D3PP::network::Server::ReceivedIncrement += request.Result;
+        // -- A full buffer means there may be more; HandleData drains the rest.
+        DataWaiting = (request.Result == static_cast<int>(request.Length));
+        return;
+    }
+
+    const std::scoped_lock<std::mutex> sLock(sendLock);
+    if (request.Result == -EAGAIN || request.Result == -EINTR) {
+        WriteBlocked = (request.Result == -EAGAIN);
+        DataAvailable = true;
+        return;
+    }
+
+    if (request.Result <= 0) {
+        Outbound.Clear();
+        BulkSource = nullptr;
+        BulkStarved = false;
+        return;
+    }
+
+    Outbound.Advance(WebSocket != nullptr ? WebSocket->Consume(request.Result) : request.Result);
+    LastSendProgress = time(nullptr);
+    D3PP::network::Server::SentIncrement += request.Result;
+
+    if (!Outbound.Empty() || SendBuffer->Size() > 0 || (WebSocket != nullptr && WebSocket->Pending()) || NeedsBulk())
+        DataAvailable = true;
+}
+#endif
+
 void NetworkClient::Shutdown(const std::string& reason) {
     Client::Logout(Id, reason, true);
     canSend = false;
     canReceive = false;
     D3PP::network::Server::UnregisterClient(GetSelfPointer());
     Logger::LogAdd(MODULE_NAME, "Client deleted [" + stringulate(Id) + "] [" + reason + "]", LogType::NORMAL, GLF);
-    clientSocket->Disconnect();
+    {
+        const std::scoped_lock<std::mutex> sLock(sendLock);
+        ReleaseZeroCopy();
+        clientSocket->Disconnect();
+        // -- Nothing is reported for a closed socket; the kernel holds its own references to pages still in flight.
+        ZeroCopyHeld.clear();
+    }
     D3PP::network::Server::UnregisterClient(GetSelfPointer());
 }
 
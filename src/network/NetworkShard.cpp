@@ -0,0 +1,178 @@
+#include "network/NetworkShard.h"
+
+#include <cerrno>
+#include <chrono>
+
+#ifndef __linux__
+#include "network/WindowsServerSockets.h"
+#else
+#include "network/LinuxServerSockets.h"
+#include "common/IoUring.h"
+#endif
+
+#include "common/Logger.h"
+#include "common/Configuration.h"
+#include "network/NetworkClient.h"
+#include "System.h"
+#include "Utils.h"
+
+// -- Upper bound on how long a shard sleeps without socket activity; keeps shutdown responsive.
+#define SHARD_IDLE_WAIT_MS 250
+
+namespace D3PP::network {
+    NetworkShard::NetworkShard(int index, std::unique_ptr<ServerSocket> socket) {
+        m_index = index;
+        m_socket = std::move(socket);
+        m_needsUpdate = false;
+
+#ifdef __linux__
+        // -- "auto" and "io_uring" use a ring when the kernel has one, anything else (or no support) stays on epoll.
+        std::string ioBackend = Configuration::NetSettings.IoBackend;
+        if (ioBackend != "epoll" && D3PP::Common::IoUring::Supported())
+            m_ioRing = std::make_unique<D3PP::Common::IoUring>();
+#endif
+    }
+
+    NetworkShard::~NetworkShard() {
+        Join();
+    }
+
+    void NetworkShard::Start(const std::function<void()>& onConnect, const std::function<void()>& onTick) {
+        m_onConnect = onConnect;
+        m_onTick = onTick;
+        std::thread shardThread([this]() { this->Run(); });
+        std::swap(m_thread, shardThread);
+    }
+
+    void NetworkShard::Join() {
+        if (m_thread.joinable()) {
+            Wake();
+            m_thread.join();
+        }
+    }
+
+    void NetworkShard::Add(const std::shared_ptr<IMinecraftClient>& client, int fd) {
+        {
+            std::scoped_lock<std::mutex> clientLock(m_clientLock);
+            m_clients.insert(std::make_pair(client->GetId(), client));
+            m_needsUpdate = true;
+        }
+
+        // -- Registered before it is watched, so the first readiness event already finds the client.
+        m_socket->Adopt(fd);
+        Wake();
+    }
+
+    void NetworkShard::Remove(int clientId) {
+        std::scoped_lock<std::mutex> clientLock(m_clientLock);
+        if (m_clients.erase(clientId) == 0)
+            return;
+
+        m_socket->Unaccept(clientId);
+        m_needsUpdate = true;
+    }
+
+    void NetworkShard::Wake() const {
+        m_socket->Wake();
+    }
+
+    size_t NetworkShard::ClientCount() {
+        std::scoped_lock<std::mutex> clientLock(m_clientLock);
+        return m_clients.size();
+    }
+
+    void NetworkShard::Run() {
+        bool busy = false;
+
+        while (System::IsRunning) {
+#ifdef __linux__
+            HandleEvents(busy ? 0 : SHARD_IDLE_WAIT_MS);
+#else
+            HandleEvents(0);
+#endif
+            if (m_needsUpdate.exchange(false)) {
+                std::scoped_lock<std::mutex> clientLock(m_clientLock);
+                m_roClients.clear();
+                for (auto const &c : m_clients)
+                    m_roClients.push_back(c.second);
+            }
+
+            busy = false;
+            bool batched = false;
+#ifdef __linux__
+            if (m_ioRing != nullptr) {
+                HandleBatchedIo();
+                batched = true;
+            }
+#endif
+            for (auto const &c : m_roClients) {
+                if (!batched && c->IsDataAvailable())
+                    c->SendQueued();
+
+                c->HandleData();
+                busy = busy || c->HasPendingInput() || c->IsDataAvailable();
+            }
+
+            if (m_onTick)
+                m_onTick();
+#ifndef __linux__
+            std::this_thread::sleep_for(std::chrono::milliseconds(5));
+#endif
+        }
+    }
+
+    void NetworkShard::HandleEvents(int timeoutMs) {
+        auto e = m_socket->CheckEvents(timeoutMs);
+
+        if (e.contains(ServerSocketEvent::SOCKET_EVENT_CONNECT) && m_onConnect) {
+            m_onConnect();
+        }
+        if (e.contains(ServerSocketEvent::SOCKET_EVENT_DATA) || e.contains(ServerSocketEvent::SOCKET_EVENT_WRITABLE)) {
+            std::scoped_lock<std::mutex> clientLock(m_clientLock);
+            for(auto &s : e[ServerSocketEvent::SOCKET_EVENT_DATA]) {
+                auto client = m_clients.find(static_cast<int>(s));
+                if (client != m_clients.end())
+                    client->second->NotifyDataAvailable();
+            }
+            for(auto &s : e[ServerSocketEvent::SOCKET_EVENT_WRITABLE]) {
+                auto client = m_clients.find(static_cast<int>(s));
+                if (client != m_clients.end())
+                    client->second->NotifyWritable();
+            }
+        }
+    }
+
+    void NetworkShard::HandleBatchedIo() {
+#ifdef __linux__
+        std::vector<D3PP::Common::IoRequest> requests;
+        std::vector<std::shared_ptr<NetworkClient>> owners;
+
+        for (auto const &c: m_roClients) {
+            auto client = std::dynamic_pointer_cast<NetworkClient>(c);
+            if (client == nullptr)
+                continue;
+
+            client->PrepareIo(requests);
+            owners.resize(requests.size(), client);
+        }
+
+        if (requests.empty())
+            return;
+
+        // -- One submission for every client's recv and send this tick.
+        if (!m_ioRing->SubmitAndWait(requests)) {
+            Logger::LogAdd("NetworkShard", "io_uring submission failed on shard " + stringulate(m_index) + ", falling back to epoll.", LogType::L_ERROR, GLF);
+            m_ioRing.reset();
+
+            // -- Unfinished requests are retried through the regular socket calls.
+            for (auto& request : requests) {
+                if (request.Result == -ECANCELED)
+                    request.Result = -EINTR;
+            }
+        }
+
+        for (size_t i = 0; i < requests.size(); i++)
+            owners[i]->CompleteIo(requests[i]);
+#endif
+    }
+}
@@ -2,6 +2,8 @@
 // Created by Wande on 3/17/2021.
 //
 
+#include <algorithm>
+
 #include "common/Vectors.h"
 #include "network/Network_Functions.h"
 #include "network/Chat.h"
@@ -10,9 +12,9 @@
 #include "network/Packets.h"
 #include "network/Network.h"
 #include "network/NetworkClient.h"
-#include "network/packets/BlockChangePacket.h"
 #include "network/packets/SpawnEffectPacket.h"
 #include "network/IPacket.h"
+#include "network/EncodedPacket.h"
 #include "world/Entity.h"
 #include "Block.h"
 #include "world/Player.h"
@@ -74,13 +76,14 @@ void NetworkFunctions::SystemMessageNetworkSend2All(const int& mapId, const std:
         std::string text = linev.at(i);
 
         if (!text.empty()) {
+            auto packet = Packets::EncodeChatMessage(text, static_cast<char>(type));
             std::shared_lock lock(D3PP::network::Server::roMutex);
             for (auto const &nc : D3PP::network::Server::roClients) {
                 if (!nc->GetLoggedIn() || nc->GetPlayerInstance() == nullptr)
                     continue;
 
                 if (mapId == -1 || nc->GetPlayerInstance()->GetEntity()->MapID == mapId) {
-                    Packets::SendChatMessage(nc->GetId(), text, type);
+                    nc->SendShared(packet);
                 }
             }
         }
@@ -104,6 +107,7 @@ void NetworkFunctions::NetworkOutBlockSet(const int& clientId, const short& x, c
     }
 }
 void NetworkFunctions::PacketToMap(const int& mapId, D3PP::network::IPacket& p, std::string reqExt, int reqVer) {
+    D3PP::network::SharedPacket encoded;
     for(auto const &nc : D3PP::network::Server::roClients) {
         if (!nc->GetLoggedIn() || nc->GetPlayerInstance() == nullptr)
             continue;
@@ -112,7 +116,10 @@ void NetworkFunctions::PacketToMap(const int& mapId, D3PP::network::IPacket& p,
             continue;
 
         if (reqExt.empty() || CPE::GetClientExtVersion(nc, reqExt) == reqVer) {
-            nc->SendPacket(p);
+            if (encoded == nullptr)
+                encoded = D3PP::network::EncodedPacket::Encode(p);
+
+            nc->SendShared(encoded);
         }
     }
 }
@@ -120,6 +127,9 @@ void NetworkFunctions::PacketToMap(const int& mapId, D3PP::network::IPacket& p,
 void NetworkFunctions::NetworkOutBlockSet2Map(const int& mapId, const unsigned short& x, const unsigned short& y, const unsigned short& z, const unsigned char& type) {
     Block* b = Block::GetInstance();
     MapBlock mb = b->GetBlock(type);
+    // -- Clients only differ in whether they need the CPE fallback block, so there are at most two encodings.
+    D3PP::network::SharedPacket native;
+    D3PP::network::SharedPacket fallback;
 
     std::shared_lock lock(D3PP::network::Server::roMutex);
     for(auto const &nc : D3PP::network::Server::roClients) {
@@ -129,18 +139,99 @@ void NetworkFunctions::NetworkOutBlockSet2Map(const int& mapId, const unsigned s
         if (nc->GetPlayerInstance()->GetEntity()->MapID != mapId)
             continue;
 
-        int onClient = mb.OnClient;
         int dbl = CPE::GetClientExtVersion(nc, BLOCK_DEFS_EXT_NAME);
-        if (mb.CpeLevel > nc->GetCustomBlocksLevel()) {
-            onClient = mb.CpeReplace;
-        }
+        bool useFallback = mb.CpeLevel > nc->GetCustomBlocksLevel();
         if (mb.OnClient > 65 && dbl < 1) { // -- If the user doesn't support customblocks and this is a custom block, replace with stone.
-            onClient = 1;
             continue;
         }
 
-        D3PP::network::BlockChangePacket p(D3PP::Common::Vector3S(x, y, z), 0, onClient);
-        nc->SendPacket(p);
+        auto& packet = useFallback ? fallback : native;
+        if (packet == nullptr)
+            packet = Packets::EncodeBlockChange(static_cast<short>(x), static_cast<short>(y), static_cast<short>(z), static_cast<unsigned char>(useFallback ? mb.CpeReplace : mb.OnClient));
+
+        nc->SendShared(packet, D3PP::network::SendLane::Block);
+    }
+}
+
+static std::vector<D3PP::network::SharedPacket> EncodeBlockSets(const D3PP::Common::Vector3S& mapSize, const std::vector<D3PP::Common::Vector3S>& locations, const std::vector<MapBlock>& blocks, int blocksLevel, bool definitions, bool bulk) {
+    std::vector<D3PP::network::SharedPacket> result;
+    std::vector<size_t> kept;
+    std::vector<unsigned char> types;
+
+    for (size_t i = 0; i < locations.size(); i++) {
+        const MapBlock& mb = blocks[i];
+        if (mb.OnClient > 65 && !definitions) // -- Custom blocks aren't sent to clients without block definitions.
+            continue;
+
+        kept.push_back(i);
+        types.push_back(static_cast<unsigned char>(mb.CpeLevel > blocksLevel ? mb.CpeReplace : mb.OnClient));
+    }
+
+    size_t bulkCount = 0;
+    if (bulk) {
+        bulkCount = kept.size() - kept.size() % BULK_BLOCK_UPDATE_MAX;
+        if (kept.size() - bulkCount >= BULK_BLOCK_UPDATE_MIN)
+            bulkCount = kept.size();
+    }
+
+    int indices[BULK_BLOCK_UPDATE_MAX];
+    for (size_t offset = 0; offset < bulkCount; offset += BULK_BLOCK_UPDATE_MAX) {
+        int count = static_cast<int>(std::min<size_t>(BULK_BLOCK_UPDATE_MAX, bulkCount - offset));
+        for (int i = 0; i < count; i++) {
+            const D3PP::Common::Vector3S& location = locations[kept[offset + i]];
+            // -- Level data order, the same as the map's own layout.
+            indices[i] = (location.Z * mapSize.Y + location.Y) * mapSize.X + location.X;
+        }
+        result.push_back(Packets::EncodeBulkBlockUpdate(indices, types.data() + offset, count));
+    }
+
+    for (size_t i = bulkCount; i < kept.size(); i++) {
+        const D3PP::Common::Vector3S& location = locations[kept[i]];
+        result.push_back(Packets::EncodeBlockChange(location.X, location.Y, location.Z, types[i]));
+    }
+
+    return result;
+}
+
+void NetworkFunctions::NetworkOutBlockSets2Map(const int& mapId, const D3PP::Common::Vector3S& mapSize, const std::vector<D3PP::Common::Vector3S>& locations, const std::vector<unsigned char>& types) {
+    Block* b = Block::GetInstance();
+    std::vector<MapBlock> blocks;
+    blocks.reserve(types.size());
+    for (auto const &type : types)
+        blocks.push_back(b->GetBlock(type));
+
+    // -- Clients only differ in their custom block level, block definitions and BulkBlockUpdate support, so the
+    // -- batch is encoded once per combination present on the map.
+    struct Encoding {
+        int BlocksLevel;
+        bool Definitions;
+        bool Bulk;
+        std::vector<D3PP::network::SharedPacket> Packets;
+    };
+    std::vector<Encoding> encodings;
+
+    std::shared_lock lock(D3PP::network::Server::roMutex);
+    for(auto const &nc : D3PP::network::Server::roClients) {
+        if (!nc->GetLoggedIn() || nc->GetPlayerInstance() == nullptr)
+            continue;
+
+        if (nc->GetPlayerInstance()->GetEntity()->MapID != mapId)
+            continue;
+
+        int blocksLevel = nc->GetCustomBlocksLevel();
+        bool definitions = CPE::GetClientExtVersion(nc, BLOCK_DEFS_EXT_NAME) >= 1;
+        bool bulk = CPE::GetClientExtVersion(nc, BULK_BLOCK_UPDATE_EXT_NAME) == 1;
+
+        auto encoding = std::find_if(encodings.begin(), encodings.end(), [&](const Encoding& e) {
+            return e.BlocksLevel == blocksLevel && e.Definitions == definitions && e.Bulk == bulk;
+        });
+        if (encoding == encodings.end()) {
+            encodings.push_back(Encoding { blocksLevel, definitions, bulk, EncodeBlockSets(mapSize, locations, blocks, blocksLevel, definitions, bulk) });
+            encoding = std::prev(encodings.end());
+        }
+
+        for (auto const &packet : encoding->Packets)
+            nc->SendShared(packet, D3PP::network::SendLane::Block);
     }
 }
 
@@ -167,3 +258,9 @@ void NetworkFunctions::NetworkOutEntityPosition(const int& clientId, const char&
     auto look = static_cast<unsigned char>((location.Look / 360) * 256.0);
     Packets::SendPlayerTeleport(clientId, playerId, location.X(), location.Y(), location.Z(), static_cast<char>(rotation), static_cast<char>(look));
 }
+
+D3PP::network::SharedPacket NetworkFunctions::EncodeEntityPosition(const char& playerId, const MinecraftLocation& location) {
+    auto rotation = static_cast<unsigned char>((location.Rotation / 360) * 256.0);
+    auto look = static_cast<unsigned char>((location.Look / 360) * 256.0);
+    return Packets::EncodePlayerTeleport(playerId, location.X(), location.Y(), location.Z(), static_cast<char>(rotation), static_cast<char>(look));
+}
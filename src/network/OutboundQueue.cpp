@@ -0,0 +1,225 @@
+#include "network/OutboundQueue.h"
+
+#include <iterator>
+#include <limits>
+
+namespace D3PP::network {
+    OutboundQueue::OutboundQueue() : m_partial(), m_partialLane(0), m_partialOffset(0), m_nextSequence(0), m_queuedBytes(0), m_streamOpen(false) {
+        m_laneBytes.fill(0);
+        m_gatheredCount.fill(0);
+    }
+
+    void OutboundQueue::Push(const SharedPacket& packet, SendLane lane, int key, bool fence) {
+        if (packet == nullptr || packet->Size() == 0)
+            return;
+
+        int index = static_cast<int>(lane);
+        auto& queue = m_lanes[index];
+
+        if (lane == SendLane::Movement && key >= 0) {
+            // -- Only entries the last Gather did not hand out may be replaced, those may be in flight.
+            for (size_t i = queue.size(); i > m_gatheredCount[index]; i--) {
+                auto& queued = queue[i - 1];
+                // -- Nor across a fence: the update belongs behind it, the older one stays in front of it.
+                if (!m_fences.empty() && queued.Sequence < m_fences.back())
+                    break;
+                if (queued.Key != key)
+                    continue;
+
+                m_laneBytes[index] -= queued.Packet->Size();
+                m_queuedBytes -= queued.Packet->Size();
+                queued.Packet = packet;
+                m_laneBytes[index] += packet->Size();
+                m_queuedBytes += packet->Size();
+                return;
+            }
+        }
+
+        if (fence)
+            m_fences.push_back(m_nextSequence);
+
+        queue.push_back(QueuedPacket { packet, m_nextSequence++, key, fence });
+        m_laneBytes[index] += packet->Size();
+        m_queuedBytes += packet->Size();
+    }
+
+    int OutboundQueue::Gather(std::span<const unsigned char>* slices, int max, size_t& total, std::vector<SharedPacket>* owners) {
+        int count = 0;
+        total = 0;
+        m_gathered.clear();
+        m_gatheredCount.fill(0);
+
+        if (m_partial.Packet != nullptr && count < max) {
+            slices[count++] = std::span<const unsigned char>(m_partial.Packet->Data() + m_partialOffset, m_partial.Packet->Size() - m_partialOffset);
+            total += m_partial.Packet->Size() - m_partialOffset;
+            m_gathered.push_back(-1);
+            if (owners != nullptr)
+                owners->push_back(m_partial.Packet);
+        }
+
+        std::array<size_t, LaneCount> cursor {};
+        size_t fenceCursor = 0;
+
+        while (count < max) {
+            int picked = -1;
+            for (int lane = 0; lane < LaneCount; lane++) {
+                if (cursor[lane] < m_lanes[lane].size() && CanSend(lane, cursor, fenceCursor)) {
+                    picked = lane;
+                    break;
+                }
+            }
+
+            if (picked == -1)
+                break;
+
+            const auto& queued = m_lanes[picked][cursor[picked]++];
+            if (queued.Fence)
+                fenceCursor++;
+
+            slices[count++] = std::span<const unsigned char>(queued.Packet->Data(), queued.Packet->Size());
+            total += queued.Packet->Size();
+            m_gathered.push_back(picked);
+            if (owners != nullptr)
+                owners->push_back(queued.Packet);
+        }
+
+        m_gatheredCount = cursor;
+        return count;
+    }
+
+    bool OutboundQueue::CanSend(int lane, const std::array<size_t, LaneCount>& cursor, size_t fenceCursor) const {
+        const auto& queued = m_lanes[lane][cursor[lane]];
+
+        // -- An open stream's fence, its packet isn't there yet.
+        if (queued.Packet == nullptr)
+            return false;
+
+        if (queued.Fence) {
+            // -- Fences are FIFO within the Bulk lane, so this is the next one; it waits for anything older.
+            for (int other = 0; other < LaneCount; other++) {
+                if (other != lane && cursor[other] < m_lanes[other].size() && m_lanes[other][cursor[other]].Sequence < queued.Sequence)
+                    return false;
+            }
+            return true;
+        }
+
+        uint64_t nextFence = fenceCursor < m_fences.size() ? m_fences[fenceCursor] : std::numeric_limits<uint64_t>::max();
+        if (queued.Sequence > nextFence)
+            return false;
+
+        auto bulk = static_cast<int>(SendLane::Bulk);
+        if (lane == static_cast<int>(SendLane::Block) && cursor[bulk] < m_lanes[bulk].size() && m_lanes[bulk][cursor[bulk]].Sequence < queued.Sequence)
+            return false;
+
+        return true;
+    }
+
+    void OutboundQueue::Advance(size_t sent) {
+        for (int lane : m_gathered) {
+            if (lane == -1) {
+                size_t left = m_partial.Packet->Size() - m_partialOffset;
+                if (sent < left) {
+                    m_partialOffset += sent;
+                    break;
+                }
+
+                sent -= left;
+                m_laneBytes[m_partialLane] -= m_partial.Packet->Size();
+                m_queuedBytes -= m_partial.Packet->Size();
+                m_partial = QueuedPacket();
+                m_partialOffset = 0;
+                continue;
+            }
+
+            size_t size = m_lanes[lane].front().Packet->Size();
+            if (sent < size) {
+                if (sent > 0) {
+                    m_partial = m_lanes[lane].front();
+                    m_partialLane = lane;
+                    m_partialOffset = sent;
+                    PopFront(lane);
+                }
+                break;
+            }
+
+            sent -= size;
+            m_laneBytes[lane] -= size;
+            m_queuedBytes -= size;
+            PopFront(lane);
+        }
+
+        m_gathered.clear();
+        m_gatheredCount.fill(0);
+    }
+
+    void OutboundQueue::Clear() {
+        for (auto& lane : m_lanes)
+            lane.clear();
+
+        m_laneBytes.fill(0);
+        m_gatheredCount.fill(0);
+        m_fences.clear();
+        m_gathered.clear();
+        m_partial = QueuedPacket();
+        m_partialOffset = 0;
+        m_queuedBytes = 0;
+        m_streamOpen = false;
+    }
+
+    void OutboundQueue::OpenStream() {
+        if (m_streamOpen)
+            CloseStream(nullptr);
+
+        auto bulk = static_cast<int>(SendLane::Bulk);
+        m_fences.push_back(m_nextSequence);
+        m_lanes[bulk].push_back(QueuedPacket { nullptr, m_nextSequence++, -1, true });
+        m_streamOpen = true;
+    }
+
+    void OutboundQueue::PushStream(const SharedPacket& packet) {
+        if (!m_streamOpen || packet == nullptr || packet->Size() == 0)
+            return;
+
+        // -- Takes the fence's sequence: older than anything queued after the stream opened, so only the fence orders it.
+        auto fence = StreamFence();
+        uint64_t sequence = fence->Sequence;
+        m_lanes[static_cast<int>(SendLane::Bulk)].insert(fence, QueuedPacket { packet, sequence, -1, false });
+        m_laneBytes[static_cast<int>(SendLane::Bulk)] += packet->Size();
+        m_queuedBytes += packet->Size();
+    }
+
+    void OutboundQueue::CloseStream(const SharedPacket& closing) {
+        if (!m_streamOpen)
+            return;
+
+        m_streamOpen = false;
+        auto fence = StreamFence();
+
+        if (closing != nullptr && closing->Size() > 0) {
+            fence->Packet = closing;
+            m_laneBytes[static_cast<int>(SendLane::Bulk)] += closing->Size();
+            m_queuedBytes += closing->Size();
+            return;
+        }
+
+        std::erase(m_fences, fence->Sequence);
+        m_lanes[static_cast<int>(SendLane::Bulk)].erase(fence);
+    }
+
+    std::deque<OutboundQueue::QueuedPacket>::iterator OutboundQueue::StreamFence() {
+        auto& bulk = m_lanes[static_cast<int>(SendLane::Bulk)];
+        // -- Bulk only ever holds a handful of entries behind the fence, so a backwards scan is cheap.
+        for (auto it = bulk.end(); it != bulk.begin(); --it) {
+            if (std::prev(it)->Packet == nullptr)
+                return std::prev(it);
+        }
+        return bulk.end();
+    }
+
+    void OutboundQueue::PopFront(int lane) {
+        if (m_lanes[lane].front().Fence)
+            m_fences.pop_front();
+
+        m_lanes[lane].pop_front();
+    }
+}
@@ -14,18 +14,18 @@
 #include "BuildMode.h"
 #include "CPE.h"
 #include "Utils.h"
-#include "common/ByteBuffer.h"
+#include "network/PacketReader.h"
 #include "network/Packets.h"
 #include "common/Vectors.h"
 #include "common/MinecraftLocation.h"
 
 using namespace D3PP::Common;
 
-void PacketHandlers::HandleHandshake(const std::shared_ptr<NetworkClient>& client) {
-	const char clientVersion = static_cast<char>(client->ReceiveBuffer->ReadByte());
-    std::string clientName = client->ReceiveBuffer->ReadString();
-	const std::string mppass = client->ReceiveBuffer->ReadString();
-	const char isCpe = static_cast<char>(client->ReceiveBuffer->ReadByte());
+void PacketHandlers::HandleHandshake(const std::shared_ptr<NetworkClient>& client, D3PP::network::PacketReader& reader) {
+	const char clientVersion = static_cast<char>(reader.ReadByte());
+    std::string clientName = reader.ReadString();
+	const std::string mppass = reader.ReadString();
+	const char isCpe = static_cast<char>(reader.ReadByte());
     Utils::TrimString(clientName);
 
     if (!client->LoggedIn && isCpe != 66) {
@@ -36,16 +36,16 @@ void PacketHandlers::HandleHandshake(const std::shared_ptr<NetworkClient>& clien
     }
 }
 
-void PacketHandlers::HandlePing(const std::shared_ptr<NetworkClient> &client) {
+void PacketHandlers::HandlePing(const std::shared_ptr<NetworkClient>& client, D3PP::network::PacketReader& /*reader*/) {
     client->Ping = static_cast<float>((std::chrono::steady_clock::now() - client->PingSentTime).count());
 }
 
-void PacketHandlers::HandleBlockChange(const std::shared_ptr<NetworkClient> &client) {
-	const short x = client->ReceiveBuffer->ReadShort();
-	const short z = client->ReceiveBuffer->ReadShort();
-	const short y = client->ReceiveBuffer->ReadShort();
-	const char mode = static_cast<char>(client->ReceiveBuffer->ReadByte() & 255);
-	const char type = static_cast<char>(client->ReceiveBuffer->ReadByte() & 255);
+void PacketHandlers::HandleBlockChange(const std::shared_ptr<NetworkClient>& client, D3PP::network::PacketReader& reader) {
+	const short x = reader.ReadShort();
+	const short z = reader.ReadShort();
+	const short y = reader.ReadShort();
+	const char mode = static_cast<char>(reader.ReadByte() & 255);
+	const char type = static_cast<char>(reader.ReadByte() & 255);
 
     if (!client->LoggedIn || !client->GetPlayerInstance()->GetEntity())
         return;
@@ -54,22 +54,22 @@ void PacketHandlers::HandleBlockChange(const std::shared_ptr<NetworkClient> &cli
     bmm->Distribute(client->GetId(), client->GetPlayerInstance()->GetEntity()->MapID, x, y, z, (mode > 0), type);
 }
 
-void PacketHandlers::HandlePlayerTeleport(const std::shared_ptr<NetworkClient> &client) {
+void PacketHandlers::HandlePlayerTeleport(const std::shared_ptr<NetworkClient>& client, D3PP::network::PacketReader& reader) {
     // -- CPE :)
     if (CPE::GetClientExtVersion(client, HELDBLOCK_EXT_NAME) == 1) {
         if (client->GetPlayerInstance()->GetEntity() != nullptr)
-            client->GetPlayerInstance()->GetEntity()->heldBlock = client->ReceiveBuffer->ReadByte();
+            client->GetPlayerInstance()->GetEntity()->heldBlock = reader.ReadByte();
         else
-            client->ReceiveBuffer->ReadByte();
+            reader.ReadByte();
     } else {
-        client->ReceiveBuffer->ReadByte();
+        reader.ReadByte();
     }
 
-    const auto X = static_cast<unsigned short>(client->ReceiveBuffer->ReadShort());
-    const auto Z = static_cast<unsigned short>(client->ReceiveBuffer->ReadShort());
-    const auto Y = static_cast<unsigned short>(client->ReceiveBuffer->ReadShort());
-    const char R = static_cast<char>(client->ReceiveBuffer->ReadByte());
-    const char L = static_cast<char>(client->ReceiveBuffer->ReadByte());
+    const auto X = static_cast<unsigned short>(reader.ReadShort());
+    const auto Z = static_cast<unsigned short>(reader.ReadShort());
+    const auto Y = static_cast<unsigned short>(reader.ReadShort());
+    const char R = static_cast<char>(reader.ReadByte());
+    const char L = static_cast<char>(reader.ReadByte());
     const auto rot = static_cast<float>((R / 255.0) * 360);
     const auto look = static_cast<float>((L / 255.0) * 360);
 
@@ -82,18 +82,18 @@ void PacketHandlers::HandlePlayerTeleport(const std::shared_ptr<NetworkClient> &
         client->GetPlayerInstance()->GetEntity()->PositionSet(client->GetPlayerInstance()->GetEntity()->MapID, inputLocation, 1, false);
 }
 
-void PacketHandlers::HandleChatPacket(const std::shared_ptr<NetworkClient> &client) {
-	const char playerId = client->ReceiveBuffer->ReadByte();
-    std::string message = client->ReceiveBuffer->ReadString();
+void PacketHandlers::HandleChatPacket(const std::shared_ptr<NetworkClient>& client, D3PP::network::PacketReader& reader) {
+	const char playerId = reader.ReadByte();
+    std::string message = reader.ReadString();
     Utils::TrimString(message);
     if (client->LoggedIn && client->GetPlayerInstance()->GetEntity()) {
         Chat::HandleIncomingChat(client, message, playerId);
     }
 }
 
-void PacketHandlers::HandleExtInfo(const std::shared_ptr<NetworkClient> &client) {
-    std::string appName = client->ReceiveBuffer->ReadString();
-    const short extensions = client->ReceiveBuffer->ReadShort();
+void PacketHandlers::HandleExtInfo(const std::shared_ptr<NetworkClient>& client, D3PP::network::PacketReader& reader) {
+    std::string appName = reader.ReadString();
+    const short extensions = reader.ReadShort();
     client->CPE = true;
     
     if (extensions == 0) {
@@ -104,9 +104,9 @@ void PacketHandlers::HandleExtInfo(const std::shared_ptr<NetworkClient> &client)
     Logger::LogAdd("CPE", "Client " + appName + " supports " + stringulate(extensions) + " extensions", LogType::DEBUG, GLF);
 }
 
-void PacketHandlers::HandleExtEntry(const std::shared_ptr<NetworkClient> &client) {
-    std::string extName = client->ReceiveBuffer->ReadString();
-    int extVersion = client->ReceiveBuffer->ReadInt();
+void PacketHandlers::HandleExtEntry(const std::shared_ptr<NetworkClient>& client, D3PP::network::PacketReader& reader) {
+    std::string extName = reader.ReadString();
+    int extVersion = reader.ReadInt();
     
     client->CustomExtensions--;
     client->Extensions.insert(std::make_pair(extName, extVersion));
@@ -115,8 +115,8 @@ void PacketHandlers::HandleExtEntry(const std::shared_ptr<NetworkClient> &client
     }
 }
 
-void PacketHandlers::HandleCustomBlockSupportLevel(const std::shared_ptr<NetworkClient> &client) {
-	const unsigned char supportLevel = client->ReceiveBuffer->ReadByte();
+void PacketHandlers::HandleCustomBlockSupportLevel(const std::shared_ptr<NetworkClient>& client, D3PP::network::PacketReader& reader) {
+	const unsigned char supportLevel = reader.ReadByte();
     client->CustomBlocksLevel = supportLevel;
 
     Logger::LogAdd("CPE", "CPE Process complete.", LogType::DEBUG, GLF);
@@ -128,9 +128,9 @@ void PacketHandlers::HandleCustomBlockSupportLevel(const std::shared_ptr<Network
     Client::Login(client->GetId(), concrete->GetLoginName(), concrete->MPPass, concrete->ClientVersion);
 }
 
-void PacketHandlers::HandleTwoWayPing(const std::shared_ptr<NetworkClient> &client) {
-	const unsigned char direction = client->ReceiveBuffer->ReadByte();
-	const short timeval = client->ReceiveBuffer->ReadShort();
+void PacketHandlers::HandleTwoWayPing(const std::shared_ptr<NetworkClient>& client, D3PP::network::PacketReader& reader) {
+	const unsigned char direction = reader.ReadByte();
+	const short timeval = reader.ReadShort();
 
     if (direction == 0) {
         Packets::SendTwoWayPing(client, direction, timeval);
@@ -142,16 +142,16 @@ void PacketHandlers::HandleTwoWayPing(const std::shared_ptr<NetworkClient> &clie
     client->Ping = secondsTaken;
 }
 
-void PacketHandlers::HandlePlayerClicked(const std::shared_ptr<NetworkClient> &client) {
-    unsigned char button = client->ReceiveBuffer->ReadByte();
-    unsigned char action = client->ReceiveBuffer->ReadByte();
-    const short yaw = client->ReceiveBuffer->ReadShort();
-    const short pitch = client->ReceiveBuffer->ReadShort();
-    const char targetedEntity = static_cast<char>(client->ReceiveBuffer->ReadByte());
-    const short targetBlockX = client->ReceiveBuffer->ReadShort();
-    const short targetBlockY = client->ReceiveBuffer->ReadShort();
-    const short targetBlockZ = client->ReceiveBuffer->ReadShort();
-    unsigned char targetedBlockFace = client->ReceiveBuffer->ReadByte();
+void PacketHandlers::HandlePlayerClicked(const std::shared_ptr<NetworkClient>& client, D3PP::network::PacketReader& reader) {
+    unsigned char button = reader.ReadByte();
+    unsigned char action = reader.ReadByte();
+    const short yaw = reader.ReadShort();
+    const short pitch = reader.ReadShort();
+    const char targetedEntity = static_cast<char>(reader.ReadByte());
+    const short targetBlockX = reader.ReadShort();
+    const short targetBlockY = reader.ReadShort();
+    const short targetBlockZ = reader.ReadShort();
+    unsigned char targetedBlockFace = reader.ReadByte();
 
     const auto cb = static_cast<ClickButton>(button);
     const auto ca = static_cast<ClickAction>(action);
@@ -0,0 +1,36 @@
+#include "network/PacketReader.h"
+
+#include <array>
+
+#include "Utils.h"
+
+namespace D3PP::network {
+    static constexpr std::array<short, 256> BuildInboundLengths() {
+        std::array<short, 256> lengths {};
+        lengths.fill(-1);
+        lengths[0] = 1 + 1 + 64 + 64 + 1; // -- Handshake
+        lengths[1] = 1; // -- Ping
+        lengths[5] = 9; // -- Block Change
+        lengths[8] = 10; // -- Player Movement
+        lengths[13] = 66; // -- Chat Message
+        lengths[16] = 67; // -- CPE ExtInfo
+        lengths[17] = 69; // -- CPE ExtEntry
+        lengths[19] = 2; // -- CPE Custom Block Support
+        lengths[34] = 15; // -- CPE Player Clicked
+        lengths[43] = 4; // -- CPE Two Way Ping
+        return lengths;
+    }
+
+    static constexpr std::array<short, 256> InboundLengths = BuildInboundLengths();
+
+    int InboundPacketLength(unsigned char opcode) {
+        return InboundLengths[opcode];
+    }
+
+    std::string PacketReader::ReadString() {
+        std::string result(reinterpret_cast<const char*>(m_data.data() + m_position), 64);
+        m_position += 64;
+        Utils::TrimString(result);
+        return result;
+    }
+}
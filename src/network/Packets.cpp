@@ -8,6 +8,7 @@
 #include "Utils.h"
 #include "common/ByteBuffer.h"
 #include "CPE.h"
+#include <algorithm>
 
 static std::shared_ptr<NetworkClient> GetPlayer(int id) {
     auto network = Network::GetInstance();
@@ -30,49 +31,44 @@ void Packets::SendClientHandshake(int clientId, char protocolVersion, std::strin
     }
 }
 
-void Packets::SendMapInit(int clientId) {
+void Packets::SendMapInit(int clientId, int fastMapVolume) {
     std::shared_ptr<NetworkClient> c = GetPlayer(clientId);
     if (c->canSend && c->SendBuffer != nullptr) {
-        const std::scoped_lock sLock(c->sendLock);
-        c->SendBuffer->Write(static_cast<unsigned char>(2));
-        c->SendBuffer->Purge();
+        D3PP::network::SharedPacket packet = D3PP::network::EncodedPacket::FromBytes({ 2 });
+        if (fastMapVolume >= 0) {
+            packet = D3PP::network::EncodedPacket::FromBytes({ 2,
+                static_cast<unsigned char>(fastMapVolume >> 24),
+                static_cast<unsigned char>(fastMapVolume >> 16),
+                static_cast<unsigned char>(fastMapVolume >> 8),
+                static_cast<unsigned char>(fastMapVolume & 0xFF) });
+        }
+        // -- Init and finalize fence the transfer, so nothing from the old or new map crosses them.
+        c->SendShared(packet, D3PP::network::SendLane::Bulk, -1, true);
     }
 }
 
 void Packets::SendMapData(int clientId, short chunkSize, char *data, unsigned char percentComplete) {
     std::shared_ptr<NetworkClient> c = GetPlayer(clientId);
     if (c->canSend && c->SendBuffer != nullptr) {
-        const std::scoped_lock sLock(c->sendLock);
-        c->SendBuffer->Write(static_cast<unsigned char>(3));
-        c->SendBuffer->Write(chunkSize);
-        std::vector<unsigned char> vData(data, data+1024);
-        c->SendBuffer->Write(vData, 1024);
-        c->SendBuffer->Write(percentComplete);
-        c->SendBuffer->Purge();
+        ByteBuffer buffer(nullptr);
+        buffer.Write(static_cast<unsigned char>(3));
+        buffer.Write(chunkSize);
+        buffer.Write(std::span<const unsigned char>(reinterpret_cast<unsigned char *>(data), 1024));
+        buffer.Write(percentComplete);
+        c->SendShared(D3PP::network::EncodedPacket::FromBytes(buffer.GetAllBytes()), D3PP::network::SendLane::Bulk);
     }
 }
 
 void Packets::SendMapFinalize(int clientId, short sizeX, short sizeY, short sizeZ) {
 	if (const std::shared_ptr<NetworkClient> c = GetPlayer(clientId); c->canSend && c->SendBuffer != nullptr) {
-        const std::scoped_lock sLock(c->sendLock);
-        c->SendBuffer->Write(static_cast<unsigned char>(4));
-        c->SendBuffer->Write(sizeX);
-        c->SendBuffer->Write(sizeZ);
-        c->SendBuffer->Write(sizeY);
-        c->SendBuffer->Purge();
+        c->SendShared(EncodeMapFinalize(sizeX, sizeY, sizeZ), D3PP::network::SendLane::Bulk, -1, true);
     }
 }
 
 void Packets::SendBlockChange(int clientId, short x, short y, short z, unsigned char type) {
     std::shared_ptr<NetworkClient> c = GetPlayer(clientId);
     if (c->canSend && c->SendBuffer != nullptr) {
-        const std::scoped_lock sLock(c->sendLock);
-        c->SendBuffer->Write(static_cast<unsigned char>(6));
-        c->SendBuffer->Write(x);
-        c->SendBuffer->Write(z);
-        c->SendBuffer->Write(y);
-        c->SendBuffer->Write(type);
-        c->SendBuffer->Purge();
+        c->SendShared(EncodeBlockChange(x, y, z, type), D3PP::network::SendLane::Block);
     }
 }
 
@@ -97,15 +93,8 @@ void Packets::SendSpawnEntity(int clientId, char playerId, std::string name, sho
 void Packets::SendPlayerTeleport(int clientId, char playerId, short x, short y, short z, char rotation, char look) {
     std::shared_ptr<NetworkClient> c = GetPlayer(clientId);
     if (c !=nullptr && c->canSend && c->SendBuffer != nullptr) {
-        const std::scoped_lock sLock(c->sendLock);
-        c->SendBuffer->Write(static_cast<unsigned char>(8));
-        c->SendBuffer->Write(static_cast<unsigned char>(playerId));
-        c->SendBuffer->Write(x);
-        c->SendBuffer->Write(z);
-        c->SendBuffer->Write(y);
-        c->SendBuffer->Write(static_cast<unsigned char>(rotation));
-        c->SendBuffer->Write(static_cast<unsigned char>(look));
-        c->SendBuffer->Purge();
+        // -- Only the newest position per entity matters, older unsent ones are replaced.
+        c->SendShared(EncodePlayerTeleport(playerId, x, y, z, rotation, look), D3PP::network::SendLane::Movement, static_cast<unsigned char>(playerId));
     }
 }
 
@@ -458,3 +447,86 @@ void Packets::SendChangeModel(std::shared_ptr<IMinecraftClient> client, unsigned
     concrete->SendBuffer->Write(modelName);
     concrete->SendBuffer->Purge();
 }
+
+D3PP::network::SharedPacket Packets::EncodeBlockChange(short x, short y, short z, unsigned char type) {
+    ByteBuffer buffer(nullptr);
+    buffer.Write(static_cast<unsigned char>(6));
+    buffer.Write(x);
+    buffer.Write(z);
+    buffer.Write(y);
+    buffer.Write(type);
+    return D3PP::network::EncodedPacket::FromBytes(buffer.GetAllBytes());
+}
+
+D3PP::network::SharedPacket Packets::EncodeBulkBlockUpdate(const int* indices, const unsigned char* types, int count) {
+    ByteBuffer buffer(nullptr);
+    buffer.Write(static_cast<unsigned char>(0x26));
+    buffer.Write(static_cast<unsigned char>(count - 1));
+    // -- Fixed size, unused slots are zero.
+    for (int i = 0; i < BULK_BLOCK_UPDATE_MAX; i++)
+        buffer.Write(i < count ? indices[i] : 0);
+    for (int i = 0; i < BULK_BLOCK_UPDATE_MAX; i++)
+        buffer.Write(i < count ? types[i] : static_cast<unsigned char>(0));
+    return D3PP::network::EncodedPacket::FromBytes(buffer.GetAllBytes());
+}
+
+D3PP::network::SharedPacket Packets::EncodePlayerTeleport(char playerId, short x, short y, short z, char rotation, char look) {
+    ByteBuffer buffer(nullptr);
+    buffer.Write(static_cast<unsigned char>(8));
+    buffer.Write(static_cast<unsigned char>(playerId));
+    buffer.Write(x);
+    buffer.Write(z);
+    buffer.Write(y);
+    buffer.Write(static_cast<unsigned char>(rotation));
+    buffer.Write(static_cast<unsigned char>(look));
+    return D3PP::network::EncodedPacket::FromBytes(buffer.GetAllBytes());
+}
+
+D3PP::network::SharedPacket Packets::EncodeChatMessage(std::string message, char location) {
+    ByteBuffer buffer(nullptr);
+    buffer.Write(static_cast<unsigned char>(13));
+    buffer.Write(static_cast<unsigned char>(location));
+    if (message.size() != 64) Utils::padTo(message, 64);
+    buffer.Write(std::move(message));
+    return D3PP::network::EncodedPacket::FromBytes(buffer.GetAllBytes());
+}
+
+D3PP::network::SharedPacket Packets::EncodeExtAddPlayerName(short nameId, std::string playerName, std::string listName, std::string groupName, char groupRank) {
+    ByteBuffer buffer(nullptr);
+    buffer.Write(static_cast<unsigned char>(22));
+    buffer.Write(nameId);
+    if (playerName.size() != 64) Utils::padTo(playerName, 64);
+    if (listName.size() != 64) Utils::padTo(listName, 64);
+    if (groupName.size() != 64) Utils::padTo(groupName, 64);
+    buffer.Write(playerName);
+    buffer.Write(listName);
+    buffer.Write(groupName);
+    buffer.Write(static_cast<unsigned char>(groupRank));
+    return D3PP::network::EncodedPacket::FromBytes(buffer.GetAllBytes());
+}
+
+D3PP::network::SharedPacket Packets::EncodeLevelData(const unsigned char* data, int length, int percentComplete) {
+    std::vector<unsigned char> stream;
+    stream.reserve(static_cast<size_t>(length / 1024 + 1) * 1028);
+
+    for (int offset = 0; offset < length; offset += 1024) {
+        int chunkSize = std::min(1024, length - offset);
+        stream.push_back(3);
+        stream.push_back(static_cast<unsigned char>(chunkSize >> 8));
+        stream.push_back(static_cast<unsigned char>(chunkSize));
+        stream.insert(stream.end(), data + offset, data + offset + chunkSize);
+        stream.resize(stream.size() + (1024 - chunkSize), 0);
+        stream.push_back(static_cast<unsigned char>(percentComplete >= 0 ? percentComplete : offset * 100.0 / length));
+    }
+
+    return D3PP::network::EncodedPacket::FromBytes(std::move(stream));
+}
+
+D3PP::network::SharedPacket Packets::EncodeMapFinalize(short sizeX, short sizeY, short sizeZ) {
+    ByteBuffer buffer(nullptr);
+    buffer.Write(static_cast<unsigned char>(4));
+    buffer.Write(sizeX);
+    buffer.Write(sizeZ);
+    buffer.Write(sizeY);
+    return D3PP::network::EncodedPacket::FromBytes(buffer.GetAllBytes());
+}
@@ -0,0 +1,59 @@
+#include "network/RateLimit.h"
+
+#include <algorithm>
+
+namespace D3PP::network {
+    TokenBucket::TokenBucket() : m_rate(0), m_burst(0), m_tokens(0), m_last() {
+    }
+
+    TokenBucket::TokenBucket(double rate, double burst, std::chrono::steady_clock::time_point now) : m_rate(rate), m_burst(std::max(1.0, burst)), m_tokens(m_burst), m_last(now) {
+    }
+
+    bool TokenBucket::Take(std::chrono::steady_clock::time_point now) {
+        if (m_rate <= 0)
+            return true;
+
+        m_tokens = TokensAt(now);
+        m_last = std::max(m_last, now);
+
+        if (m_tokens < 1.0)
+            return false;
+
+        m_tokens -= 1.0;
+        return true;
+    }
+
+    bool TokenBucket::Idle(std::chrono::steady_clock::time_point now) const {
+        return m_rate <= 0 || TokensAt(now) >= m_burst;
+    }
+
+    double TokenBucket::TokensAt(std::chrono::steady_clock::time_point now) const {
+        if (now <= m_last)
+            return m_tokens;
+
+        double elapsed = std::chrono::duration<double>(now - m_last).count();
+        return std::min(m_burst, m_tokens + elapsed * m_rate);
+    }
+
+    bool ConnectionLimiter::Allow(const std::string& ip, double rate, double burst, std::chrono::steady_clock::time_point now) {
+        if (rate <= 0)
+            return true;
+
+        const std::scoped_lock<std::mutex> pLock(m_lock);
+        auto it = m_buckets.find(ip);
+        if (it == m_buckets.end())
+            it = m_buckets.emplace(ip, TokenBucket(rate, burst, now)).first;
+
+        return it->second.Take(now);
+    }
+
+    void ConnectionLimiter::Prune(std::chrono::steady_clock::time_point now) {
+        const std::scoped_lock<std::mutex> pLock(m_lock);
+        std::erase_if(m_buckets, [now](const auto& entry) { return entry.second.Idle(now); });
+    }
+
+    size_t ConnectionLimiter::Tracked() {
+        const std::scoped_lock<std::mutex> pLock(m_lock);
+        return m_buckets.size();
+    }
+}
@@ -15,13 +15,16 @@
 #else
 #include "network/LinuxServerSockets.h"
 #include "network/LinuxSockets.h"
+#include "common/IoUring.h"
 #endif
 
 #include "common/Logger.h"
 #include "common/Configuration.h"
 #include "System.h"
 #include "network/NetworkClient.h"
+#include "network/NetworkShard.h"
 #include "network/IPacket.h"
+#include "network/EncodedPacket.h"
 #include "Utils.h"
 #include "CPE.h"
 #include "events/EventClientAdd.h"
@@ -31,6 +34,9 @@ std::atomic<int> D3PP::network::Server::SentIncrement = 0;
 float D3PP::network::Server::BytesSent = 0;
 float D3PP::network::Server::BytesReceived = 0;
 std::atomic<int> D3PP::network::Server::ReceivedIncrement = 0;
+std::atomic<int> D3PP::network::Server::RejectedConnections = 0;
+std::atomic<int> D3PP::network::Server::FloodKicks = 0;
+std::atomic<int> D3PP::network::Server::HandshakeTimeouts = 0;
 
 std::vector<std::shared_ptr<IMinecraftClient>> D3PP::network::Server::roClients;
 std::map<int,std::shared_ptr<IMinecraftClient>> D3PP::network::Server::m_clients;
@@ -45,13 +51,41 @@ D3PP::network::Server::Server() {
     Main = [this](){ this->MainFunc(); };
     TaskScheduler::RegisterTask("Bandwidth", *this);
     m_needsUpdate = false;
-    m_serverSocket = std::make_unique<ServerSocket>(m_port);
-    m_serverSocket->Listen();
 
-    std::thread handleThread([this]() { this->HandleClientData(); });
-    std::swap(m_handleThread, handleThread);
+    auto listenSocket = std::make_unique<ServerSocket>(m_port);
+    listenSocket->Listen();
+    m_listenSocket = listenSocket.get();
 
-    Logger::LogAdd("Server", "Network server started on port " + stringulate(this->m_port), LogType::NORMAL, GLF);
+#ifdef __linux__
+    int shardCount = Configuration::NetSettings.ReactorThreads;
+    // -- One reactor unless more are asked for.
+    if (shardCount <= 0)
+        shardCount = 1;
+#else
+    // -- select() has no cross-thread handover, Windows keeps a single reactor.
+    int shardCount = 1;
+#endif
+
+    m_shards.push_back(std::make_unique<NetworkShard>(0, std::move(listenSocket)));
+    for (int i = 1; i < shardCount; i++)
+        m_shards.push_back(std::make_unique<NetworkShard>(i, std::make_unique<ServerSocket>()));
+
+    m_shards[0]->Start([this]() { this->HandleIncomingClient(); }, [this]() {
+        if (m_needsUpdate.exchange(false))
+            RebuildRoClients();
+    });
+    for (int i = 1; i < shardCount; i++)
+        m_shards[i]->Start(nullptr, nullptr);
+
+#ifdef __linux__
+    std::string ioBackend = Configuration::NetSettings.IoBackend;
+    if (ioBackend != "epoll" && D3PP::Common::IoUring::Supported())
+        Logger::LogAdd("Server", "Using io_uring for client I/O.", LogType::NORMAL, GLF);
+    else if (ioBackend == "io_uring")
+        Logger::LogAdd("Server", "io_uring is not supported by this kernel, falling back to epoll.", LogType::WARNING, GLF);
+#endif
+
+    Logger::LogAdd("Server", "Network server started on port " + stringulate(this->m_port) + " with " + stringulate(shardCount) + " reactor thread(s)", LogType::NORMAL, GLF);
 }
 
 void D3PP::network::Server::Start() {
@@ -60,6 +94,12 @@ void D3PP::network::Server::Start() {
     }
 }
 
+void D3PP::network::Server::WakeNetwork(int shard) {
+    if (m_Instance == nullptr || shard < 0 || shard >= static_cast<int>(m_Instance->m_shards.size()))
+        return;
+
+    m_Instance->m_shards[shard]->Wake();
+}
 
 void D3PP::network::Server::Stop() {
     if (m_Instance == nullptr)
@@ -74,11 +114,12 @@ void D3PP::network::Server::MainFunc() {
     BytesSent = SentIncrement/1024.0f;
     ReceivedIncrement = 0;
     SentIncrement = 0;
+    m_connectLimiter.Prune(std::chrono::steady_clock::now());
     //Logger::LogAdd("Server", "Recv: " + stringulate(BytesReceived) + " KB/s, Sent: " + stringulate(BytesSent) + " KB/s.", DEBUG, GLF);
 }
 
 void D3PP::network::Server::Shutdown() {
-    m_serverSocket->Stop();
+    m_listenSocket->Stop();
     {
         std::shared_lock lock(roMutex);
         for (auto const &c: roClients) {
@@ -87,70 +128,68 @@ void D3PP::network::Server::Shutdown() {
     }
 
     std::this_thread::sleep_for(std::chrono::milliseconds(1000));
-    m_handleThread.join();
+    for (auto const &shard : m_shards)
+        shard->Join();
 
     TaskScheduler::UnregisterTask("Bandwidth");
 }
 
-void D3PP::network::Server::HandleClientData() {
-    while (System::IsRunning) {
-        HandleEvents();
-        {
-            std::shared_lock lock(roMutex);
-            for (auto const &c: roClients) {
-                if (c->IsDataAvailable())
-                    c->SendQueued();
-
-                c->HandleData();
-            }
-        }
-
-        std::this_thread::sleep_for(std::chrono::milliseconds(5));
-    }
-}
-
-void D3PP::network::Server::HandleEvents() {
-    auto e = m_serverSocket->CheckEvents();
+D3PP::network::NetworkShard& D3PP::network::Server::LeastLoadedShard() {
+    NetworkShard* best = m_shards[0].get();
+    size_t bestCount = best->ClientCount();
 
-    if (e.contains(ServerSocketEvent::SOCKET_EVENT_CONNECT)) {
-        HandleIncomingClient();
-    }
-    if (e.contains(ServerSocketEvent::SOCKET_EVENT_DATA)) {
-        for(auto &s : e[ServerSocketEvent::SOCKET_EVENT_DATA]) {
-            int clientId = static_cast<int>(s);
-            m_clients[clientId]->NotifyDataAvailable();
+    for (auto const &shard : m_shards) {
+        size_t count = shard->ClientCount();
+        if (count < bestCount) {
+            best = shard.get();
+            bestCount = count;
         }
     }
 
-    if (m_needsUpdate)
-        RebuildRoClients();
+    return *best;
 }
 
 void D3PP::network::Server::HandleIncomingClient() {
-    std::unique_ptr<Sockets> newClient = m_serverSocket->Accept();
-
-    if (newClient != nullptr && newClient->GetSocketFd() != -1) {
-        NetworkClient newNcClient(std::move(newClient));
-        int clientId = newNcClient.GetId();
-        RegisterClient(newNcClient);
-
-        EventClientAdd eca;
-        eca.clientId = clientId;
-        Dispatcher::post(eca);
+    std::unique_ptr<Sockets> newClient = m_listenSocket->Accept();
+
+    while (newClient != nullptr && newClient->GetSocketFd() != -1) {
+        // -- ConnectRate is per minute. Rejected sockets are just closed, before any client state exists.
+        if (m_connectLimiter.Allow(newClient->GetSocketIp(), Configuration::NetSettings.ConnectRate / 60.0, Configuration::NetSettings.ConnectBurst, std::chrono::steady_clock::now())) {
+            NetworkClient newNcClient(std::move(newClient));
+            int clientId = newNcClient.GetId();
+            RegisterClient(newNcClient, LeastLoadedShard());
+
+            EventClientAdd eca;
+            eca.clientId = clientId;
+            Dispatcher::post(eca);
+        } else {
+            RejectedConnections++;
+            newClient.reset();
+        }
+#ifdef __linux__
+        // -- Edge triggered listen socket: drain every pending connection.
+        newClient = m_listenSocket->Accept();
+#endif
     }
 }
 
-void D3PP::network::Server::RegisterClient(NetworkClient client) {
-    std::scoped_lock<std::mutex> clientLock(m_ClientMutex);
-    m_clients.insert(std::make_pair(client.GetId(), std::make_shared<NetworkClient>(client)));
-    RebuildRoClients();
+void D3PP::network::Server::RegisterClient(NetworkClient client, NetworkShard& shard) {
+    auto newClient = std::make_shared<NetworkClient>(client);
+    newClient->Shard = shard.Index();
+    {
+        std::scoped_lock<std::mutex> clientLock(m_ClientMutex);
+        m_clients.insert(std::make_pair(newClient->GetId(), newClient));
+        RebuildRoClients();
+    }
+    shard.Add(newClient, newClient->GetId());
 }
 
 void D3PP::network::Server::UnregisterClient(const std::shared_ptr<IMinecraftClient>& client) {
     EventClientDelete ecd;
     ecd.clientId = client->GetId();
     Dispatcher::post(ecd);
-    m_Instance->m_serverSocket->Unaccept(client->GetId());
+    for (auto const &shard : m_Instance->m_shards)
+        shard->Remove(client->GetId());
     m_Instance->m_needsUpdate = true;
     std::scoped_lock<std::mutex> clientLock(m_ClientMutex);
     D3PP::network::Server::m_clients.erase(client->GetId());
@@ -167,31 +206,24 @@ void D3PP::network::Server::RebuildRoClients() {
     std::swap(newRo, roClients); // -- Should happen in an instant, but I suppose edge cases could happen \_(o_o)_/
 }
 
-void D3PP::network::Server::SendToAll(IPacket& packet, std::string extension, int extVersion) {
-    std::shared_lock lock(D3PP::network::Server::roMutex);
-    for ( auto const & c : roClients ) {
-        if (!extension.empty()) {
-            int currentVer = CPE::GetClientExtVersion(c, extension);
-
-            if (extVersion == currentVer)
-                c->SendPacket(packet);
-        }
-
-        c->SendPacket(packet);
-    }
-}
-
-void D3PP::network::Server::SendAllExcept(IPacket& packet, std::shared_ptr<IMinecraftClient> toNot) {
-    std::shared_lock lock(D3PP::network::Server::roMutex);
-    for ( auto const & c : roClients ) {
+void D3PP::network::Server::SendSharedToAll(const SharedPacket& packet, const std::string& extension, int extVersion, const std::shared_ptr<IMinecraftClient>& toNot) {
+    // -- Queued right away on the same send queue direct sends use, so a client never sees a broadcast
+    // -- overtake (or fall behind) a packet sent to it before (or after) it. Shards only write them out.
+    std::shared_lock lock(roMutex);
+    for (auto const &c : roClients) {
         if (c == toNot)
             continue;
+        if (!extension.empty() && CPE::GetClientExtVersion(c, extension) != extVersion)
+            continue;
 
-        c->SendPacket(packet);
+        c->SendShared(packet);
     }
 }
 
+void D3PP::network::Server::SendToAll(IPacket& packet, std::string extension, int extVersion) {
+    SendSharedToAll(EncodedPacket::Encode(packet), extension, extVersion, nullptr);
+}
 
-
-
-
+void D3PP::network::Server::SendAllExcept(IPacket& packet, std::shared_ptr<IMinecraftClient> toNot) {
+    SendSharedToAll(EncodedPacket::Encode(packet), "", 0, toNot);
+}
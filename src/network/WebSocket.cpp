@@ -0,0 +1,249 @@
+#include "network/WebSocket.h"
+
+#include <algorithm>
+#include <cctype>
+#include <cstring>
+#include <vector>
+
+#include "digestpp/digestpp.hpp"
+#include "common/ByteBuffer.h"
+#include "Utils.h"
+
+namespace D3PP::network {
+    static const std::string WEBSOCKET_GUID = "258EAFA5-E914-47DA-95CA-C5AB0DC85B11";
+
+    static std::string Base64Encode(const unsigned char* data, size_t length) {
+        static const char alphabet[] = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+        std::string result;
+        result.reserve((length + 2) / 3 * 4);
+
+        for (size_t i = 0; i < length; i += 3) {
+            unsigned int chunk = data[i] << 16;
+            if (i + 1 < length) chunk |= data[i + 1] << 8;
+            if (i + 2 < length) chunk |= data[i + 2];
+
+            result += alphabet[(chunk >> 18) & 63];
+            result += alphabet[(chunk >> 12) & 63];
+            result += (i + 1 < length) ? alphabet[(chunk >> 6) & 63] : '=';
+            result += (i + 2 < length) ? alphabet[chunk & 63] : '=';
+        }
+
+        return result;
+    }
+
+    WebSocketCodec::WebSocketCodec() : m_open(false), m_prefixSent(0), m_frameRemaining(0) {
+    }
+
+    std::string WebSocketCodec::AcceptKey(const std::string& key) {
+        unsigned char hash[20];
+        digestpp::sha1().absorb(key + WEBSOCKET_GUID).digest(hash, sizeof(hash));
+        return Base64Encode(hash, sizeof(hash));
+    }
+
+    WebSocketStatus WebSocketCodec::Handshake(ByteBuffer& raw) {
+        std::string request(std::min(raw.Size(), WEBSOCKET_MAX_HANDSHAKE), '\0');
+        raw.Peek(std::span<unsigned char>(reinterpret_cast<unsigned char *>(request.data()), request.size()));
+
+        size_t end = request.find("\r\n\r\n");
+        if (end == std::string::npos)
+            return request.size() < static_cast<size_t>(WEBSOCKET_MAX_HANDSHAKE) ? WebSocketStatus::Ok : WebSocketStatus::Error;
+
+        if (request.rfind("GET ", 0) != 0)
+            return WebSocketStatus::Error;
+
+        std::string key;
+        std::string protocol;
+        size_t lineStart = request.find("\r\n") + 2;
+
+        while (lineStart < end) {
+            size_t lineEnd = request.find("\r\n", lineStart);
+            std::string line = request.substr(lineStart, lineEnd - lineStart);
+            lineStart = lineEnd + 2;
+
+            size_t colon = line.find(':');
+            if (colon == std::string::npos)
+                continue;
+
+            std::string name = line.substr(0, colon);
+            std::string value = line.substr(colon + 1);
+            std::transform(name.begin(), name.end(), name.begin(), [](unsigned char c) { return std::tolower(c); });
+            Utils::TrimString(value);
+
+            if (name == "sec-websocket-key")
+                key = value;
+            else if (name == "sec-websocket-protocol")
+                protocol = value.substr(0, value.find(','));
+        }
+
+        if (key.empty())
+            return WebSocketStatus::Error;
+
+        // -- Browsers reject the upgrade unless the subprotocol they offered (ClassiCube's is "ClassiCube") is echoed.
+        Utils::TrimString(protocol);
+        m_prefix = "HTTP/1.1 101 Switching Protocols\r\nUpgrade: websocket\r\nConnection: Upgrade\r\nSec-WebSocket-Accept: " + AcceptKey(key) + "\r\n";
+        if (!protocol.empty())
+            m_prefix += "Sec-WebSocket-Protocol: " + protocol + "\r\n";
+        m_prefix += "\r\n";
+        m_prefixSent = 0;
+
+        raw.Shift(static_cast<int>(end + 4));
+        m_open = true;
+        return WebSocketStatus::Ok;
+    }
+
+    WebSocketStatus WebSocketCodec::Decode(ByteBuffer& raw, ByteBuffer& payload) {
+        if (!m_open) {
+            WebSocketStatus status = Handshake(raw);
+            if (status != WebSocketStatus::Ok || !m_open)
+                return status;
+        }
+
+        unsigned char header[14];
+        while (raw.Size() >= 2) {
+            int available = raw.Peek(std::span<unsigned char>(header, std::min(raw.Size(), 14)));
+            unsigned char opcode = header[0] & 0x0F;
+            bool masked = (header[1] & 0x80) != 0;
+            uint64_t length = header[1] & 0x7F;
+            int headerLength = 2;
+
+            // -- Clients have to mask everything they send.
+            if (!masked)
+                return WebSocketStatus::Error;
+
+            if (length == 126) {
+                headerLength += 2;
+                if (available < headerLength)
+                    break;
+                length = (header[2] << 8) | header[3];
+            } else if (length == 127) {
+                headerLength += 8;
+                if (available < headerLength)
+                    break;
+                length = 0;
+                for (int i = 2; i < 10; i++)
+                    length = (length << 8) | header[i];
+            }
+
+            if (length > WEBSOCKET_MAX_FRAME)
+                return WebSocketStatus::Error;
+
+            headerLength += 4;
+            if (available < headerLength || raw.Size() < headerLength + static_cast<int>(length))
+                break;
+
+            std::array<unsigned char, 4> mask { header[headerLength - 4], header[headerLength - 3], header[headerLength - 2], header[headerLength - 1] };
+            raw.Shift(headerLength);
+
+            switch (opcode) {
+                case 0: // -- Continuation
+                case 1: // -- Text
+                case 2: { // -- Binary
+                    // -- Unmasked in place in the payload ring, no per-frame buffer.
+                    size_t done = 0;
+                    while (done < length) {
+                        auto target = payload.WritableSpan(static_cast<int>(std::min<uint64_t>(length - done, 4096)));
+                        auto chunk = target.first(std::min<size_t>(target.size(), length - done));
+                        raw.Peek(chunk);
+                        raw.Shift(static_cast<int>(chunk.size()));
+                        Unmask(chunk, mask, done);
+                        payload.CommitWrite(static_cast<int>(chunk.size()));
+                        done += chunk.size();
+                    }
+                    break;
+                }
+                case 8: // -- Close
+                    return WebSocketStatus::Closed;
+                case 9: // -- Ping, browsers never send these on their own.
+                case 10: // -- Pong
+                    raw.Shift(static_cast<int>(length));
+                    break;
+                default:
+                    return WebSocketStatus::Error;
+            }
+        }
+
+        return WebSocketStatus::Ok;
+    }
+
+    void WebSocketCodec::Unmask(std::span<unsigned char> data, const std::array<unsigned char, 4>& mask, size_t offset) {
+        // -- Rotate the key so it lines up with data[0], then XOR eight bytes at a time.
+        unsigned char key[8];
+        for (int i = 0; i < 8; i++)
+            key[i] = mask[(offset + i) & 3];
+
+        uint64_t wideKey;
+        memcpy(&wideKey, key, sizeof(wideKey));
+
+        size_t i = 0;
+        for (; i + 8 <= data.size(); i += 8) {
+            uint64_t chunk;
+            memcpy(&chunk, data.data() + i, sizeof(chunk));
+            chunk ^= wideKey;
+            memcpy(data.data() + i, &chunk, sizeof(chunk));
+        }
+
+        for (; i < data.size(); i++)
+            data[i] ^= key[i & 7];
+    }
+
+    int WebSocketCodec::EncodeHeader(size_t payloadLength, unsigned char* header) {
+        header[0] = 0x82; // -- FIN, binary.
+
+        if (payloadLength < 126) {
+            header[1] = static_cast<unsigned char>(payloadLength);
+            return 2;
+        }
+
+        if (payloadLength <= 0xFFFF) {
+            header[1] = 126;
+            header[2] = static_cast<unsigned char>(payloadLength >> 8);
+            header[3] = static_cast<unsigned char>(payloadLength);
+            return 4;
+        }
+
+        header[1] = 127;
+        for (int i = 0; i < 8; i++)
+            header[2 + i] = static_cast<unsigned char>(static_cast<uint64_t>(payloadLength) >> (56 - i * 8));
+        return WEBSOCKET_MAX_HEADER;
+    }
+
+    int WebSocketCodec::Frame(std::span<const unsigned char>* slices, int count, size_t& total) {
+        if (!Pending()) {
+            if (total == 0)
+                return 0;
+
+            unsigned char header[WEBSOCKET_MAX_HEADER];
+            m_prefix.assign(reinterpret_cast<const char *>(header), EncodeHeader(total, header));
+            m_prefixSent = 0;
+            m_frameRemaining = total;
+        }
+
+        // -- The frame may have been sized by an earlier, partly sent gather; don't run past it.
+        size_t payloadBytes = 0;
+        int kept = 0;
+        while (kept < count && payloadBytes < m_frameRemaining) {
+            if (slices[kept].size() > m_frameRemaining - payloadBytes)
+                slices[kept] = slices[kept].first(m_frameRemaining - payloadBytes);
+            payloadBytes += slices[kept].size();
+            kept++;
+        }
+
+        total = payloadBytes;
+        if (m_prefixSent < m_prefix.size()) {
+            std::move_backward(slices, slices + kept, slices + kept + 1);
+            slices[0] = std::span<const unsigned char>(reinterpret_cast<const unsigned char *>(m_prefix.data()) + m_prefixSent, m_prefix.size() - m_prefixSent);
+            total += slices[0].size();
+            kept++;
+        }
+
+        return kept;
+    }
+
+    size_t WebSocketCodec::Consume(size_t sent) {
+        size_t prefixPart = std::min(sent, m_prefix.size() - m_prefixSent);
+        m_prefixSent += prefixPart;
+        sent -= prefixPart;
+        m_frameRemaining -= sent;
+        return sent;
+    }
+}
@@ -95,7 +95,7 @@ std::unique_ptr<Sockets> ServerSocket::Accept() {
     return std::make_unique<Sockets>(newSocket, inet_ntoa(address.sin_addr));
 }
 
-std::map<ServerSocketEvent, std::vector<SOCKET>> ServerSocket::CheckEvents() {
+std::map<ServerSocketEvent, std::vector<SOCKET>> ServerSocket::CheckEvents(int timeoutMs) {
     if (!hasInit)
         return std::map<ServerSocketEvent, std::vector<SOCKET>> { std::make_pair(SOCKET_EVENT_NONE, std::vector<SOCKET>())};
 
@@ -108,6 +108,7 @@ std::map<ServerSocketEvent, std::vector<SOCKET>> ServerSocket::CheckEvents() {
         }
     }
 
+    // -- select() has no wakeup here, so queued sends are picked up by the caller's own poll interval.
     struct timeval time = {0, 5};
     int activity = select(0, &readfds, NULL, NULL, &time);
 
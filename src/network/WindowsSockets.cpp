@@ -84,6 +84,27 @@ int Sockets::Send(char* data, int size) {
     return bytesSend;
 }
 
+int Sockets::SendVectored(const std::span<const unsigned char>* slices, int count, bool zeroCopy) {
+    WSABUF buffers[SOCKET_MAX_SLICES];
+    int used = count < SOCKET_MAX_SLICES ? count : SOCKET_MAX_SLICES;
+
+    for (int i = 0; i < used; i++) {
+        buffers[i].buf = reinterpret_cast<char*>(const_cast<unsigned char*>(slices[i].data()));
+        buffers[i].len = static_cast<ULONG>(slices[i].size());
+    }
+
+    DWORD bytesSent = 0;
+    if (WSASend(socketfd, buffers, used, &bytesSent, 0, nullptr, nullptr) == SOCKET_ERROR) {
+        if (WSAGetLastError() == WSAEWOULDBLOCK)
+            return SOCKET_WOULD_BLOCK;
+
+        connected = false;
+        return -1;
+    }
+
+    return static_cast<int>(bytesSent);
+}
+
 Sockets::~Sockets()
 {
     Disconnect();
@@ -187,7 +187,7 @@ void RestApi::Init() {
             json ji;
             ji["id"] = m.first;
             ji["name"] = m.second->Name();
-            ji["loaded"] = m.second->loaded;
+            ji["loaded"] = m.second->loaded.load();
             ji["numClients"] = m.second->Clients;
             items.push_back(ji);
         }
@@ -246,6 +246,15 @@ void RestApi::Init() {
         res.set_content(stringulate(j), "application/json");
     });
 
+    m_restServer->Get("/network/flood",[](const httplib::Request& req, httplib::Response& res) {
+        json j;
+        j["rejectedConnections"] = D3PP::network::Server::RejectedConnections.load();
+        j["floodKicks"] = D3PP::network::Server::FloodKicks.load();
+        j["handshakeTimeouts"] = D3PP::network::Server::HandshakeTimeouts.load();
+        res.set_header("Access-Control-Allow-Origin", "http://localhost:3000");
+        res.set_content(stringulate(j), "application/json");
+    });
+
     m_restServer->Get("/plugins/",[](const httplib::Request& req, httplib::Response& res) {});
     m_restServer->Get("/playerdb",[](const httplib::Request& req, httplib::Response& res) {});
     m_restServer->Get("/system/log",[](const httplib::Request& req, httplib::Response& res) {
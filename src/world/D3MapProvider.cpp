@@ -3,6 +3,9 @@
 //
 
 #include "world/D3MapProvider.h"
+
+#include <algorithm>
+
 #include "world/Teleporter.h"
 #include "world/CustomParticle.h"
 
@@ -32,6 +35,25 @@ bool D3PP::world::D3MapProvider::Save(const std::string &filePath) {
     return m_d3map->Save(filePath);
 }
 
+bool D3PP::world::D3MapProvider::SaveWithoutBlocks() {
+    return m_d3map->SaveWithoutBlocks();
+}
+
+bool D3PP::world::D3MapProvider::SupportsConcurrentSave() {
+    // -- Only the D3 block layer is copy-on-write; providers keeping their own block storage save in place.
+    return m_d3map != nullptr && !m_d3map->ExternalBlockLayer;
+}
+
+bool D3PP::world::D3MapProvider::UseChunkedBlockLayer() {
+    if (m_d3map == nullptr || m_d3map->ExternalBlockLayer)
+        return false;
+
+    if (!m_d3map->ChunkedFormat)
+        m_d3map->ConvertBlockLayer(true);
+
+    return true;
+}
+
 bool D3PP::world::D3MapProvider::Load(const std::string &filePath) {
     if (m_d3map == nullptr) {
         m_d3map = std::make_unique<files::D3Map>(filePath);
@@ -62,11 +84,25 @@ void D3PP::world::D3MapProvider::SetSize(const D3PP::Common::Vector3S &newSize)
 }
 
 bool D3PP::world::D3MapProvider::Unload() {
-    m_d3map->MapData.resize(1);
+    m_d3map->ClearBlocks();
     return true;
 }
 
+int64_t D3PP::world::D3MapProvider::Compact() {
+    if (m_d3map == nullptr)
+        return -1;
+
+    return m_d3map->CompactBlocks();
+}
+
+bool D3PP::world::D3MapProvider::Expand() {
+    return m_d3map != nullptr && m_d3map->IsCompacted() && m_d3map->ExpandBlocks();
+}
+
 bool D3PP::world::D3MapProvider::Reload() {
+    if (Expand())
+        return true;
+
     return Load("");
 }
 
@@ -79,12 +115,19 @@ unsigned char D3PP::world::D3MapProvider::GetBlock(const D3PP::Common::Vector3S&
 }
 
 void D3PP::world::D3MapProvider::SetBlocks(const std::vector<unsigned char> &blocks) {
-    m_d3map->MapData.clear();
-    std::copy(blocks.begin(), blocks.end(), std::back_inserter(m_d3map->MapData));
+    m_d3map->SetBlocks(blocks);
 }
 
 std::vector<unsigned char> D3PP::world::D3MapProvider::GetBlocks() {
-    return std::vector<unsigned char>(m_d3map->MapData);
+    return std::vector<unsigned char>(m_d3map->BlockTypes);
+}
+
+bool D3PP::world::D3MapProvider::ReadBlocks(int64_t offset, unsigned char* output, int64_t count) {
+    if (offset < 0 || count < 0 || offset + count > static_cast<int64_t>(m_d3map->BlockTypes.size()))
+        return false;
+
+    std::copy_n(m_d3map->BlockTypes.begin() + offset, count, output);
+    return true;
 }
 
 MinecraftLocation D3PP::world::D3MapProvider::GetSpawn() {
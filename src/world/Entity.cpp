@@ -353,8 +353,8 @@ void Entity::PositionCheck() {
 
     // -- check if the block we're touching is a killing block, if so call kill.
     for (int i = 0; i < 2; i++) {
-        unsigned char blockType = theMap->GetBlockType(blockLocation.X, blockLocation.Y, blockLocation.Z+i);
-        if (bm->GetBlock(blockType).Kills)
+        int blockType = theMap->GetBlockType(blockLocation.X, blockLocation.Y, blockLocation.Z+i);
+        if (blockType != MAP_BLOCK_NOT_LOADED && bm->GetBlock(blockType).Kills)
             Kill();
     }
 }
@@ -4,6 +4,7 @@
 
 #include "world/Map.h"
 
+#include <algorithm>
 #include <utility>
 #include <world/D3MapProvider.h>
 
@@ -30,6 +31,7 @@
 #include "events/EventMapBlockChangeClient.h"
 #include "world/Teleporter.h"
 #include "world/MapMain.h"
+#include "world/MapSendStream.h"
 #include "world/CustomParticle.h"
 
 using namespace D3PP::world;
@@ -38,6 +40,11 @@ using namespace D3PP::files;
 
 const std::string MODULE_NAME = "Map";
 
+static bool SamePath(const std::string& first, const std::string& second) {
+    std::error_code ec;
+    return std::filesystem::equivalent(first, second, ec) || std::filesystem::path(first).lexically_normal() == std::filesystem::path(second).lexically_normal();
+}
+
 bool Map::Resize(short x, short y, short z) {
     if (!loaded) {
         Reload();
@@ -47,12 +54,23 @@ bool Map::Resize(short x, short y, short z) {
     }
 
     loading = true;
-    m_mapProvider->SetSize(Vector3S{x, y, z});
+    {
+        std::scoped_lock<std::mutex> saveLock(m_saveLock);
+        {
+            std::unique_lock<std::shared_mutex> layerLock(m_layerLock);
+            m_mapProvider->SetSize(Vector3S{x, y, z});
+            m_layerGeneration++;
+        }
+        m_blockGeneration++;
+        m_snapshotRequired = true;
+        if (m_journal != nullptr)
+            m_journal->AppendBarrier();
+    }
     bcQueue.reset();
     pQueue.reset();
     pQueue = std::make_unique<PhysicsQueue>(GetSize());
     bcQueue = std::make_unique<BlockChangeQueue>(GetSize());
-    loading = false;
+    FinishLoading();
     Resend();
     return true;
 }
@@ -71,12 +89,12 @@ void Map::Fill(const std::string& functionName, const std::string& paramString)
     bcQueue->Clear();
     pQueue->Clear();
     Vector3S mapSize = m_mapProvider->GetSize();
-    int mapSizeInt = (mapSize.X * mapSize.Y * mapSize.Z)*4;
+    int mapSizeInt = (mapSize.X * mapSize.Y * mapSize.Z) * MAP_BLOCK_ELEMENT_SIZE;
     clock_t start = clock();
     std::vector<unsigned char> blankMap;
     blankMap.resize(mapSizeInt);
 
-    m_mapProvider->SetBlocks(blankMap);
+    SetBlocks(blankMap);
 
     D3PP::plugins::PluginManager *pm = D3PP::plugins::PluginManager::GetInstance();
     pm->TriggerMapFill(ID, mapSize.X, mapSize.Y, mapSize.Z, "Mapfill_" + functionName, std::move(paramString));
@@ -84,76 +102,305 @@ void Map::Fill(const std::string& functionName, const std::string& paramString)
     Logger::LogAdd(MODULE_NAME, "Map '" + m_mapProvider->MapName + "' filled.", LogType::NORMAL, GLF);
 }
 
+void Map::SetBlocks(const std::vector<unsigned char>& blocks) {
+    std::scoped_lock<std::mutex> saveLock(m_saveLock);
+    {
+        std::unique_lock<std::shared_mutex> layerLock(m_layerLock);
+        m_mapProvider->SetBlocks(blocks);
+        m_layerGeneration++;
+    }
+    m_blockGeneration++;
+    m_snapshotRequired = true;
+    if (m_journal != nullptr)
+        m_journal->AppendBarrier();
+}
+
 bool Map::Save(const std::string& directory) {
+    std::scoped_lock<std::mutex> saveLock(m_saveLock);
+    m_snapshotQueued = false;
     if (!this->loaded)
         return true;
 
-    return m_mapProvider->Save(directory);
+    // -- While the journal is small, persisting it is enough; the block layer is only rewritten once it grows.
+    if (directory.empty() && m_journal != nullptr && !m_snapshotRequired && m_journal->Size() < JournalSnapshotSize) {
+        bool result = m_mapProvider->SaveWithoutBlocks();
+        return m_journal->Sync() && result;
+    }
+
+    int64_t journalMark = (m_journal != nullptr) ? m_journal->Size() : 0;
+    bool result = m_mapProvider->Save(directory);
+
+    if (result && directory.empty() && m_journal != nullptr) {
+        m_journal->Truncate(journalMark);
+        m_snapshotRequired = false;
+    }
+
+    return result;
 }
 
-void Map::Load(const std::string& directory) {
-    loading = true;
+bool Map::ConvertToChunked() {
+    if (!loaded) {
+        Reload();
+        if (!loaded)
+            return false;
+    }
 
-    if (m_mapProvider == nullptr && !directory.empty()) {
-        m_mapProvider = std::make_unique<D3MapProvider>();
-    } else if (m_mapProvider == nullptr) {
-        Logger::LogAdd(MODULE_NAME, "Map Reloaded [" + m_mapProvider->MapName + "]", LogType::NORMAL, GLF);
+    {
+        std::scoped_lock<std::mutex> saveLock(m_saveLock);
+        std::unique_lock<std::shared_mutex> layerLock(m_layerLock);
+        if (!m_mapProvider->UseChunkedBlockLayer())
+            return false;
+        m_layerGeneration++;
+        m_snapshotRequired = true;
     }
 
-    bool result = m_mapProvider->Load(directory);
+    return Save("");
+}
 
-    if (!result) {
-        Logger::LogAdd(MODULE_NAME, "Error loading map! [" + m_mapProvider->MapName + "]", L_ERROR, GLF);
-        loading = false;
+void Map::ReplayJournal() {
+    if (m_journal == nullptr)
         return;
+
+    int replayed = m_journal->Replay([this](const files::BlockJournalEntry& entry) {
+        m_mapProvider->SetBlock(entry.Location, entry.Type);
+        m_mapProvider->SetLastPlayer(entry.Location, entry.Player);
+    });
+
+    if (replayed > 0)
+        Logger::LogAdd(MODULE_NAME, "Replayed " + stringulate(replayed) + " journaled block changes [" + m_mapProvider->MapName + "]", LogType::NORMAL, GLF);
+}
+
+void Map::Load(const std::string& directory) {
+    {
+        std::scoped_lock<std::mutex> saveLock(m_saveLock);
+        loading = true;
+
+        if (m_mapProvider == nullptr && !directory.empty()) {
+            m_mapProvider = MapMain::CreateProvider(ProviderType);
+        } else if (m_mapProvider == nullptr) {
+            Logger::LogAdd(MODULE_NAME, "Map Reloaded [" + m_mapProvider->MapName + "]", LogType::NORMAL, GLF);
+        }
+
+        std::unique_lock<std::shared_mutex> layerLock(m_layerLock);
+        bool result = m_mapProvider->Load(directory);
+        m_layerGeneration++;
+
+        if (!result) {
+            Logger::LogAdd(MODULE_NAME, "Error loading map! [" + m_mapProvider->MapName + "]", L_ERROR, GLF);
+            loading = false;
+            return;
+        }
+
+        if (pQueue != nullptr) {
+            pQueue.reset();
+        }
+        if (bcQueue != nullptr) {
+            bcQueue.reset();
+        }
+
+        // -- The journal belongs to the map's own folder, next to the snapshots it is replayed over.
+        if (JournalSnapshotSize > 0)
+            m_journal = std::make_unique<files::BlockJournal>(filePath);
+        else
+            m_journal.reset();
+
+        m_snapshotRequired = false;
+        if (directory.empty() || SamePath(directory, filePath)) {
+            ReplayJournal();
+        } else if (m_journal != nullptr) {
+            // -- Blocks loaded from elsewhere replace the layer the journal was written against.
+            m_journal->Truncate(m_journal->Size());
+            m_snapshotRequired = true;
+        }
+        m_blockGeneration++;
+
+        pQueue = std::make_unique<PhysicsQueue>(GetSize());
+        bcQueue = std::make_unique<BlockChangeQueue>(GetSize());
+        Particles = m_mapProvider->getParticles();
+        Portals = m_mapProvider->getPortals();
+        loaded = true;
+    }
+
+    FinishLoading();
+}
+
+void Map::Reload() {
+    bool wasWarm;
+    {
+        std::scoped_lock<std::mutex> saveLock(m_saveLock);
+        if (loaded)
+            return;
+
+        loading = true;
+        wasWarm = m_warmSize > 0 && m_mapProvider->Expand();
+        bool result = wasWarm || m_mapProvider->Reload();
+        m_warmSize = 0;
+
+        if (!result) {
+            Logger::LogAdd(MODULE_NAME, "Failed to reload map! [" + m_mapProvider->MapName + "]", LogType::L_ERROR, GLF);
+            loading = false;
+            return;
+        }
+
+        // -- The warm copy was taken after every journaled change, replaying over it would only bring back older blocks.
+        if (!wasWarm)
+            ReplayJournal();
+        m_blockGeneration++;
+
+        loaded = true;
+        BlockchangeStopped = false;
+        PhysicsStopped = false;
     }
 
-    if (pQueue != nullptr) {
-        pQueue.reset();
+    // -- Outside the save lock, so queued callbacks are free to save or resize the map.
+    FinishLoading();
+    Logger::LogAdd(MODULE_NAME, std::string(wasWarm ? "Map Reloaded from warm tier [" : "Map Reloaded [") + m_mapProvider->MapName + "]", LogType::NORMAL, GLF);
+}
+
+std::shared_future<bool> Map::RequestLoad(const std::string& directory) {
+    std::scoped_lock<std::mutex> loadLock(m_loadLock);
+
+    if (m_pendingLoad.valid() && directory.empty())
+        return m_pendingLoad;
+
+    if (m_pendingLoad.valid()) {
+        // -- Loading from a directory replaces whatever the pending load brings in, so it runs right after it.
+        // -- Later requests before it starts only change the directory.
+        m_queuedDirectory = directory;
+        if (m_queuedLoad == nullptr) {
+            m_queuedLoad = std::make_shared<std::promise<bool>>();
+            m_queuedLoadResult = m_queuedLoad->get_future().share();
+        }
+        return m_queuedLoadResult;
     }
-    if (bcQueue != nullptr) {
-        bcQueue.reset();
+
+    if (loaded && directory.empty()) {
+        std::promise<bool> done;
+        done.set_value(true);
+        return done.get_future().share();
     }
 
-    pQueue = std::make_unique<PhysicsQueue>(GetSize());
-    bcQueue = std::make_unique<BlockChangeQueue>(GetSize());
-    Particles = m_mapProvider->getParticles();
-    Portals = m_mapProvider->getPortals();
-    loading = false;
-    loaded = true;
+    StartLoad(directory, std::make_shared<std::promise<bool>>());
+    return m_pendingLoad;
 }
 
-void Map::Reload() {
-    if (loaded)
-        return;
+void Map::StartLoad(const std::string& directory, const std::shared_ptr<std::promise<bool>>& promise) {
+    LastClient = time(nullptr);
+    m_pendingLoad = promise->get_future().share();
+    std::shared_ptr<Map> self = shared_from_this();
+
+    MapMain::GetInstance()->QueueLoadTask([self, promise, directory]() {
+        if (directory.empty())
+            self->Reload();
+        else
+            self->Load(directory);
+
+        std::shared_ptr<std::promise<bool>> next;
+        std::string nextDirectory;
+        {
+            // -- A queued load stays pending from here on, so no other load can start in between.
+            std::scoped_lock<std::mutex> loadLock(self->m_loadLock);
+            self->m_pendingLoad = self->m_queuedLoadResult;
+            std::swap(next, self->m_queuedLoad);
+            std::swap(nextDirectory, self->m_queuedDirectory);
+            self->m_queuedLoadResult = std::shared_future<bool>();
+        }
 
-    loading = true;
-    bool result = m_mapProvider->Reload();
-    
-    if (!result) {
-        Logger::LogAdd(MODULE_NAME, "Failed to reload map! [" + m_mapProvider->MapName + "]", LogType::L_ERROR, GLF);
+        if (!self->loaded)
+            self->FinishLoading(false);
+
+        promise->set_value(self->loaded);
+
+        if (next != nullptr) {
+            std::scoped_lock<std::mutex> loadLock(self->m_loadLock);
+            self->StartLoad(nextDirectory, next);
+        }
+    });
+}
+
+void Map::WhenLoaded(const std::function<void(bool)>& callback) {
+    bool runNow;
+    {
+        std::scoped_lock<std::mutex> loadLock(m_loadLock);
+        runNow = loaded && !loading;
+        if (!runNow)
+            m_loadCallbacks.push_back(callback);
+    }
+
+    if (runNow)
+        callback(true);
+    else if (!loaded)
+        RequestLoad();
+}
+
+void Map::FinishLoading(bool result) {
+    std::vector<std::function<void(bool)>> callbacks;
+    {
+        std::scoped_lock<std::mutex> loadLock(m_loadLock);
         loading = false;
-        return;
+        std::swap(callbacks, m_loadCallbacks);
     }
 
-    loading = false;
-    loaded = true;
-    BlockchangeStopped = false;
-    PhysicsStopped = false;
-    Logger::LogAdd(MODULE_NAME, "Map Reloaded [" + m_mapProvider->MapName + "]", LogType::NORMAL, GLF);
+    for (auto& callback : callbacks)
+        callback(result);
 }
 
-void Map::Unload() {
-    if (!loaded)
+void Map::Unload(bool keepWarm) {
+    // -- Runs on the scheduler, which must not wait out a save; a map being saved is unloaded on a later tick.
+    std::unique_lock<std::mutex> saveLock(m_saveLock, std::try_to_lock);
+    if (!saveLock.owns_lock() || !loaded)
+        return;
+
+    // -- A block layer replaced since the last snapshot exists nowhere else; it is saved first and unloaded on a later tick.
+    if (m_snapshotRequired && m_journal != nullptr) {
+        saveLock.unlock();
+        if (!m_snapshotQueued.exchange(true))
+            MapMain::GetInstance()->AddSaveAction(0, ID, "");
         return;
+    }
 
     BlockchangeStopped = true;
     PhysicsStopped = true;
-    loaded = false;
+    {
+        // -- Waits out streams still copying; from here on they see the map unloaded and leave the storage alone.
+        std::unique_lock<std::shared_mutex> layerLock(m_layerLock);
+        loaded = false;
+        m_layerGeneration++;
+    }
+    if (m_journal != nullptr)
+        m_journal->Sync();
+
+    {
+        std::scoped_lock<std::mutex> cacheLock(m_sendCacheLock);
+        m_sendCache.clear();
+        m_sendLayers.clear();
+    }
+
+    m_warmSize = keepWarm ? m_mapProvider->Compact() : -1;
+    if (m_warmSize >= 0) {
+        Logger::LogAdd(MODULE_NAME, "Map unloaded to warm tier (" + m_mapProvider->MapName + ", " + stringulate(m_warmSize / 1024) + " KiB)", LogType::NORMAL, GLF);
+        return;
+    }
+
+    m_warmSize = 0;
     m_mapProvider->Unload();
     Logger::LogAdd(MODULE_NAME, "Map unloaded (" + m_mapProvider->MapName + ")", LogType::NORMAL, GLF);
 }
 
+bool Map::EvictWarm() {
+    std::unique_lock<std::mutex> saveLock(m_saveLock, std::try_to_lock);
+    if (!saveLock.owns_lock())
+        return false;
+
+    if (loaded || m_warmSize == 0)
+        return true;
+
+    m_warmSize = 0;
+    m_mapProvider->Unload();
+    Logger::LogAdd(MODULE_NAME, "Map evicted from warm tier (" + m_mapProvider->MapName + ")", LogType::NORMAL, GLF);
+    return true;
+}
+
 void Map::Send(int clientId) {
     Network* nMain = Network::GetInstance();
     Block* bMain = Block::GetInstance();
@@ -163,86 +410,146 @@ void Map::Send(int clientId) {
         return;
 
     if (!loaded) {
-        Reload();
-        if (!loaded) {
+        // -- Sent from the action queue once the load pool has the map ready.
+        std::shared_ptr<Map> self = shared_from_this();
+        WhenLoaded([self, clientId](bool result) {
+            if (result) {
+                self->m_actions.AddTask([self, clientId]() { self->Send(clientId); });
+                return;
+            }
+
             Logger::LogAdd(MODULE_NAME, "Can't send the map: Reload error", LogType::L_ERROR, GLF);
-            nc->Kick("Mapsend error", false);
-            return;
-        }
+            std::shared_ptr<IMinecraftClient> client = Network::GetInstance()->GetClient(clientId);
+            if (client != nullptr)
+                client->Kick("Mapsend error", false);
+        });
+        return;
     }
 
-    Vector3S mapSize = m_mapProvider->GetSize();
-    int mapVolume = mapSize.X * mapSize.Y * mapSize.Z;
-    
-    std::vector<unsigned char> tempBuf(mapVolume + 10);
-    int tempBufferOffset = 0;
-
-    tempBuf.at(tempBufferOffset++) = static_cast<unsigned char>(mapVolume >> 24);
-    tempBuf.at(tempBufferOffset++) = static_cast<unsigned char>(mapVolume >> 16);
-    tempBuf.at(tempBufferOffset++) = static_cast<unsigned char>(mapVolume >> 8);
-    tempBuf.at(tempBufferOffset++) = static_cast<unsigned char>(mapVolume & 0xFF);
-
+    uint64_t layer;
+    Vector3S mapSize;
+    {
+        std::shared_lock<std::shared_mutex> layerLock(m_layerLock);
+        layer = m_layerGeneration;
+        mapSize = m_mapProvider->GetSize();
+    }
+    {
+        std::scoped_lock<std::mutex> cacheLock(m_sendCacheLock);
+        m_sendLayers[clientId] = layer;
+    }
     int cbl = nc->GetCustomBlocksLevel();
     int dbl = CPE::GetClientExtVersion(nc, BLOCK_DEFS_EXT_NAME);
-    std::vector<unsigned char> mapBlocks = m_mapProvider->GetBlocks();
-    
-    if (mapBlocks.size() != (mapVolume * 4)) {
-        Logger::LogAdd("Map", "Error during mapsend: Size mismatch!!", LogType::L_ERROR, GLF);
-        nc->SendChat("Error during mapsend!!");
-        return;
-    }
+    bool fastMap = CPE::GetClientExtVersion(nc, FAST_MAP_EXT_NAME) == 1;
 
-    for (int i = 0; i < mapVolume; i++) {
-        int index = i * MAP_BLOCK_ELEMENT_SIZE;
-        unsigned char blockAt = mapBlocks[index];
-        if (blockAt < 49) { // -- If its an original block, Dont bother checking. Just speed past.
-            tempBuf[tempBufferOffset++] = blockAt;
+    // -- What each block id becomes for this client. Clients with the same table and format get the same level stream.
+    std::array<unsigned char, 256> translation {};
+    for (int id = 0; id < 256; id++) {
+        if (id < 49) { // -- If its an original block, Dont bother checking.
+            translation[id] = static_cast<unsigned char>(id);
             continue;
         }
-        if (blockAt > 65 && dbl < 1) { // -- If the user doesn't support customblocks and this is a custom block, replace with stone.
-            tempBuf[tempBufferOffset++] = 1;
+        if (id > 65 && dbl < 1) { // -- If the user doesn't support customblocks and this is a custom block, replace with stone.
+            translation[id] = 1;
             continue;
         }
 
-        MapBlock mb = bMain->GetBlock(blockAt);
+        MapBlock mb = bMain->GetBlock(id);
+        translation[id] = static_cast<unsigned char>(mb.CpeLevel > cbl ? mb.CpeReplace : mb.OnClient);
+    }
 
-        if (mb.CpeLevel > cbl)
-            tempBuf[tempBufferOffset++] = static_cast<char>(mb.CpeReplace);
-        else     
-            tempBuf[tempBufferOffset++] = static_cast<char>(mb.OnClient);
+    uint64_t generation = m_blockGeneration;
+    std::vector<D3PP::network::SharedPacket> levelData;
+    {
+        std::scoped_lock<std::mutex> cacheLock(m_sendCacheLock);
+        for (auto const &entry : m_sendCache) {
+            if (entry.Generation == generation && entry.FastMap == fastMap && entry.Translation == translation) {
+                levelData = entry.LevelData;
+                break;
+            }
+        }
     }
 
-    mapBlocks.clear();
+    std::shared_ptr<Map> self = shared_from_this();
+    auto finished = [self, clientId, layer, generation, translation, fastMap](MapSendStream& stream, bool complete) {
+        bool latest;
+        {
+            std::scoped_lock<std::mutex> cacheLock(self->m_sendCacheLock);
+            auto sent = self->m_sendLayers.find(clientId);
+            latest = sent != self->m_sendLayers.end() && sent->second == layer;
+            if (latest)
+                self->m_sendLayers.erase(sent);
+        }
+
+        if (!complete && self->m_layerGeneration != layer) {
+            // -- The block storage was replaced under the stream, the client gets the new one unless a newer send already went out.
+            std::shared_ptr<IMinecraftClient> client = Network::GetInstance()->GetClient(clientId);
+            if (latest && client != nullptr && client->GetMapId() == self->ID)
+                self->m_actions.AddTask([self, clientId]() { self->Send(clientId); });
+            return;
+        }
 
-    int tempBuffer2Size = GZIP::GZip_CompressBound(tempBufferOffset) + 1024 + 512;
-    std::vector<unsigned char> tempBuf2(tempBuffer2Size);
+        if (!complete) {
+            Logger::LogAdd(MODULE_NAME, "Can't send the map: Read error", LogType::L_ERROR, GLF);
+            std::shared_ptr<IMinecraftClient> client = Network::GetInstance()->GetClient(clientId);
+            if (client != nullptr)
+                client->Kick("Mapsend error", false);
+            return;
+        }
 
-    int compressedSize = GZIP::GZip_Compress(tempBuf2.data(), tempBuffer2Size, tempBuf.data(), tempBufferOffset);
+        // -- Blocks were read while the stream ran, so only a stream no change raced is worth keeping.
+        if (stream.Replayed() || self->m_blockGeneration != generation)
+            return;
 
-    if (compressedSize == -1) {
-        Logger::LogAdd(MODULE_NAME, "Can't send the map: GZip Error", LogType::L_ERROR, GLF);
-        nc->Kick("Mapsend error", false);
-        return;
+        std::scoped_lock<std::mutex> cacheLock(self->m_sendCacheLock);
+        std::erase_if(self->m_sendCache, [generation](const SendCacheEntry& entry) { return entry.Generation != generation; });
+        if (std::any_of(self->m_sendCache.begin(), self->m_sendCache.end(), [&translation, fastMap](const SendCacheEntry& entry) { return entry.FastMap == fastMap && entry.Translation == translation; }))
+            return;
+        if (self->m_sendCache.size() >= MAP_SEND_CACHE_PROFILES)
+            self->m_sendCache.erase(self->m_sendCache.begin());
+        self->m_sendCache.push_back(SendCacheEntry { generation, fastMap, translation, stream.Encoded() });
+    };
+
+    std::shared_ptr<MapSendStream> stream;
+    size_t queuePosition = 0;
+    if (!levelData.empty()) {
+        stream = std::make_shared<MapSendStream>(std::move(levelData), mapSize, finished);
+    } else {
+        // -- Encoded on the send pool a little ahead of the client; block changes racing the stream are queued behind its finalize.
+        auto reader = [self, layer](int64_t offset, unsigned char* output, int count) {
+            // -- Holds the storage in place while copying; a stream whose layer was replaced or freed reads nothing more.
+            std::shared_lock<std::shared_mutex> layerLock(self->m_layerLock);
+            return self->loaded && self->m_layerGeneration == layer && self->m_mapProvider->ReadBlocks(offset, output, count);
+        };
+        stream = std::make_shared<MapSendStream>(reader, mapSize, translation, finished, fastMap);
+        stream->RunOn([](const std::function<void()>& task) { MapMain::GetInstance()->QueueSendTask(task); });
+
+        // -- Replays are only copies, just sends that still have to compress wait for a slot.
+        std::weak_ptr<MapSendStream> weakStream = stream;
+        queuePosition = MapMain::GetInstance()->QueueMapSend([weakStream, self, layer](const Common::AdmissionQueue::Ticket& ticket) {
+            std::shared_ptr<MapSendStream> waiting = weakStream.lock();
+            if (waiting == nullptr)
+                return;
+
+            // -- The map may have been unloaded or its storage replaced while the send waited for a slot.
+            bool current;
+            {
+                std::shared_lock<std::shared_mutex> layerLock(self->m_layerLock);
+                current = self->loaded && self->m_layerGeneration == layer;
+            }
+
+            if (current)
+                waiting->Admit(ticket);
+            else
+                waiting->Abort();
+        });
     }
 
-    compressedSize += (1024 - (compressedSize % 1024));
-    Packets::SendMapInit(clientId);
+    if (queuePosition > 0)
+        NetworkFunctions::SystemMessageNetworkSend(clientId, "&eMap send queued, position " + std::to_string(queuePosition));
+
+    Packets::SendMapInit(clientId, fastMap ? mapSize.X * mapSize.Y * mapSize.Z : -1);
     CPE::DuringMapActions(nc);
-    int bytes2Send = compressedSize;
-    int bytesSent = 0;
-
-    while (bytes2Send > 0) {
-        int bytesInBlock = bytes2Send;
-        if (bytesInBlock > 1024)
-            bytesInBlock = 1024;
-        Packets::SendMapData(clientId, static_cast<short>(bytesInBlock),
-                             reinterpret_cast<char *>(tempBuf2.data() + bytesSent), static_cast<unsigned char>(bytesSent * 100.0 / compressedSize));
-        bytesSent += bytesInBlock;
-        bytes2Send -= bytesInBlock;
-    }
-    tempBuf.clear();
-    tempBuf2.clear();
-    Packets::SendMapFinalize(clientId, mapSize.X, mapSize.Y, mapSize.Z);
+    nc->StreamBulk(stream);
     CPE::AfterMapActions(nc);
 }
 
@@ -401,45 +708,51 @@ void Map::BlockChange (short playerNumber, unsigned short X, unsigned short Y, u
 
     m_mapProvider->SetBlock(locationVector, type);
     m_mapProvider->SetLastPlayer(locationVector, playerNumber);
+    if (type != roData)
+        m_blockGeneration++;
+
+    if (m_journal != nullptr && (type != roData || playerNumber != roLastPlayer))
+        m_journal->Append(locationVector, type, playerNumber);
 
     if (physic) {
         QueuePhysicsAround(locationVector);
     }
 }
 
-unsigned char Map::GetBlockType(unsigned short X, unsigned short Y, unsigned short Z) {
-     if (!loaded && !loading) {
-         LastClient = time(nullptr);
-         Reload();
-         if (!loaded) {
-             return 255; // -- error reloading :( 
-         }
-     }
+int Map::GetBlockType(unsigned short X, unsigned short Y, unsigned short Z) {
+    // -- Unloaded (or rebuilding) maps answer right away; the load runs on the load pool instead of this thread.
+    if (!loaded || loading) {
+        if (!loaded)
+            RequestLoad();
+        return MAP_BLOCK_NOT_LOADED;
+    }
 
-     if (loading) {
-         while (loading) {
-             std::this_thread::sleep_for(std::chrono::milliseconds(100));
-         }
-     }
-     auto mapSize = m_mapProvider->GetSize();
+    auto mapSize = m_mapProvider->GetSize();
 
-     if (X > mapSize.X || Y > mapSize.Y || Z > mapSize.Z) {
-         return 255;
-     }
+    if (X > mapSize.X || Y > mapSize.Y || Z > mapSize.Z) {
+        return 255;
+    }
 
-     return m_mapProvider->GetBlock(Vector3S(X, Y, Z));
+    return m_mapProvider->GetBlock(Vector3S(X, Y, Z));
 }
 
-void Map::QueueBlockChange(Common::Vector3S location, unsigned char priority, unsigned char oldType) const {
-    while (loading) {
-        std::this_thread::sleep_for(std::chrono::milliseconds(10));
-    }
-
+void Map::QueueBlockChange(Common::Vector3S location, unsigned char priority, unsigned char oldType) {
     ChangeQueueItem newQueueItem { location,
                                     oldType,
                                      priority
     };
 
+    // -- While a load or resize is rebuilding the queue, the change waits behind it instead of the caller.
+    if (loading || bcQueue == nullptr) {
+        std::weak_ptr<Map> weakMap = weak_from_this();
+        WhenLoaded([weakMap, newQueueItem](bool result) {
+            std::shared_ptr<Map> map = weakMap.lock();
+            if (result && map != nullptr)
+                map->bcQueue->TryQueue(newQueueItem);
+        });
+        return;
+    }
+
     bcQueue->TryQueue(newQueueItem);
 }
 
@@ -449,6 +762,13 @@ Map::Map() : IActions(), RankBoxes(), Particles() {
     loading = false;
     BlockchangeStopped = false;
     PhysicsStopped = false;
+    ProviderType = MAP_PROVIDER_D3;
+    JournalSnapshotSize = 0;
+    m_snapshotRequired = false;
+    m_snapshotQueued = false;
+    m_warmSize = 0;
+    m_blockGeneration = 0;
+    m_layerGeneration = 0;
   //  SaveTime = 0;
    // LastClient = 0;
   //  Clients = 0;
@@ -493,6 +813,12 @@ void Map::BlockMove(unsigned short X0, unsigned short Y0, unsigned short Z0, uns
     m_mapProvider->SetBlock(location1, oldBlockType1);
     m_mapProvider->SetLastPlayer(location0, -1);
     m_mapProvider->SetLastPlayer(location1, oldBlockHistory0);
+    m_blockGeneration++;
+
+    if (m_journal != nullptr) {
+        m_journal->Append(location0, oldBlockType0, -1);
+        m_journal->Append(location1, oldBlockType1, oldBlockHistory0);
+    }
 
     if (physic) {
         QueuePhysicsAround(location0);
@@ -638,6 +964,13 @@ void Map::DeleteTeleporter(std::string id) {
 }
 
 void Map::MapExport(MinecraftLocation start, MinecraftLocation end, std::string filename) {
+    if (!loaded || loading) {
+        Logger::LogAdd(MODULE_NAME, "Can't export an unloaded map (" + filename + ")", LogType::WARNING, GLF);
+        if (!loaded)
+            RequestLoad();
+        return;
+    }
+
     Vector3S startVec = start.GetAsBlockCoords();
     Vector3S endVec = end.GetAsBlockCoords();
 
@@ -13,14 +13,20 @@ D3PP::world::MapActions::MapActions() {
 }
 
 void D3PP::world::MapActions::MainFunc() {
-    if (!itemQueue.empty()) {
-        std::function <void()> taskToComplete = itemQueue.front();
-        taskToComplete();
-        itemQueue.pop();
+    std::function<void()> taskToComplete;
+    {
+        std::scoped_lock<std::mutex> qLock(m_queueLock);
+        if (!itemQueue.empty()) {
+            taskToComplete = itemQueue.front();
+            itemQueue.pop();
+        }
     }
+    if (taskToComplete)
+        taskToComplete();
 }
 
 void D3PP::world::MapActions::AddTask(const std::function<void()>& task) {
+    std::scoped_lock<std::mutex> qLock(m_queueLock);
     itemQueue.push(task);
 }
 
@@ -11,16 +11,22 @@ D3PP::world::MapIntensiveActions::MapIntensiveActions() : runner([this]() {this-
 
 void D3PP::world::MapIntensiveActions::MainFunc() {
     while (System::IsRunning && !m_finished) {
-        if (!itemQueue.empty()) {
-            std::function<void()> taskToComplete = itemQueue.front();
-            taskToComplete();
-            itemQueue.pop();
+        std::function<void()> taskToComplete;
+        {
+            std::scoped_lock<std::mutex> qLock(m_queueLock);
+            if (!itemQueue.empty()) {
+                taskToComplete = itemQueue.front();
+                itemQueue.pop();
+            }
         }
+        if (taskToComplete)
+            taskToComplete();
         std::this_thread::sleep_for(std::chrono::milliseconds(1));
     }
 }
 
 void D3PP::world::MapIntensiveActions::AddTask(const std::function<void()>& task) {
+    std::scoped_lock<std::mutex> qLock(m_queueLock);
     itemQueue.push(task);
 }
 
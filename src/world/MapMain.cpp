@@ -4,6 +4,7 @@
 #include "common/Files.h"
 #include "common/PreferenceLoader.h"
 #include "common/Logger.h"
+#include "common/Configuration.h"
 
 #include "EventSystem.h"
 #include "events/EventMapActionDelete.h"
@@ -18,6 +19,8 @@
 #include "world/Entity.h"
 #include "world/Map.h"
 #include "world/D3MapProvider.h"
+#include "world/PalettedMapProvider.h"
+#include "world/MmapMapProvider.h"
 #include "world/Teleporter.h"
 #include "world/Player.h"
 #include "compression.h"
@@ -38,14 +41,30 @@ D3PP::world::MapMain::MapMain() {
     SaveFileTimer = 0;
     mapSettingsLastWriteTime = 0;
     mapSettingsMaxChangesSec = 1100;
+    mapSettingsHugePages = false;
+    mapSettingsJournalSnapshotSize = 16 * 1024 * 1024;
+    mapSettingsWarmTierSize = 256 * 1024 * 1024;
+    mapSettingsLoadThreads = 2;
     mapSettingsTimerFileCheck = 0;
+    m_loadPool = std::make_unique<Common::WorkerPool>(mapSettingsLoadThreads);
+    mapSettingsSendThreads = 2;
+    mapSettingsMaxMapSends = 8;
+    m_sendPool = std::make_unique<Common::WorkerPool>(mapSettingsSendThreads);
+    m_sendAdmission = std::make_unique<Common::AdmissionQueue>(mapSettingsMaxMapSends);
 
     phStarted = false;
     mbcStarted = false;
     TempId = 0;
 }
 void D3PP::world::MapMain::Init() {
+    // -- Settings first, so the load pool is sized before the map list queues its loads.
+    MapSettingsLoad();
     MapListLoad();
+
+    // -- Only the spawn map has to be ready before we accept connections, the rest keep loading in the background.
+    std::shared_ptr<Map> spawnMap = GetPointer(Configuration::GenSettings.SpawnMapId);
+    if (spawnMap != nullptr && !spawnMap->RequestLoad().get())
+        Logger::LogAdd(MODULE_NAME, "Spawn map failed to load.", LogType::L_ERROR, GLF);
 }
 
 void D3PP::world::MapMain::MainFunc() {
@@ -81,13 +100,14 @@ void D3PP::world::MapMain::MainFunc() {
         if (m.second->Clients > 0) {
             m.second->LastClient = time(nullptr);
             if (!m.second->loaded) {
-                m.second->Reload();
+                m.second->RequestLoad();
             }
         }
         if (m.second->loaded && (time(nullptr) - m.second->LastClient) > 200) { // -- Unload unused maps after 3 minutes
-            m.second->Unload();
+            m.second->Unload(mapSettingsWarmTierSize > 0);
         }
     }
+    EnforceWarmTierSize();
     fileTime = Utils::FileModTime(Files::GetFile(MAP_SETTINGS_FILE));
     if (fileTime != mapSettingsLastWriteTime) {
         MapSettingsLoad();
@@ -107,8 +127,7 @@ void D3PP::world::MapMain::AddSaveAction(int clientId, int mapId, const std::str
     if (thisMap == nullptr)
         return;
 
-    std::function<void()> saveAction = [thisMap, clientId](){
-        thisMap->Save("");
+    std::function<void()> savedAction = [thisMap, clientId](){
         if (clientId > 0) {
             NetworkFunctions::SystemMessageNetworkSend(clientId, "&eMap Saved.");
         }
@@ -118,7 +137,20 @@ void D3PP::world::MapMain::AddSaveAction(int clientId, int mapId, const std::str
         Dispatcher::post(mas);
     };
 
-    thisMap->m_actions.AddTask(saveAction);
+    // -- Providers that snapshot their blocks are saved on the map's own thread, so compression never holds up
+    // -- the action queue; the notification is handed back to the action queue once the file is written.
+    if (thisMap->m_mapProvider != nullptr && thisMap->m_mapProvider->SupportsConcurrentSave()) {
+        thisMap->IActions.AddTask([thisMap, savedAction]() {
+            thisMap->Save("");
+            thisMap->m_actions.AddTask(savedAction);
+        });
+        return;
+    }
+
+    thisMap->m_actions.AddTask([thisMap, savedAction]() {
+        thisMap->Save("");
+        savedAction();
+    });
 }
 
 void D3PP::world::MapMain::AddLoadAction(int clientId, int mapId, const std::string& directory) {
@@ -143,6 +175,35 @@ void D3PP::world::MapMain::AddLoadAction(int clientId, int mapId, const std::str
     thisMap->m_actions.AddTask(loadAction);
 }
 
+void D3PP::world::MapMain::AddConvertAction(int clientId, int mapId) {
+    std::shared_ptr<Map> thisMap = GetPointer(mapId);
+
+    if (thisMap == nullptr)
+        return;
+
+    std::function<void()> convertAction = [thisMap, clientId](){
+        bool result = thisMap->ConvertToChunked();
+
+        if (clientId > 0) {
+            NetworkFunctions::SystemMessageNetworkSend(clientId, result ? "&eMap converted." : "&cThis map can't be converted.");
+        }
+    };
+
+    thisMap->m_actions.AddTask(convertAction);
+}
+
+void D3PP::world::MapMain::QueueLoadTask(const std::function<void()>& task) {
+    m_loadPool->Submit(task);
+}
+
+void D3PP::world::MapMain::QueueSendTask(const std::function<void()>& task) {
+    m_sendPool->Submit(task);
+}
+
+size_t D3PP::world::MapMain::QueueMapSend(const std::function<void(Common::AdmissionQueue::Ticket)>& job) {
+    return m_sendAdmission->Enqueue(job);
+}
+
 void D3PP::world::MapMain::LoadImmediately(int mapId, const std::string& directory) {
     std::shared_ptr<Map> thisMap = GetPointer(mapId);
 
@@ -216,20 +277,28 @@ void D3PP::world::MapMain::MapBlockChange() {
             if (m.second->BlockchangeStopped || !m.second->loaded)
                 continue;
 
+            if (m.second->bcQueue == nullptr)
+                continue;
+
             int maxChangedSec = 1100 / 10;
             ChangeQueueItem i{};
+            // -- Everything dequeued this pass goes out together, so clients get it as few packets.
+            std::vector<Common::Vector3S> locations;
+            std::vector<unsigned char> types;
 
-            while (maxChangedSec > 0) {
-                if (m.second->bcQueue == nullptr) {
-                    continue;
-                }
-                if (m.second->bcQueue->TryDequeue(i)) {
-                    unsigned char currentMat = m.second->GetBlockType(i.Location.X, i.Location.Y, i.Location.Z);
-                    NetworkFunctions::NetworkOutBlockSet2Map(m.first, i.Location.X, i.Location.Y, i.Location.Z,
-                                                             currentMat);
-                }
+            while (maxChangedSec > 0 && m.second->bcQueue->TryDequeue(i)) {
                 maxChangedSec--;
+                // -- Unloaded since it was queued; clients get the whole map again once it is back.
+                int type = m.second->GetBlockType(i.Location.X, i.Location.Y, i.Location.Z);
+                if (type == MAP_BLOCK_NOT_LOADED)
+                    continue;
+
+                locations.push_back(i.Location);
+                types.push_back(static_cast<unsigned char>(type));
             }
+
+            if (!locations.empty())
+                NetworkFunctions::NetworkOutBlockSets2Map(m.first, m.second->GetSize(), locations, types);
         }
 
         watchdog::Watch("Map_Blockchanging", "End thread-slope", 2);
@@ -332,6 +401,7 @@ void D3PP::world::MapMain::MapListSave() {
             continue;
         pl.Write("Name", m.second->m_mapProvider->MapName);
         pl.Write("Directory", m.second->filePath);
+        pl.Write("Provider", m.second->ProviderType);
         pl.Write("Delete", 0);
         pl.Write("Reload", 0);
     }
@@ -345,6 +415,7 @@ void D3PP::world::MapMain::MapListLoad() {
     std::string fName = Files::GetFile(MAP_LIST_FILE);
     PreferenceLoader pl(fName, "");
     pl.LoadFile();
+    int queuedLoads = 0;
 
     for(auto const &m : pl.SettingsDictionary) {
         if (m.first.empty())
@@ -356,28 +427,31 @@ void D3PP::world::MapMain::MapListLoad() {
         std::string directory = pl.Read("Directory", Files::GetFolder("Maps") + m.first + "/");
         bool mapDelete = (pl.Read("Delete", 0) == 1);
         bool mapReload = (pl.Read("Reload", 0) == 1);
+        std::string providerType = pl.Read("Provider", MAP_PROVIDER_D3);
         if (mapDelete) {
             AddDeleteAction(0, mapId);
         } else {
             std::shared_ptr<Map> mapPtr = GetPointer(mapId);
             if (mapPtr == nullptr) {
-                Add(mapId, 64, 64, 64, mapName);
+                Add(mapId, 64, 64, 64, mapName, providerType);
                 mapReload = true;
                 mapPtr = GetPointer(mapId);
                 mapPtr->filePath = directory;
             }
             if ((mapReload)) {
-                LoadImmediately(mapId, directory);
+                mapPtr->filePath = directory;
+                mapPtr->RequestLoad(directory);
+                queuedLoads++;
             }
         }
     }
     SaveFile = false;
 
     LastWriteTime = Utils::FileModTime(fName);
-    Logger::LogAdd(MODULE_NAME, "File loaded. [" + fName + "]", LogType::NORMAL, GLF);
+    Logger::LogAdd(MODULE_NAME, "File loaded. [" + fName + "] (" + stringulate(queuedLoads) + " maps queued for loading)", LogType::NORMAL, GLF);
 }
 
-int D3PP::world::MapMain::Add(int id, short x, short y, short z, const std::string& name) {
+int D3PP::world::MapMain::Add(int id, short x, short y, short z, const std::string& name, const std::string& providerType) {
     bool createNew = false;
     if (id == -1) {
         id = GetMapId();
@@ -400,12 +474,17 @@ int D3PP::world::MapMain::Add(int id, short x, short y, short z, const std::stri
     newMap->Clients = 0;
     newMap->LastClient = time(nullptr);
     Common::Vector3S sizeVector {x, y, z};
-    newMap->m_mapProvider = std::make_unique<D3MapProvider>();
+    newMap->ProviderType = providerType;
+    newMap->JournalSnapshotSize = mapSettingsJournalSnapshotSize;
+    newMap->m_mapProvider = CreateProvider(providerType);
     newMap->filePath = Files::GetFolder("Maps") + name + "/";
     
     if (createNew) {
         newMap->m_mapProvider->CreateNew(sizeVector, newMap->filePath, name);
         newMap->loaded = true;
+
+        if (newMap->JournalSnapshotSize > 0)
+            newMap->m_journal = std::make_unique<files::BlockJournal>(newMap->filePath);
     }
 
     newMap->bcQueue = std::make_unique<BlockChangeQueue>(sizeVector);
@@ -445,6 +524,29 @@ void D3PP::world::MapMain::Delete(int id) {
     SaveFile = true;
 }
 
+void D3PP::world::MapMain::EnforceWarmTierSize() {
+    int64_t warmTotal = 0;
+    for (auto const &m : _maps)
+        warmTotal += m.second->WarmSize();
+
+    // -- Least recently visited maps leave the warm tier first.
+    while (warmTotal > mapSettingsWarmTierSize) {
+        std::shared_ptr<Map> oldest = nullptr;
+        for (auto const &m : _maps) {
+            if (m.second->WarmSize() > 0 && (oldest == nullptr || m.second->LastClient < oldest->LastClient))
+                oldest = m.second;
+        }
+
+        if (oldest == nullptr)
+            break;
+
+        warmTotal -= oldest->WarmSize();
+        // -- Being saved, the next tick tries again.
+        if (!oldest->EvictWarm())
+            break;
+    }
+}
+
 void D3PP::world::MapMain::MapSettingsLoad() {
     std::string mapSettingsFile = Files::GetFile("Map_Settings");
     json j;
@@ -463,6 +565,24 @@ void D3PP::world::MapMain::MapSettingsLoad() {
     iStream.close();
 
     mapSettingsMaxChangesSec = j["Max_Changes_s"];
+    if (!j["Mmap_Huge_Pages"].is_null())
+        mapSettingsHugePages = j["Mmap_Huge_Pages"];
+    if (!j["Journal_Snapshot_Size"].is_null())
+        mapSettingsJournalSnapshotSize = j["Journal_Snapshot_Size"];
+    if (!j["Warm_Tier_Size"].is_null())
+        mapSettingsWarmTierSize = j["Warm_Tier_Size"];
+    if (!j["Load_Threads"].is_null())
+        mapSettingsLoadThreads = j["Load_Threads"];
+    m_loadPool->SetThreadCount(mapSettingsLoadThreads);
+    if (!j["Send_Threads"].is_null())
+        mapSettingsSendThreads = j["Send_Threads"];
+    m_sendPool->SetThreadCount(mapSettingsSendThreads);
+    if (!j["Max_Map_Sends"].is_null())
+        mapSettingsMaxMapSends = j["Max_Map_Sends"];
+    m_sendAdmission->SetLimit(mapSettingsMaxMapSends);
+
+    for (auto const &m : _maps)
+        m.second->JournalSnapshotSize = mapSettingsJournalSnapshotSize;
     mapSettingsLastWriteTime = Utils::FileModTime(mapSettingsFile);
 
     Logger::LogAdd(MODULE_NAME, "File Loaded [" + mapSettingsFile + "]", LogType::NORMAL, GLF);
@@ -472,6 +592,12 @@ void D3PP::world::MapMain::MapSettingsSave() {
     std::string hbSettingsFile = Files::GetFile("Map_Settings");
     json j;
     j["Max_Changes_s"] = mapSettingsMaxChangesSec;
+    j["Mmap_Huge_Pages"] = mapSettingsHugePages;
+    j["Journal_Snapshot_Size"] = mapSettingsJournalSnapshotSize;
+    j["Warm_Tier_Size"] = mapSettingsWarmTierSize;
+    j["Load_Threads"] = mapSettingsLoadThreads;
+    j["Send_Threads"] = mapSettingsSendThreads;
+    j["Max_Map_Sends"] = mapSettingsMaxMapSends;
 
     std::ofstream ofstream(hbSettingsFile);
 
@@ -483,6 +609,25 @@ void D3PP::world::MapMain::MapSettingsSave() {
     Logger::LogAdd(MODULE_NAME, "File Saved [" + hbSettingsFile + "]", LogType::NORMAL, GLF);
 }
 
+std::unique_ptr<D3PP::world::IMapProvider> D3PP::world::MapMain::CreateProvider(const std::string& providerType) {
+    if (Utils::InsensitiveCompare(providerType, MAP_PROVIDER_PALETTED))
+        return std::make_unique<PalettedMapProvider>();
+
+    if (Utils::InsensitiveCompare(providerType, MAP_PROVIDER_MMAP)) {
+#ifdef __linux__
+        return std::make_unique<MmapMapProvider>(GetInstance()->mapSettingsHugePages);
+#else
+        Logger::LogAdd(MODULE_NAME, "Map provider '" + providerType + "' is only available on Linux, using " + MAP_PROVIDER_D3, LogType::WARNING, GLF);
+        return std::make_unique<D3MapProvider>();
+#endif
+    }
+
+    if (!Utils::InsensitiveCompare(providerType, MAP_PROVIDER_D3))
+        Logger::LogAdd(MODULE_NAME, "Unknown map provider '" + providerType + "', using " + MAP_PROVIDER_D3, LogType::WARNING, GLF);
+
+    return std::make_unique<D3MapProvider>();
+}
+
 D3PP::Common::Vector3S D3PP::world::MapMain::GetMapExportSize(const std::string& filename) {
     std::vector<unsigned char> tempData(10);
     int outputLen = GZIP::GZip_DecompressFromFile(tempData.data(), 10, filename);
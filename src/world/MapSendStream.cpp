@@ -0,0 +1,221 @@
+#include "world/MapSendStream.h"
+
+#include <algorithm>
+
+#include "compression.h"
+#include "network/Packets.h"
+
+namespace D3PP::world {
+    MapSendStream::MapSendStream(BlockReader reader, const Common::Vector3S& size, const std::array<unsigned char, 256>& translation, FinishedCallback finished, bool fastMap)
+        : m_reader(std::move(reader)), m_finished(std::move(finished)), m_size(size), m_translation(translation), m_position(0),
+          m_gzip(std::make_unique<GZipStream>(fastMap)), m_deflated(false), m_failed(false), m_readyBytes(0), m_replayed(0),
+          m_admitted(true), m_encoding(false), m_ended(false), m_starved(false) {
+        m_volume = static_cast<int64_t>(size.X) * size.Y * size.Z;
+        if (fastMap)
+            return;
+
+        // -- The level stream starts with its uncompressed length.
+        const unsigned char header[4] = {
+            static_cast<unsigned char>(m_volume >> 24),
+            static_cast<unsigned char>(m_volume >> 16),
+            static_cast<unsigned char>(m_volume >> 8),
+            static_cast<unsigned char>(m_volume & 0xFF)
+        };
+        m_failed = !m_gzip->Write(header, 4, false, m_pending);
+    }
+
+    MapSendStream::MapSendStream(std::vector<network::SharedPacket> encoded, const Common::Vector3S& size, FinishedCallback finished)
+        : m_finished(std::move(finished)), m_size(size), m_translation(), m_volume(0), m_position(0), m_deflated(true), m_failed(false),
+          m_readyBytes(0), m_encoded(std::move(encoded)), m_replayed(0), m_admitted(true), m_encoding(false), m_ended(true), m_starved(false) {
+    }
+
+    MapSendStream::~MapSendStream() = default;
+
+    void MapSendStream::RunOn(const Scheduler& schedule) {
+        const std::scoped_lock<std::mutex> pLock(m_lock);
+        if (m_gzip == nullptr)
+            return;
+
+        m_schedule = schedule;
+        m_admitted = false;
+    }
+
+    void MapSendStream::Admit(std::shared_ptr<void> ticket) {
+        bool schedule;
+        {
+            const std::scoped_lock<std::mutex> pLock(m_lock);
+            m_ticket = std::move(ticket);
+            m_admitted = true;
+            // -- Gets a head start before the client asks for anything.
+            schedule = ShouldEncode();
+            m_encoding = m_encoding || schedule;
+        }
+
+        if (schedule)
+            m_schedule([self = shared_from_this()]() { self->Encode(); });
+    }
+
+    void MapSendStream::Abort() {
+        std::function<void()> wake;
+        std::shared_ptr<void> ticket;
+        {
+            const std::scoped_lock<std::mutex> pLock(m_lock);
+            m_failed = true;
+            m_ended = true;
+            ticket = std::move(m_ticket);
+            if (m_starved) {
+                m_starved = false;
+                wake = m_wake;
+            }
+        }
+        ticket = nullptr;
+
+        if (wake)
+            wake();
+    }
+
+    bool MapSendStream::ShouldEncode() const {
+        return m_schedule && m_admitted && !m_encoding && !m_ended && m_readyBytes < MAP_STREAM_AHEAD_BYTES / 2;
+    }
+
+    network::SharedPacket MapSendStream::Next() {
+        std::unique_lock<std::mutex> pLock(m_lock);
+        if (m_gzip == nullptr)
+            return m_replayed < m_encoded.size() ? m_encoded[m_replayed++] : nullptr;
+
+        if (!m_schedule) {
+            network::SharedPacket packet = Produce();
+            if (packet != nullptr)
+                m_encoded.push_back(packet);
+            else
+                m_ended = true;
+            return packet;
+        }
+
+        network::SharedPacket packet;
+        if (!m_ready.empty()) {
+            packet = m_ready.front();
+            m_ready.pop_front();
+            m_readyBytes -= packet->Size();
+        } else if (!m_ended) {
+            m_starved = true;
+        }
+
+        bool schedule = ShouldEncode();
+        m_encoding = m_encoding || schedule;
+        pLock.unlock();
+
+        if (schedule)
+            m_schedule([self = shared_from_this()]() { self->Encode(); });
+
+        return packet;
+    }
+
+    bool MapSendStream::Ended() {
+        const std::scoped_lock<std::mutex> pLock(m_lock);
+        if (m_gzip == nullptr)
+            return m_replayed >= m_encoded.size();
+
+        return m_ended && m_ready.empty();
+    }
+
+    void MapSendStream::SetWake(const std::function<void()>& wake) {
+        const std::scoped_lock<std::mutex> pLock(m_lock);
+        m_wake = wake;
+    }
+
+    void MapSendStream::Encode() {
+        while (true) {
+            // -- Only one Encode runs at a time (m_encoding), so the encoder state is used without the lock.
+            network::SharedPacket packet = Produce();
+            std::function<void()> wake;
+            std::shared_ptr<void> ticket;
+            bool more;
+            {
+                const std::scoped_lock<std::mutex> pLock(m_lock);
+                if (packet != nullptr) {
+                    m_ready.push_back(packet);
+                    m_readyBytes += packet->Size();
+                    m_encoded.push_back(packet);
+                } else {
+                    m_ended = true;
+                    // -- Done with the CPU work, the next queued send can start while this one drains.
+                    ticket = std::move(m_ticket);
+                }
+
+                if (m_starved) {
+                    m_starved = false;
+                    wake = m_wake;
+                }
+
+                more = !m_ended && m_readyBytes < MAP_STREAM_AHEAD_BYTES;
+                m_encoding = more;
+            }
+
+            if (wake)
+                wake();
+
+            if (!more)
+                return;
+        }
+    }
+
+    network::SharedPacket MapSendStream::Produce() {
+        if (m_failed)
+            return nullptr;
+
+        while (m_pending.size() < MAP_STREAM_PACKET_BYTES && !m_deflated) {
+            int count = static_cast<int>(std::min(static_cast<int64_t>(MAP_STREAM_READ_BLOCKS), m_volume - m_position));
+            m_input.resize(count);
+
+            if (count > 0 && !m_reader(m_position, m_input.data(), count)) {
+                m_failed = true;
+                return nullptr;
+            }
+
+            for (auto& block : m_input)
+                block = m_translation[block];
+
+            m_position += count;
+            m_deflated = (m_position == m_volume);
+
+            if (!m_gzip->Write(m_input.data(), count, m_deflated, m_pending)) {
+                m_failed = true;
+                return nullptr;
+            }
+        }
+
+        // -- Only whole chunks until the stream is complete, so just the last one is short.
+        size_t length = m_deflated ? m_pending.size() : m_pending.size() - m_pending.size() % 1024;
+        if (length == 0) {
+            // -- Nothing reads the buffers again once the stream is drained.
+            m_input = std::vector<unsigned char>();
+            m_pending = std::vector<unsigned char>();
+            return nullptr;
+        }
+
+        int percent = m_volume > 0 ? static_cast<int>(m_position * 100 / m_volume) : 100;
+        network::SharedPacket packet = Packets::EncodeLevelData(m_pending.data(), static_cast<int>(length), std::min(percent, 100));
+        m_pending.erase(m_pending.begin(), m_pending.begin() + static_cast<std::ptrdiff_t>(length));
+        return packet;
+    }
+
+    network::SharedPacket MapSendStream::Closing() {
+        if (m_failed)
+            return nullptr;
+
+        return Packets::EncodeMapFinalize(m_size.X, m_size.Y, m_size.Z);
+    }
+
+    void MapSendStream::Finished(bool complete) {
+        std::shared_ptr<void> ticket;
+        {
+            const std::scoped_lock<std::mutex> pLock(m_lock);
+            ticket = std::move(m_ticket);
+        }
+        ticket = nullptr;
+
+        if (m_finished)
+            m_finished(*this, complete);
+    }
+}
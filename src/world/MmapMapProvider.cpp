@@ -0,0 +1,467 @@
+#ifdef __linux__
+#include "world/MmapMapProvider.h"
+
+#include <cstring>
+#include <filesystem>
+#include <mutex>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include "common/Logger.h"
+#include "compression.h"
+#include "Utils.h"
+
+using namespace D3PP::world;
+using namespace D3PP::Common;
+
+const std::string MODULE_NAME = "MmapMap";
+const uint64_t MMAP_PAGE_SIZE = 4096;
+const uint32_t MMAP_FILE_VERSION = 1;
+
+struct MmapLayerHeader {
+    char Magic[4];
+    uint32_t Version;
+    int16_t SizeX;
+    int16_t SizeY;
+    int16_t SizeZ;
+    int16_t Reserved;
+    uint64_t Volume;
+};
+
+MmapMapProvider::MmapMapProvider(bool hugePages) : D3MapProvider(), m_size{} {
+    m_hugePages = hugePages;
+    m_fd = -1;
+    m_mapping = nullptr;
+    m_mappingSize = 0;
+    m_types = nullptr;
+    m_lastPlayers = nullptr;
+}
+
+MmapMapProvider::~MmapMapProvider() {
+    UnmapFile();
+}
+
+void MmapMapProvider::CreateNew(const Vector3S &size, const std::string &path, const std::string &name) {
+    // -- Only the config side of the D3 map, the dense block planes are never allocated.
+    m_d3map = std::make_unique<files::D3Map>(path, name, size, true);
+    MapName = name;
+    m_currentPath = path;
+    auto defaultEnv = MapEnvironment();
+    defaultEnv.SideLevel = size.Z/2;
+    SetEnvironment(defaultEnv);
+    SetPermissions(MapPermissions {0, 0, 0});
+
+    m_d3map->Save();
+    MapFile(m_currentPath + MMAP_MAP_BLOCKS_NAME, size, true);
+}
+
+bool MmapMapProvider::Save(const std::string &filePath) {
+    bool result = D3MapProvider::Save(filePath);
+    std::shared_lock lock(m_mappingLock);
+
+    if (!result || m_mapping == nullptr)
+        return result;
+
+    if (!filePath.empty() && filePath != m_currentPath) {
+        // -- Saving somewhere else produces a regular D3 map, so the copy can be opened by any provider.
+        std::string folder = filePath;
+        if (folder[folder.size() - 1] != '/')
+            folder += "/";
+
+        lock.unlock();
+        return ExportGzip(folder);
+    }
+
+    if (msync(m_mapping, m_mappingSize, MS_SYNC) != 0) {
+        Logger::LogAdd(MODULE_NAME, "msync failed: " + stringulate(strerror(errno)), LogType::L_ERROR, GLF);
+        return false;
+    }
+
+    // -- The folder keeps a current Data-Layer.gz, so any provider (or an older server) can still open it.
+    std::string folder = m_currentPath;
+    if (!folder.empty() && folder[folder.size() - 1] != '/')
+        folder += "/";
+
+    lock.unlock();
+    if (!ExportGzip(folder))
+        return false;
+
+    // -- Both files hold the same blocks now; only a Data-Layer.gz written later by something else is converted on load.
+    std::error_code ec;
+    std::filesystem::last_write_time(folder + MMAP_MAP_BLOCKS_NAME, std::filesystem::last_write_time(folder + D3_MAP_BLOCKS_NAME, ec), ec);
+    return true;
+}
+
+bool MmapMapProvider::Load(const std::string &filePath) {
+    if (m_d3map == nullptr) {
+        m_d3map = std::make_unique<files::D3Map>(filePath);
+        m_d3map->ExternalBlockLayer = true;
+        m_currentPath = filePath;
+    }
+
+    std::string folder = filePath.empty() ? m_currentPath : filePath;
+
+    if (!m_d3map->Load(folder))
+        return false;
+
+    if (filePath == m_currentPath)
+        MapName = m_d3map->Name;
+
+    if (folder[folder.size() - 1] != '/')
+        folder += "/";
+
+    UnmapFile();
+    return OpenLayer(folder, m_d3map->MapSize);
+}
+
+bool MmapMapProvider::OpenLayer(const std::string &folder, const Vector3S &size) {
+    std::string rawName = folder + MMAP_MAP_BLOCKS_NAME;
+    std::string gzName = folder + D3_MAP_BLOCKS_NAME;
+    std::error_code ec;
+    bool convert = !std::filesystem::exists(rawName, ec) ||
+            (std::filesystem::exists(gzName, ec) && std::filesystem::last_write_time(gzName, ec) > std::filesystem::last_write_time(rawName, ec));
+
+    if (convert)
+        return ConvertFromGzip(folder, size);
+
+    return MapFile(rawName, size, false);
+}
+
+void MmapMapProvider::SetSize(const Vector3S &newSize) {
+    std::string folder = m_currentPath;
+    if (!folder.empty() && folder[folder.size() - 1] != '/')
+        folder += "/";
+    std::string rawName = folder + MMAP_MAP_BLOCKS_NAME;
+    std::string tempName = rawName + ".tmp";
+
+    bool mapped;
+    {
+        std::shared_lock lock(m_mappingLock);
+        mapped = (m_mapping != nullptr);
+    }
+
+    // -- An unloaded map is resized from what is on disk, not from an empty layer.
+    if (!mapped && !OpenLayer(folder, m_d3map->MapSize)) {
+        Logger::LogAdd(MODULE_NAME, "Could not resize map, its block layer did not open [" + folder + "]", LogType::L_ERROR, GLF);
+        return;
+    }
+
+    // -- The new file is mapped and filled before it is published, readers only ever see a complete layer.
+    LayerMapping resized{};
+    if (!OpenFile(tempName, newSize, true, resized))
+        return;
+
+    LayerMapping old{};
+    {
+        std::unique_lock lock(m_mappingLock);
+        if (m_mapping != nullptr) {
+            auto* newTypes = resized.Data + MMAP_PAGE_SIZE;
+            auto* newLastPlayers = reinterpret_cast<short*>(resized.Data + GetLastPlayerOffset(GetVolume(newSize)));
+            uint64_t rowLength = std::min(m_size.X, newSize.X);
+
+            for (int z = 0; z < std::min(m_size.Z, newSize.Z); z++) {
+                for (int y = 0; y < std::min(m_size.Y, newSize.Y); y++) {
+                    uint64_t oldRow = static_cast<uint64_t>(y) * m_size.X + static_cast<uint64_t>(z) * m_size.X * m_size.Y;
+                    uint64_t newRow = static_cast<uint64_t>(y) * newSize.X + static_cast<uint64_t>(z) * newSize.X * newSize.Y;
+
+                    memcpy(newTypes + newRow, m_types + oldRow, rowLength);
+                    memcpy(newLastPlayers + newRow, m_lastPlayers + oldRow, rowLength * sizeof(short));
+                }
+            }
+        }
+        old = SetMapping(resized, newSize);
+    }
+    CloseMapping(old);
+
+    std::error_code ec;
+    std::filesystem::rename(tempName, rawName, ec);
+    if (ec)
+        Logger::LogAdd(MODULE_NAME, "Could not replace mapfile: " + ec.message(), LogType::L_ERROR, GLF);
+
+    m_d3map->Resize(newSize);
+}
+
+bool MmapMapProvider::Unload() {
+    UnmapFile();
+    return true;
+}
+
+void MmapMapProvider::SetBlock(const Vector3S &location, const unsigned char &type) {
+    std::shared_lock lock(m_mappingLock);
+    if (!InBounds(location))
+        return;
+
+    m_types[GetBlockOffset(location)] = type;
+}
+
+unsigned char MmapMapProvider::GetBlock(const Vector3S &location) {
+    std::shared_lock lock(m_mappingLock);
+    if (!InBounds(location))
+        return 0;
+
+    return m_types[GetBlockOffset(location)];
+}
+
+short MmapMapProvider::GetLastPlayer(const Vector3S &location) {
+    std::shared_lock lock(m_mappingLock);
+    if (!InBounds(location))
+        return -1;
+
+    return m_lastPlayers[GetBlockOffset(location)];
+}
+
+void MmapMapProvider::SetLastPlayer(const Vector3S &location, const short &player) {
+    std::shared_lock lock(m_mappingLock);
+    if (!InBounds(location))
+        return;
+
+    m_lastPlayers[GetBlockOffset(location)] = player;
+}
+
+void MmapMapProvider::SetBlocks(const std::vector<unsigned char> &blocks) {
+    std::shared_lock lock(m_mappingLock);
+    if (m_mapping == nullptr)
+        return;
+
+    uint64_t volume = GetVolume(m_size);
+    uint64_t copyLength = std::min(volume, static_cast<uint64_t>(blocks.size()));
+
+    memcpy(m_types, blocks.data(), copyLength);
+    memset(m_types + copyLength, 0, volume - copyLength);
+    memset(m_lastPlayers, 0, volume * sizeof(short));
+}
+
+std::vector<unsigned char> MmapMapProvider::GetBlocks() {
+    std::shared_lock lock(m_mappingLock);
+    if (m_mapping == nullptr)
+        return std::vector<unsigned char>(GetVolume(m_size));
+
+    return std::vector<unsigned char>(m_types, m_types + GetVolume(m_size));
+}
+
+bool MmapMapProvider::ReadBlocks(int64_t offset, unsigned char* output, int64_t count) {
+    std::shared_lock lock(m_mappingLock);
+    if (offset < 0 || count < 0 || static_cast<uint64_t>(offset + count) > GetVolume(m_size))
+        return false;
+
+    if (m_mapping == nullptr)
+        memset(output, 0, static_cast<size_t>(count));
+    else
+        memcpy(output, m_types + offset, static_cast<size_t>(count));
+    return true;
+}
+
+bool MmapMapProvider::InBounds(const Vector3S &location) const {
+    return (m_mapping != nullptr && location.X >= 0 && location.X < m_size.X && location.Y >= 0 && location.Y < m_size.Y && location.Z >= 0 && location.Z < m_size.Z);
+}
+
+uint64_t MmapMapProvider::GetBlockOffset(const Vector3S &location) const {
+    return static_cast<uint64_t>(location.X) + static_cast<uint64_t>(location.Y) * m_size.X + static_cast<uint64_t>(location.Z) * m_size.X * m_size.Y;
+}
+
+uint64_t MmapMapProvider::GetVolume(const Vector3S &size) {
+    return static_cast<uint64_t>(size.X) * static_cast<uint64_t>(size.Y) * static_cast<uint64_t>(size.Z);
+}
+
+uint64_t MmapMapProvider::GetLastPlayerOffset(uint64_t volume) {
+    return MMAP_PAGE_SIZE + ((volume + MMAP_PAGE_SIZE - 1) / MMAP_PAGE_SIZE) * MMAP_PAGE_SIZE;
+}
+
+uint64_t MmapMapProvider::GetFileSize(uint64_t volume) {
+    return GetLastPlayerOffset(volume) + volume * sizeof(short);
+}
+
+bool MmapMapProvider::OpenFile(const std::string &fileName, const Vector3S &size, bool create, LayerMapping &result) {
+    uint64_t volume = GetVolume(size);
+    uint64_t fileSize = GetFileSize(volume);
+    int fd = open(fileName.c_str(), create ? (O_RDWR | O_CREAT | O_TRUNC) : O_RDWR, 0644);
+
+    if (fd == -1) {
+        Logger::LogAdd(MODULE_NAME, "Could not open [" + fileName + "]: " + stringulate(strerror(errno)), LogType::L_ERROR, GLF);
+        return false;
+    }
+
+    struct stat fileStat{};
+    if (create && ftruncate(fd, static_cast<off_t>(fileSize)) != 0) {
+        Logger::LogAdd(MODULE_NAME, "Could not size [" + fileName + "]: " + stringulate(strerror(errno)), LogType::L_ERROR, GLF);
+        close(fd);
+        return false;
+    } else if (!create && (fstat(fd, &fileStat) != 0 || static_cast<uint64_t>(fileStat.st_size) < fileSize)) {
+        Logger::LogAdd(MODULE_NAME, "Mapfile is truncated [" + fileName + "]", LogType::L_ERROR, GLF);
+        close(fd);
+        return false;
+    }
+
+    void* mapping = mmap(nullptr, fileSize, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    if (mapping == MAP_FAILED) {
+        Logger::LogAdd(MODULE_NAME, "mmap failed [" + fileName + "]: " + stringulate(strerror(errno)), LogType::L_ERROR, GLF);
+        close(fd);
+        return false;
+    }
+
+    if (m_hugePages && madvise(mapping, fileSize, MADV_HUGEPAGE) != 0)
+        Logger::LogAdd(MODULE_NAME, "Huge pages not available for [" + fileName + "]: " + stringulate(strerror(errno)), LogType::WARNING, GLF);
+
+    auto* header = static_cast<MmapLayerHeader*>(mapping);
+    if (create) {
+        memcpy(header->Magic, "D3RW", 4);
+        header->Version = MMAP_FILE_VERSION;
+        header->SizeX = size.X;
+        header->SizeY = size.Y;
+        header->SizeZ = size.Z;
+        header->Reserved = 0;
+        header->Volume = volume;
+    } else if (memcmp(header->Magic, "D3RW", 4) != 0 || header->Version != MMAP_FILE_VERSION || header->Volume != volume ||
+               header->SizeX != size.X || header->SizeY != size.Y || header->SizeZ != size.Z) {
+        Logger::LogAdd(MODULE_NAME, "Mapfile does not match map config [" + fileName + "]", LogType::L_ERROR, GLF);
+        munmap(mapping, fileSize);
+        close(fd);
+        return false;
+    }
+
+    result = LayerMapping { fd, static_cast<unsigned char*>(mapping), fileSize };
+    return true;
+}
+
+MmapMapProvider::LayerMapping MmapMapProvider::SetMapping(const LayerMapping &mapping, const Vector3S &size) {
+    LayerMapping old { m_fd, m_mapping, m_mappingSize };
+
+    m_fd = mapping.Fd;
+    m_mapping = mapping.Data;
+    m_mappingSize = mapping.Size;
+    m_types = (m_mapping == nullptr) ? nullptr : m_mapping + MMAP_PAGE_SIZE;
+    m_lastPlayers = (m_mapping == nullptr) ? nullptr : reinterpret_cast<short*>(m_mapping + GetLastPlayerOffset(GetVolume(size)));
+    m_size = size;
+    return old;
+}
+
+void MmapMapProvider::CloseMapping(const LayerMapping &mapping) {
+    if (mapping.Data != nullptr) {
+        msync(mapping.Data, mapping.Size, MS_ASYNC);
+        munmap(mapping.Data, mapping.Size);
+    }
+
+    if (mapping.Fd != -1)
+        close(mapping.Fd);
+}
+
+bool MmapMapProvider::MapFile(const std::string &fileName, const Vector3S &size, bool create) {
+    LayerMapping mapping{};
+    if (!OpenFile(fileName, size, create, mapping))
+        return false;
+
+    LayerMapping old{};
+    {
+        std::unique_lock lock(m_mappingLock);
+        old = SetMapping(mapping, size);
+    }
+    CloseMapping(old);
+    return true;
+}
+
+void MmapMapProvider::UnmapFile() {
+    LayerMapping old{};
+    {
+        std::unique_lock lock(m_mappingLock);
+        old = SetMapping(LayerMapping { -1, nullptr, 0 }, m_size);
+    }
+    CloseMapping(old);
+}
+
+bool MmapMapProvider::ConvertFromGzip(const std::string &folder, const Vector3S &size) {
+    std::string rawName = folder + MMAP_MAP_BLOCKS_NAME;
+    std::string tempName = rawName + ".tmp";
+
+    LayerMapping converted{};
+    if (!OpenFile(tempName, size, true, converted))
+        return false;
+
+    uint64_t volume = GetVolume(size);
+    unsigned char* types = converted.Data + MMAP_PAGE_SIZE;
+    auto* lastPlayers = reinterpret_cast<short*>(converted.Data + GetLastPlayerOffset(volume));
+    uint64_t expectedSize = volume * 4;
+    uint64_t offset = 0;
+
+    auto sink = [&](const unsigned char* data, int len) {
+        for (int i = 0; i < len && offset < expectedSize; i++, offset++) {
+            uint64_t blockIndex = offset / 4;
+            switch (offset % 4) {
+                case 0:
+                    types[blockIndex] = data[i];
+                    break;
+                case 2:
+                    lastPlayers[blockIndex] = static_cast<short>(data[i] << 8);
+                    break;
+                case 3:
+                    lastPlayers[blockIndex] |= data[i];
+                    break;
+                default:
+                    break;
+            }
+        }
+    };
+
+    GZIP::GZip_DecompressFromFileStreamed(sink, folder + D3_MAP_BLOCKS_NAME);
+
+    if (offset < expectedSize) {
+        Logger::LogAdd(MODULE_NAME, "Error converting map [" + folder + D3_MAP_BLOCKS_NAME + "]!", L_ERROR, GLF);
+        CloseMapping(converted);
+        std::filesystem::remove(tempName);
+        return false;
+    }
+
+    msync(converted.Data, converted.Size, MS_SYNC);
+    std::error_code ec;
+    std::filesystem::rename(tempName, rawName, ec);
+
+    if (ec) {
+        Logger::LogAdd(MODULE_NAME, "Could not replace mapfile: " + ec.message(), LogType::L_ERROR, GLF);
+        CloseMapping(converted);
+        return false;
+    }
+
+    LayerMapping old{};
+    {
+        std::unique_lock lock(m_mappingLock);
+        old = SetMapping(converted, size);
+    }
+    CloseMapping(old);
+
+    Logger::LogAdd(MODULE_NAME, "Map converted [" + folder + D3_MAP_BLOCKS_NAME + " -> " + MMAP_MAP_BLOCKS_NAME + "]", LogType::NORMAL, GLF);
+    return true;
+}
+
+bool MmapMapProvider::ExportGzip(const std::string &folder) {
+    uint64_t volume = GetVolume(m_size);
+    uint64_t blockIndex = 0;
+
+    auto source = [&](unsigned char* buffer, int maxLen) {
+        std::shared_lock lock(m_mappingLock);
+        int written = 0;
+        while (written + 4 <= maxLen && blockIndex < volume && m_mapping != nullptr) {
+            short lastPlayer = m_lastPlayers[blockIndex];
+            buffer[written++] = m_types[blockIndex];
+            buffer[written++] = 0;
+            buffer[written++] = static_cast<unsigned char>((lastPlayer & 0xFF00) >> 8);
+            buffer[written++] = static_cast<unsigned char>(lastPlayer & 0xFF);
+            blockIndex++;
+        }
+        return written;
+    };
+
+    std::string fileName = folder + D3_MAP_BLOCKS_NAME;
+    if (!GZIP::GZip_CompressToFileParallel(static_cast<int64_t>(volume * 4), source, fileName + ".tmp"))
+        return false;
+
+    std::error_code ec;
+    std::filesystem::rename(fileName + ".tmp", fileName, ec);
+    if (ec) {
+        Logger::LogAdd(MODULE_NAME, "Could not replace mapfile: " + ec.message(), LogType::L_ERROR, GLF);
+        return false;
+    }
+
+    Logger::LogAdd(MODULE_NAME, "File saved [" + fileName + "]", LogType::NORMAL, GLF);
+    return true;
+}
+#endif
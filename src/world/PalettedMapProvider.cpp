@@ -0,0 +1,519 @@
+#include "world/PalettedMapProvider.h"
+
+#include <algorithm>
+#include <array>
+#include <filesystem>
+#include <mutex>
+#include "common/Logger.h"
+#include "compression.h"
+#include "Utils.h"
+
+using namespace D3PP::world;
+using namespace D3PP::Common;
+
+PalettedSection::PalettedSection(unsigned char fill) : m_palette{fill}, m_paletteCounts{PALETTED_SECTION_VOLUME} {
+    m_bitsPerIndex = 0;
+}
+
+unsigned char PalettedSection::Get(int localIndex) const {
+    if (m_bitsPerIndex == 0)
+        return m_palette[0];
+
+    return m_palette[GetPaletteIndex(localIndex)];
+}
+
+void PalettedSection::Set(int localIndex, unsigned char type) {
+    int current = (m_bitsPerIndex == 0) ? 0 : GetPaletteIndex(localIndex);
+
+    if (m_palette[current] == type)
+        return;
+
+    int target = -1;
+    int freeSlot = -1;
+    int paletteSize = static_cast<int>(m_palette.size());
+    for (int i = 0; i < paletteSize; i++) {
+        if (m_palette[i] == type) {
+            target = i;
+            break;
+        }
+        if (freeSlot == -1 && m_paletteCounts[i] == 0)
+            freeSlot = i;
+    }
+
+    if (target == -1 && freeSlot != -1) {
+        target = freeSlot;
+        m_palette[target] = type;
+    } else if (target == -1) {
+        m_palette.push_back(type);
+        m_paletteCounts.push_back(0);
+        target = paletteSize;
+
+        if (paletteSize + 1 > (1 << m_bitsPerIndex)) {
+            int newBits = (m_bitsPerIndex == 0) ? 1 : m_bitsPerIndex * 2;
+            while ((1 << newBits) < paletteSize + 1)
+                newBits *= 2;
+
+            Repack(newBits);
+        }
+    }
+
+    SetPaletteIndex(localIndex, target);
+    m_paletteCounts[current]--;
+    m_paletteCounts[target]++;
+
+    if (m_paletteCounts[target] == PALETTED_SECTION_VOLUME)
+        Collapse(type);
+}
+
+void PalettedSection::SetAll(const unsigned char *types) {
+    std::array<int, 256> counts{};
+    for (int i = 0; i < PALETTED_SECTION_VOLUME; i++)
+        counts[types[i]]++;
+
+    std::array<int, 256> lookup{};
+    m_palette.clear();
+    m_paletteCounts.clear();
+    for (int t = 0; t < 256; t++) {
+        if (counts[t] == 0)
+            continue;
+
+        lookup[t] = static_cast<int>(m_palette.size());
+        m_palette.push_back(static_cast<unsigned char>(t));
+        m_paletteCounts.push_back(static_cast<unsigned short>(counts[t]));
+    }
+
+    if (m_palette.size() == 1) {
+        Collapse(m_palette[0]);
+        return;
+    }
+
+    int bits = 1;
+    while ((1 << bits) < static_cast<int>(m_palette.size()))
+        bits *= 2;
+
+    m_bitsPerIndex = bits;
+    m_indices.assign((PALETTED_SECTION_VOLUME * bits) / 64, 0);
+    m_indices.shrink_to_fit();
+
+    for (int i = 0; i < PALETTED_SECTION_VOLUME; i++)
+        SetPaletteIndex(i, lookup[types[i]]);
+}
+
+size_t PalettedSection::MemoryUsage() const {
+    return sizeof(PalettedSection) + m_palette.capacity() + (m_paletteCounts.capacity() * sizeof(unsigned short)) + (m_indices.capacity() * sizeof(uint64_t));
+}
+
+int PalettedSection::GetPaletteIndex(int localIndex) const {
+    int perWord = 64 / m_bitsPerIndex;
+    uint64_t word = m_indices[localIndex / perWord];
+    int shift = (localIndex % perWord) * m_bitsPerIndex;
+
+    return static_cast<int>((word >> shift) & ((1ULL << m_bitsPerIndex) - 1));
+}
+
+void PalettedSection::SetPaletteIndex(int localIndex, int paletteIndex) {
+    int perWord = 64 / m_bitsPerIndex;
+    int shift = (localIndex % perWord) * m_bitsPerIndex;
+    uint64_t mask = ((1ULL << m_bitsPerIndex) - 1) << shift;
+    uint64_t& word = m_indices[localIndex / perWord];
+
+    word = (word & ~mask) | (static_cast<uint64_t>(paletteIndex) << shift);
+}
+
+void PalettedSection::Repack(int newBits) {
+    std::array<unsigned char, PALETTED_SECTION_VOLUME> current{};
+
+    if (m_bitsPerIndex != 0) {
+        for (int i = 0; i < PALETTED_SECTION_VOLUME; i++)
+            current[i] = static_cast<unsigned char>(GetPaletteIndex(i));
+    }
+
+    m_bitsPerIndex = newBits;
+    m_indices.assign((PALETTED_SECTION_VOLUME * newBits) / 64, 0);
+
+    for (int i = 0; i < PALETTED_SECTION_VOLUME; i++)
+        SetPaletteIndex(i, current[i]);
+}
+
+void PalettedSection::Collapse(unsigned char type) {
+    m_palette.assign(1, type);
+    m_paletteCounts.assign(1, PALETTED_SECTION_VOLUME);
+    m_indices.clear();
+    m_indices.shrink_to_fit();
+    m_bitsPerIndex = 0;
+}
+
+PalettedMapProvider::PalettedMapProvider() : D3MapProvider(), m_size{} {
+    m_sectionsX = 0;
+    m_sectionsY = 0;
+    m_sectionsZ = 0;
+    m_blocksChanged = false;
+}
+
+void PalettedMapProvider::CreateNew(const Vector3S &size, const std::string &path, const std::string &name) {
+    // -- Only the config side of the D3 map, the dense block planes are never allocated.
+    m_d3map = std::make_unique<files::D3Map>(path, name, size, true);
+    MapName = name;
+    m_currentPath = path;
+    auto defaultEnv = MapEnvironment();
+    defaultEnv.SideLevel = size.Z/2;
+    SetEnvironment(defaultEnv);
+    SetPermissions(MapPermissions {0, 0, 0});
+    {
+        std::unique_lock lock(m_sectionLock);
+        AllocateSections(size);
+    }
+
+    m_d3map->Save();
+    SaveBlockLayer(m_currentPath);
+}
+
+bool PalettedMapProvider::Save(const std::string &filePath) {
+    std::string folder = filePath.empty() ? m_currentPath : filePath;
+    if (!folder.empty() && folder[folder.size() - 1] != '/')
+        folder += "/";
+
+    bool result = D3MapProvider::Save(filePath);
+
+    if (result && (m_blocksChanged || !filePath.empty()))
+        result = SaveBlockLayer(folder);
+
+    return result;
+}
+
+bool PalettedMapProvider::Load(const std::string &filePath) {
+    if (m_d3map == nullptr) {
+        m_d3map = std::make_unique<files::D3Map>(filePath);
+        m_d3map->ExternalBlockLayer = true;
+        m_currentPath = filePath;
+    }
+
+    std::string folder = filePath.empty() ? m_currentPath : filePath;
+
+    if (!m_d3map->Load(folder))
+        return false;
+
+    if (filePath == m_currentPath)
+        MapName = m_d3map->Name;
+
+    if (folder[folder.size() - 1] != '/')
+        folder += "/";
+
+    return ReadBlockLayer(folder);
+}
+
+void PalettedMapProvider::SetSize(const Vector3S &newSize) {
+    std::vector<unsigned char> oldBlocks = GetBlocks();
+    std::unique_lock lock(m_sectionLock);
+    Vector3S oldSize = m_size;
+
+    m_d3map->Resize(newSize);
+    AllocateSections(newSize);
+    m_lastPlayers.clear();
+
+    for (int z = 0; z < std::min(oldSize.Z, newSize.Z); z++) {
+        for (int y = 0; y < std::min(oldSize.Y, newSize.Y); y++) {
+            for (int x = 0; x < std::min(oldSize.X, newSize.X); x++) {
+                unsigned char type = oldBlocks[x + static_cast<int64_t>(y) * oldSize.X + static_cast<int64_t>(z) * oldSize.X * oldSize.Y];
+                if (type != 0)
+                    m_sections[GetSectionIndex(x, y, z)].Set(GetLocalIndex(x, y, z), type);
+            }
+        }
+    }
+    m_blocksChanged = true;
+}
+
+bool PalettedMapProvider::Unload() {
+    std::unique_lock lock(m_sectionLock);
+    m_sections.clear();
+    m_sections.shrink_to_fit();
+    m_lastPlayers.clear();
+    return true;
+}
+
+void PalettedMapProvider::SetBlock(const Vector3S &location, const unsigned char &type) {
+    std::unique_lock lock(m_sectionLock);
+    if (!InBounds(location))
+        return;
+
+    m_sections[GetSectionIndex(location.X, location.Y, location.Z)].Set(GetLocalIndex(location.X, location.Y, location.Z), type);
+    m_blocksChanged = true;
+}
+
+unsigned char PalettedMapProvider::GetBlock(const Vector3S &location) {
+    std::shared_lock lock(m_sectionLock);
+    if (!InBounds(location))
+        return 0;
+
+    return m_sections[GetSectionIndex(location.X, location.Y, location.Z)].Get(GetLocalIndex(location.X, location.Y, location.Z));
+}
+
+short PalettedMapProvider::GetLastPlayer(const Vector3S &location) {
+    std::shared_lock lock(m_sectionLock);
+    if (!InBounds(location))
+        return -1;
+
+    auto it = m_lastPlayers.find(GetBlockIndex(location));
+    if (it == m_lastPlayers.end())
+        return 0;
+
+    return it->second;
+}
+
+void PalettedMapProvider::SetLastPlayer(const Vector3S &location, const short &player) {
+    std::unique_lock lock(m_sectionLock);
+    if (!InBounds(location))
+        return;
+
+    if (player == 0)
+        m_lastPlayers.erase(GetBlockIndex(location));
+    else
+        m_lastPlayers[GetBlockIndex(location)] = player;
+
+    m_blocksChanged = true;
+}
+
+void PalettedMapProvider::SetBlocks(const std::vector<unsigned char> &blocks) {
+    std::array<unsigned char, PALETTED_SECTION_VOLUME> local{};
+    std::unique_lock lock(m_sectionLock);
+
+    for (int sz = 0; sz < m_sectionsZ; sz++) {
+        for (int sy = 0; sy < m_sectionsY; sy++) {
+            for (int sx = 0; sx < m_sectionsX; sx++) {
+                for (int lz = 0; lz < PALETTED_SECTION_SIZE; lz++) {
+                    for (int ly = 0; ly < PALETTED_SECTION_SIZE; ly++) {
+                        for (int lx = 0; lx < PALETTED_SECTION_SIZE; lx++) {
+                            int x = sx * PALETTED_SECTION_SIZE + lx;
+                            int y = sy * PALETTED_SECTION_SIZE + ly;
+                            int z = sz * PALETTED_SECTION_SIZE + lz;
+                            int64_t index = x + static_cast<int64_t>(y) * m_size.X + static_cast<int64_t>(z) * m_size.X * m_size.Y;
+                            bool inMap = (x < m_size.X && y < m_size.Y && z < m_size.Z && index < static_cast<int64_t>(blocks.size()));
+
+                            local[GetLocalIndex(lx, ly, lz)] = inMap ? blocks[index] : 0;
+                        }
+                    }
+                }
+                m_sections[sx + static_cast<int64_t>(sy) * m_sectionsX + static_cast<int64_t>(sz) * m_sectionsX * m_sectionsY].SetAll(local.data());
+            }
+        }
+    }
+
+    m_lastPlayers.clear();
+    m_blocksChanged = true;
+}
+
+std::vector<unsigned char> PalettedMapProvider::GetBlocks() {
+    std::shared_lock lock(m_sectionLock);
+    std::vector<unsigned char> result(static_cast<int64_t>(m_size.X) * m_size.Y * m_size.Z);
+
+    if (m_sections.empty())
+        return result;
+
+    for (int z = 0; z < m_size.Z; z++) {
+        for (int y = 0; y < m_size.Y; y++) {
+            int64_t rowOffset = static_cast<int64_t>(y) * m_size.X + static_cast<int64_t>(z) * m_size.X * m_size.Y;
+            for (int x = 0; x < m_size.X; x++) {
+                const PalettedSection& section = m_sections[GetSectionIndex(x, y, z)];
+                result[rowOffset + x] = section.Get(GetLocalIndex(x, y, z));
+            }
+        }
+    }
+
+    return result;
+}
+
+bool PalettedMapProvider::ReadBlocks(int64_t offset, unsigned char* output, int64_t count) {
+    std::shared_lock lock(m_sectionLock);
+    int64_t layer = static_cast<int64_t>(m_size.X) * m_size.Y;
+    if (offset < 0 || count < 0 || m_size.X <= 0 || offset + count > layer * m_size.Z)
+        return false;
+
+    if (m_sections.empty()) {
+        std::fill_n(output, count, 0);
+        return true;
+    }
+
+    int x = static_cast<int>(offset % m_size.X);
+    int y = static_cast<int>((offset / m_size.X) % m_size.Y);
+    int z = static_cast<int>(offset / layer);
+
+    for (int64_t i = 0; i < count; i++) {
+        output[i] = m_sections[GetSectionIndex(x, y, z)].Get(GetLocalIndex(x, y, z));
+        if (++x == m_size.X) {
+            x = 0;
+            if (++y == m_size.Y) {
+                y = 0;
+                z++;
+            }
+        }
+    }
+
+    return true;
+}
+
+size_t PalettedMapProvider::MemoryUsage() const {
+    std::shared_lock lock(m_sectionLock);
+    size_t result = m_lastPlayers.size() * (sizeof(int) + sizeof(short));
+
+    for (const auto& section : m_sections)
+        result += section.MemoryUsage();
+
+    return result;
+}
+
+void PalettedMapProvider::AllocateSections(const Vector3S &size) {
+    m_size = size;
+    m_sectionsX = (size.X + PALETTED_SECTION_SIZE - 1) / PALETTED_SECTION_SIZE;
+    m_sectionsY = (size.Y + PALETTED_SECTION_SIZE - 1) / PALETTED_SECTION_SIZE;
+    m_sectionsZ = (size.Z + PALETTED_SECTION_SIZE - 1) / PALETTED_SECTION_SIZE;
+    m_sections.assign(static_cast<size_t>(m_sectionsX) * m_sectionsY * m_sectionsZ, PalettedSection(0));
+}
+
+bool PalettedMapProvider::InBounds(const Vector3S &location) const {
+    return (!m_sections.empty() && location.X >= 0 && location.X < m_size.X && location.Y >= 0 && location.Y < m_size.Y && location.Z >= 0 && location.Z < m_size.Z);
+}
+
+int64_t PalettedMapProvider::GetSectionIndex(int x, int y, int z) const {
+    return (x / PALETTED_SECTION_SIZE) + static_cast<int64_t>(y / PALETTED_SECTION_SIZE) * m_sectionsX + static_cast<int64_t>(z / PALETTED_SECTION_SIZE) * m_sectionsX * m_sectionsY;
+}
+
+int64_t PalettedMapProvider::GetBlockIndex(const Vector3S &location) const {
+    return location.X + static_cast<int64_t>(location.Y) * m_size.X + static_cast<int64_t>(location.Z) * m_size.X * m_size.Y;
+}
+
+int PalettedMapProvider::GetLocalIndex(int x, int y, int z) {
+    return (x % PALETTED_SECTION_SIZE) + (y % PALETTED_SECTION_SIZE) * PALETTED_SECTION_SIZE + (z % PALETTED_SECTION_SIZE) * PALETTED_SECTION_SIZE * PALETTED_SECTION_SIZE;
+}
+
+bool PalettedMapProvider::ReadBlockLayer(const std::string &folder) {
+    std::unique_lock lock(m_sectionLock);
+    AllocateSections(m_d3map->MapSize);
+    m_lastPlayers.clear();
+
+    int64_t layerVolume = static_cast<int64_t>(m_size.X) * m_size.Y;
+    int64_t slabVolume = layerVolume * PALETTED_SECTION_SIZE;
+    int64_t expectedSize = layerVolume * m_size.Z * 4;
+    std::vector<unsigned char> slab(slabVolume);
+    std::array<unsigned char, PALETTED_SECTION_VOLUME> local{};
+    int sectionZ = 0;
+    int64_t offset = 0;
+    short lastPlayer = 0;
+
+    // -- The layer arrives in X, Y, Z order; buffer 16 Z-layers at a time and turn them into one row of sections.
+    auto flushSlab = [&](int layers) {
+        for (int sy = 0; sy < m_sectionsY; sy++) {
+            for (int sx = 0; sx < m_sectionsX; sx++) {
+                for (int lz = 0; lz < PALETTED_SECTION_SIZE; lz++) {
+                    for (int ly = 0; ly < PALETTED_SECTION_SIZE; ly++) {
+                        for (int lx = 0; lx < PALETTED_SECTION_SIZE; lx++) {
+                            int x = sx * PALETTED_SECTION_SIZE + lx;
+                            int y = sy * PALETTED_SECTION_SIZE + ly;
+                            bool inMap = (x < m_size.X && y < m_size.Y && lz < layers);
+
+                            local[GetLocalIndex(lx, ly, lz)] = inMap ? slab[x + static_cast<int64_t>(y) * m_size.X + lz * layerVolume] : 0;
+                        }
+                    }
+                }
+                m_sections[sx + static_cast<int64_t>(sy) * m_sectionsX + static_cast<int64_t>(sectionZ) * m_sectionsX * m_sectionsY].SetAll(local.data());
+            }
+        }
+        sectionZ++;
+        std::fill(slab.begin(), slab.end(), 0);
+    };
+
+    auto sink = [&](const unsigned char* data, int len) {
+        for (int i = 0; i < len && offset < expectedSize; i++, offset++) {
+            int64_t blockIndex = offset / 4;
+            switch (offset % 4) {
+                case 0:
+                    slab[blockIndex - sectionZ * slabVolume] = data[i];
+                    break;
+                case 1:
+                    break;
+                case 2:
+                    lastPlayer = static_cast<short>(data[i] << 8);
+                    break;
+                case 3:
+                    lastPlayer |= data[i];
+                    if (lastPlayer != 0)
+                        m_lastPlayers[blockIndex] = lastPlayer;
+
+                    if ((blockIndex + 1) % slabVolume == 0)
+                        flushSlab(PALETTED_SECTION_SIZE);
+                    break;
+            }
+        }
+    };
+
+    int64_t dSize = GZIP::GZip_DecompressFromFileStreamed(sink, folder + D3_MAP_BLOCKS_NAME);
+
+    if (dSize < expectedSize) {
+        Logger::LogAdd("PalettedMap", "Error loading map [" + folder + D3_MAP_BLOCKS_NAME + "]!", L_ERROR, GLF);
+        return false;
+    }
+
+    if (sectionZ < m_sectionsZ)
+        flushSlab(m_size.Z - sectionZ * PALETTED_SECTION_SIZE);
+
+    m_blocksChanged = false;
+    lock.unlock();
+    Logger::LogAdd("PalettedMap", "Map Loaded [" + folder + D3_MAP_BLOCKS_NAME + "] (" + stringulate(MemoryUsage() / 1024) + " KiB in memory)", LogType::NORMAL, GLF);
+    return true;
+}
+
+bool PalettedMapProvider::SaveBlockLayer(const std::string &folder) {
+    int64_t mapVolume = static_cast<int64_t>(m_size.X) * m_size.Y * m_size.Z;
+    int64_t blockIndex = 0;
+    int x = 0, y = 0, z = 0;
+
+    // -- Locked per buffer rather than for the whole file, so block changes keep going while the layer compresses.
+    auto source = [&](unsigned char* buffer, int maxLen) {
+        std::shared_lock lock(m_sectionLock);
+        int written = 0;
+        while (written + 4 <= maxLen && blockIndex < mapVolume) {
+            auto it = m_lastPlayers.find(blockIndex);
+            short lastPlayer = (it == m_lastPlayers.end()) ? 0 : it->second;
+            buffer[written++] = m_sections[GetSectionIndex(x, y, z)].Get(GetLocalIndex(x, y, z));
+            buffer[written++] = 0;
+            buffer[written++] = static_cast<unsigned char>((lastPlayer & 0xFF00) >> 8);
+            buffer[written++] = static_cast<unsigned char>(lastPlayer & 0xFF);
+            blockIndex++;
+
+            if (++x == m_size.X) {
+                x = 0;
+                if (++y == m_size.Y) {
+                    y = 0;
+                    z++;
+                }
+            }
+        }
+        return written;
+    };
+
+    {
+        std::shared_lock lock(m_sectionLock);
+        if (m_sections.empty())
+            return false;
+        // -- Cleared before anything is read, so a change landing behind the reader marks the layer dirty again.
+        m_blocksChanged = false;
+    }
+
+    std::string fileName = folder + D3_MAP_BLOCKS_NAME;
+    std::string tempName = fileName + ".tmp";
+
+    if (!GZIP::GZip_CompressToFileParallel(mapVolume * 4, source, tempName)) {
+        m_blocksChanged = true;
+        return false;
+    }
+
+    try {
+        std::filesystem::rename(tempName, fileName);
+    } catch (std::filesystem::filesystem_error& e) {
+        Logger::LogAdd("PalettedMap", "Could not replace mapfile: " + stringulate(e.what()), LogType::L_ERROR, GLF);
+        m_blocksChanged = true;
+        return false;
+    }
+
+    Logger::LogAdd("PalettedMap", "File saved [" + fileName + "]", LogType::NORMAL, GLF);
+    return true;
+}
@@ -13,6 +13,9 @@ using namespace D3PP::world;
 /* Block falls straight down */
 void Physics::BlockPhysics10(std::shared_ptr<Map> physMap, int x, int y, int z) {
     int currentBlock = physMap->GetBlockType(x, y, z);
+    // -- Unloaded maps skip the tick; a neighbour read as not loaded never equals air, so nothing moves into it.
+    if (currentBlock == MAP_BLOCK_NOT_LOADED)
+        return;
     if (physMap->GetBlockType(x, y, z-1) == 0) {
         physMap->BlockMove(x, y, z, x, y, z-1, true, true, 1);
     }
@@ -21,6 +24,8 @@ void Physics::BlockPhysics10(std::shared_ptr<Map> physMap, int x, int y, int z)
 /* Block falls in 45 degree bevels (builds a pyramid) */
 void Physics::BlockPhysics11(std::shared_ptr<Map> physMap, int x, int y, int z) {
     int currentBlock = physMap->GetBlockType(x, y, z);
+    if (currentBlock == MAP_BLOCK_NOT_LOADED)
+        return;
     int blockBelow = physMap->GetBlockType(x, y, z-1);
 
     int blockBelowRight = physMap->GetBlockType(x+1,y,z-1);
@@ -51,6 +56,8 @@ void Physics::BlockPhysics11(std::shared_ptr<Map> physMap, int x, int y, int z)
 /* Minecraft original fluid physics (Block duplicates laterally and downwardly) */
 void Physics::BlockPhysics20(std::shared_ptr<Map> physMap, int x, int y, int z) {
     int currentBlock = physMap->GetBlockType(x, y, z);
+    if (currentBlock == MAP_BLOCK_NOT_LOADED)
+        return;
     unsigned short blockPlayer = physMap->GetBlockPlayer(x, y, z);
     int blockBelow = physMap->GetBlockType(x, y, z-1);
     int blockRight = physMap->GetBlockType(x+1, y, z);
@@ -78,6 +85,8 @@ void Physics::BlockPhysics21(std::shared_ptr<Map> physMap, int x, int y, int z)
     }
 
    int currentBlock = physMap->GetBlockType(x, y, z);
+   if (currentBlock == MAP_BLOCK_NOT_LOADED)
+       return;
    int blockBelow = physMap->GetBlockType(x, y, z-1);
 
    if (blockBelow == 0) {